@@ -0,0 +1,222 @@
+//
+//  bench_frontend.c
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tora.h"
+
+// Measures front-end throughput over a TORA source: loading, lexing (serial and
+// parallel), parsing, optimising, flattening, and the streaming lexer feeding the parser
+// directly. Each phase is run several times and the best time reported, along with how many
+// allocations it made per token (or per AST node for the parser).
+//
+// Usage: bench_frontend [--iterations n] source.tora
+
+typedef struct {
+    const char *name;
+    double seconds;
+    uint64_t allocations;
+} TORABenchResult;
+
+double bench_now(void);
+void bench_report(TORABenchResult *result, uint64_t bytes, uint64_t tokens, uint64_t nodes, bool per_node);
+
+int main(int argc, const char * argv[])
+{
+    const char *filename = NULL;
+    int iterations = 5;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            iterations = atoi(argv[++i]);
+        }
+        else
+        {
+            filename = argv[i];
+        }
+    }
+    
+    if(!filename || iterations < 1)
+    {
+        fprintf(stderr, "Usage: bench_frontend [--iterations n] source.tora\n");
+        return 1;
+    }
+    
+    int status = 0;
+    try
+    {
+        if(!tora_init())
+        {
+            TORA_RUNTIME_EXCEPTION("Failed to initialise parser!");
+        }
+        
+        TORABenchResult load = { "load", 1e9, 0 };
+        TORABenchResult lex = { "lex (serial)", 1e9, 0 };
+        TORABenchResult lex_parallel = { "lex (parallel)", 1e9, 0 };
+        TORABenchResult parse = { "parse", 1e9, 0 };
+        TORABenchResult optimise = { "optimise", 1e9, 0 };
+        TORABenchResult flatten = { "flatten", 1e9, 0 };
+        TORABenchResult streaming = { "front end (streaming)", 1e9, 0 };
+        TORABenchResult lazy = { "front end (lazy functions)", 1e9, 0 };
+        
+        uint64_t bytes = 0, tokens = 0, nodes = 0, tree_bytes = 0, flat_bytes = 0;
+        for(int i = 0; i < iterations; i++)
+        {
+            // Loading, lexing and parsing from a buffered token stream, timed separately
+            int mallocs = num_malloc;
+            double start = bench_now();
+            TORAInputStream *input_stream = input_stream_from_file_contents(filename);
+            if(!input_stream)
+            {
+                TORA_RUNTIME_EXCEPTION("Failed to open %s", filename);
+            }
+            double loaded = bench_now();
+            int loaded_mallocs = num_malloc;
+            
+            TORATokenStream *token_stream = token_stream_buffered_from_input(input_stream);
+            double lexed = bench_now();
+            int lexed_mallocs = num_malloc;
+            
+            TORAArena *arena = arena_create();
+            TORAParserProgExpression *prog = parse_top_level(token_stream, arena, false);
+            double parsed = bench_now();
+            int parsed_mallocs = num_malloc;
+            
+            TORAParserExpressionList *constants = prog ? optimise_program(prog, arena) : NULL;
+            double optimised = bench_now();
+            int optimised_mallocs = num_malloc;
+            
+            TORAFlatProgram *program = prog ? flat_program_from_expression(prog, constants) : NULL;
+            double flattened = bench_now();
+            
+            if(loaded - start < load.seconds) load.seconds = loaded - start;
+            if(lexed - loaded < lex.seconds) lex.seconds = lexed - loaded;
+            if(parsed - lexed < parse.seconds) parse.seconds = parsed - lexed;
+            if(optimised - parsed < optimise.seconds) optimise.seconds = optimised - parsed;
+            if(flattened - optimised < flatten.seconds) flatten.seconds = flattened - optimised;
+            load.allocations = (uint64_t)(loaded_mallocs - mallocs);
+            lex.allocations = (uint64_t)(lexed_mallocs - loaded_mallocs);
+            parse.allocations = (uint64_t)(parsed_mallocs - lexed_mallocs);
+            optimise.allocations = (uint64_t)(optimised_mallocs - parsed_mallocs);
+            flatten.allocations = (uint64_t)(num_malloc - optimised_mallocs);
+            
+            bytes = input_stream->length;
+            tokens = token_stream->num_tokens;
+            nodes = program ? program->num_nodes : 0;
+            tree_bytes = arena->bytes_allocated;
+            flat_bytes = program ? flat_program_size(program) : 0;
+            
+            free_flat_program(program);
+            free_arena(arena);
+            free_token_stream(token_stream);
+            free_input_stream(input_stream);
+            
+            // Lexing across every core
+            input_stream = input_stream_from_file_contents(filename);
+            mallocs = num_malloc;
+            start = bench_now();
+            token_stream = token_stream_parallel_from_input(input_stream, 0);
+            lexed = bench_now();
+            
+            if(lexed - start < lex_parallel.seconds) lex_parallel.seconds = lexed - start;
+            lex_parallel.allocations = (uint64_t)(num_malloc - mallocs);
+            
+            free_token_stream(token_stream);
+            free_input_stream(input_stream);
+            
+            // The parser pulling tokens from the lexer as it goes
+            input_stream = input_stream_from_file_contents(filename);
+            mallocs = num_malloc;
+            start = bench_now();
+            token_stream = token_stream_from_input(input_stream);
+            program = parse_program(token_stream, false);
+            parsed = bench_now();
+            
+            if(parsed - start < streaming.seconds) streaming.seconds = parsed - start;
+            streaming.allocations = (uint64_t)(num_malloc - mallocs);
+            
+            free_flat_program(program);
+            free_token_stream(token_stream);
+            free_input_stream(input_stream);
+            
+            // Skipping the bodies of top-level functions, as tora does by default
+            input_stream = input_stream_from_file_contents(filename);
+            mallocs = num_malloc;
+            start = bench_now();
+            token_stream = token_stream_buffered_from_input(input_stream);
+            program = parse_program(token_stream, true);
+            parsed = bench_now();
+            
+            if(parsed - start < lazy.seconds) lazy.seconds = parsed - start;
+            lazy.allocations = (uint64_t)(num_malloc - mallocs);
+            
+            free_flat_program(program);
+            free_token_stream(token_stream);
+            free_input_stream(input_stream);
+        }
+        
+        printf("%s: %.2f MB, %llu tokens, %llu AST nodes, best of %d\n\n", filename, bytes / (1024.0 * 1024.0),
+               (unsigned long long)tokens, (unsigned long long)nodes, iterations);
+        printf("%-30s %10s %10s %12s %12s %14s\n", "phase", "ms", "MB/s", "Mtokens/s", "Mnodes/s", "allocs/unit");
+        bench_report(&load, bytes, tokens, nodes, false);
+        bench_report(&lex, bytes, tokens, nodes, false);
+        bench_report(&lex_parallel, bytes, tokens, nodes, false);
+        bench_report(&parse, bytes, tokens, nodes, true);
+        bench_report(&optimise, bytes, tokens, nodes, true);
+        bench_report(&flatten, bytes, tokens, nodes, true);
+        bench_report(&streaming, bytes, tokens, nodes, true);
+        bench_report(&lazy, bytes, tokens, nodes, true);
+        
+        printf("\nAST size: %.2f MB as a tree, %.2f MB flattened\n", tree_bytes / (1024.0 * 1024.0), flat_bytes / (1024.0 * 1024.0));
+        
+        if(num_malloc != num_free)
+        {
+            printf("\nNum malloc'd blocks: %i, num freed: %i, lost: %i\n", num_malloc, num_free, num_malloc-num_free);
+        }
+        
+        tora_shutdown();
+    }
+    catch(ParserException)
+    {
+        printf("Parser Exception: \"%s\"\n\tfile: %s\n\tline: %d\n", e4c.err.message, e4c.err.file, e4c.err.line);
+        status = 1;
+    }
+    catch(RuntimeException)
+    {
+        printf("Runtime Exception: \"%s\"\n\tfile: %s\n\tline: %d\n", e4c.err.message, e4c.err.file, e4c.err.line);
+        status = 1;
+    }
+    
+    return status;
+}
+
+// Reporting
+double bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+// Allocations are reported per token for the loading and lexing phases, and per
+// AST node for anything which includes parsing
+void bench_report(TORABenchResult *result, uint64_t bytes, uint64_t tokens, uint64_t nodes, bool per_node)
+{
+    double seconds = result->seconds > 0 ? result->seconds : 1e-9;
+    uint64_t units = per_node ? nodes : tokens;
+    
+    printf("%-30s %10.2f %10.1f %12.2f %12.2f %10.3f/%s\n", result->name, seconds * 1000.0,
+           bytes / (1024.0 * 1024.0) / seconds,
+           tokens / 1e6 / seconds,
+           per_node ? nodes / 1e6 / seconds : 0.0,
+           units ? (double)result->allocations / (double)units : 0.0,
+           per_node ? "node" : "tok");
+}
@@ -0,0 +1,193 @@
+//
+//  gen_source.c
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+// Generates a synthetic TORA program of roughly the requested size for front-end
+// benchmarking. The output only needs to lex and parse, not to run, and mixes
+// everything our real scripts lean on: functions with deeply nested expressions,
+// large array literals, long (sometimes escaped) strings and comment blocks.
+//
+// Usage: gen_source <megabytes> [seed] > source.tora
+
+void emit_expression(FILE *out, int depth);
+void emit_function(FILE *out, unsigned long index);
+void emit_array(FILE *out, unsigned long index);
+void emit_string(FILE *out, unsigned long index);
+void emit_comments(FILE *out);
+
+static const char *binary_operators[] = { "+", "-", "*", "/", "%", "<", ">", "<=", ">=", "==", "!=", "&&", "||" };
+#define NUM_BINARY_OPERATORS (sizeof(binary_operators) / sizeof(binary_operators[0]))
+
+int main(int argc, const char * argv[])
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, "Usage: gen_source <megabytes> [seed]\n");
+        return 1;
+    }
+    
+    double megabytes = atof(argv[1]);
+    srand(argc > 2 ? (unsigned int)atoi(argv[2]) : 1);
+    
+    long target = (long)(megabytes * 1024 * 1024);
+    unsigned long index = 0;
+    while(ftell(stdout) < target)
+    {
+        switch(rand() % 8)
+        {
+            case 0:
+            case 1:
+            case 2:
+                emit_function(stdout, index);
+                break;
+            case 3:
+            case 4:
+                emit_array(stdout, index);
+                break;
+            case 5:
+                emit_string(stdout, index);
+                break;
+            case 6:
+                emit_comments(stdout);
+                break;
+            default:
+                printf("value_%lu = ", index);
+                emit_expression(stdout, 6);
+                printf(";\n");
+                break;
+        }
+        index++;
+    }
+    
+    return 0;
+}
+
+// Emitters
+void emit_expression(FILE *out, int depth)
+{
+    int choice = depth > 0 ? rand() % 6 : rand() % 3;
+    switch(choice)
+    {
+        case 0:
+            fprintf(out, "%d", rand() % 100000);
+            break;
+        case 1:
+            fprintf(out, "%d.%03d", rand() % 1000, rand() % 1000);
+            break;
+        case 2:
+            fprintf(out, "local_%d", rand() % 16);
+            break;
+        case 3:
+            fprintf(out, "(");
+            emit_expression(out, depth - 1);
+            fprintf(out, ")");
+            break;
+        case 4:
+            fprintf(out, "min(");
+            emit_expression(out, depth - 1);
+            fprintf(out, ", ");
+            emit_expression(out, depth - 1);
+            fprintf(out, ")");
+            break;
+        default:
+            emit_expression(out, depth - 1);
+            fprintf(out, " %s ", binary_operators[rand() % NUM_BINARY_OPERATORS]);
+            emit_expression(out, depth - 1);
+            break;
+    }
+}
+void emit_function(FILE *out, unsigned long index)
+{
+    fprintf(out, "func function_%lu(local_0, local_1, local_2)\n{\n", index);
+    
+    int statements = 2 + rand() % 8;
+    for(int i = 0; i < statements; i++)
+    {
+        switch(rand() % 3)
+        {
+            case 0:
+                fprintf(out, "    local_%d = ", 3 + rand() % 13);
+                emit_expression(out, 8);
+                fprintf(out, ";\n");
+                break;
+            case 1:
+                fprintf(out, "    if(");
+                emit_expression(out, 3);
+                fprintf(out, ")\n    {\n        local_3 = ");
+                emit_expression(out, 4);
+                fprintf(out, ";\n    }\n    else\n    {\n        local_4 = -local_%d;\n    }\n", rand() % 16);
+                break;
+            default:
+                fprintf(out, "    while(local_5 < %d)\n    {\n        local_5 = local_5 + 1;\n    }\n", rand() % 100);
+                break;
+        }
+    }
+    
+    fprintf(out, "    return ");
+    emit_expression(out, 5);
+    fprintf(out, ";\n}\n");
+}
+void emit_array(FILE *out, unsigned long index)
+{
+    fprintf(out, "table_%lu = [", index);
+    
+    int entries = 16 + rand() % 256;
+    bool associative = rand() % 2;
+    for(int i = 0; i < entries; i++)
+    {
+        if(i > 0) fprintf(out, ", ");
+        if(i % 12 == 11) fprintf(out, "\n    ");
+        
+        if(associative)
+        {
+            fprintf(out, "\"key_%d\": ", i);
+        }
+        if(rand() % 4 == 0)
+        {
+            fprintf(out, "[%d, %d.5, \"nested\"]", rand() % 1000, rand() % 1000);
+        }
+        else
+        {
+            fprintf(out, "%d.%d", rand() % 100000, rand() % 100);
+        }
+    }
+    
+    fprintf(out, "];\n");
+}
+void emit_string(FILE *out, unsigned long index)
+{
+    static const char *words[] = { "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit" };
+    
+    fprintf(out, "text_%lu = \"", index);
+    int length = 64 + rand() % 4096;
+    bool escaped = rand() % 4 == 0;
+    for(int written = 0; written < length;)
+    {
+        const char *word = words[rand() % 8];
+        fprintf(out, "%s ", word);
+        written += (int)strlen(word) + 1;
+        
+        if(escaped && rand() % 16 == 0)
+        {
+            fprintf(out, "\\\"quoted\\\" ");
+        }
+    }
+    fprintf(out, "\";\n");
+}
+void emit_comments(FILE *out)
+{
+    int lines = 1 + rand() % 12;
+    for(int i = 0; i < lines; i++)
+    {
+        fprintf(out, "# Comment line %d with \"quotes\", punctuation; and [brackets] = ignored\n", i);
+    }
+}
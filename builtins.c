@@ -0,0 +1,163 @@
+//
+//  builtins.c
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "tora.h"
+
+// Math functions
+void *builtin_sin(TORAParserUnknownExpression **arguments, uint32_t num_arguments);
+void *builtin_cos(TORAParserUnknownExpression **arguments, uint32_t num_arguments);
+void *builtin_tan(TORAParserUnknownExpression **arguments, uint32_t num_arguments);
+void *builtin_atan(TORAParserUnknownExpression **arguments, uint32_t num_arguments);
+void *builtin_log(TORAParserUnknownExpression **arguments, uint32_t num_arguments);
+void *builtin_exp(TORAParserUnknownExpression **arguments, uint32_t num_arguments);
+void *builtin_round(TORAParserUnknownExpression **arguments, uint32_t num_arguments);
+void *builtin_min(TORAParserUnknownExpression **arguments, uint32_t num_arguments);
+void *builtin_max(TORAParserUnknownExpression **arguments, uint32_t num_arguments);
+
+// Collection functions
+void *builtin_length(TORAParserUnknownExpression **arguments, uint32_t num_arguments);
+
+// Logging functions
+void *builtin_print(TORAParserUnknownExpression **arguments, uint32_t num_arguments);
+void *builtin_println(TORAParserUnknownExpression **arguments, uint32_t num_arguments);
+
+// Each builtin sits in the slot given by TORA_BUILTIN_HASH, and every other slot is empty
+const TORABuiltin tora_builtins[TORA_BUILTIN_TABLE_SIZE] = {
+    [1]  = { "print", 5, 1, false, builtin_print },
+    [2]  = { "max", 3, 2, true, builtin_max },
+    [4]  = { "sin", 3, 1, true, builtin_sin },
+    [5]  = { "tan", 3, 1, true, builtin_tan },
+    [7]  = { "println", 7, 1, false, builtin_println },
+    [8]  = { "exp", 3, 1, true, builtin_exp },
+    [9]  = { "atan", 4, 1, true, builtin_atan },
+    [10] = { "cos", 3, 1, true, builtin_cos },
+    [11] = { "log", 3, 1, true, builtin_log },
+    [12] = { "length", 6, 1, false, builtin_length },
+    [13] = { "round", 5, 1, true, builtin_round },
+    [14] = { "min", 3, 2, true, builtin_min }
+};
+
+const TORABuiltin *builtin_lookup(const char *name, size_t length)
+{
+    // Our builtins are all between 3 and 7 characters long, so anything else can
+    // be ruled out before hashing. Any candidate only ever needs one comparison
+    if(length < 3 || length > 7)
+    {
+        return NULL;
+    }
+    
+    const TORABuiltin *builtin = &tora_builtins[TORA_BUILTIN_HASH(name, length)];
+    if(builtin->length == length && memcmp(builtin->name, name, length) == 0)
+    {
+        return builtin;
+    }
+    return NULL;
+}
+void builtin_check_arguments(const TORABuiltin *builtin, uint32_t num_arguments)
+{
+    if(num_arguments < builtin->num_arguments)
+    {
+        TORA_INTERPRETTER_EXCEPTION("%s expects %u arguments, but was called with %u", builtin->name, builtin->num_arguments, num_arguments);
+    }
+}
+
+// Math functions
+void *builtin_sin(TORAParserUnknownExpression **arguments, uint32_t num_arguments)
+{
+    TORA_UNUSED(num_arguments);
+    return new_numeric_expression(sin(((TORAParserNumericExpression *)arguments[0])->val));
+}
+void *builtin_cos(TORAParserUnknownExpression **arguments, uint32_t num_arguments)
+{
+    TORA_UNUSED(num_arguments);
+    return new_numeric_expression(cos(((TORAParserNumericExpression *)arguments[0])->val));
+}
+void *builtin_tan(TORAParserUnknownExpression **arguments, uint32_t num_arguments)
+{
+    TORA_UNUSED(num_arguments);
+    return new_numeric_expression(tan(((TORAParserNumericExpression *)arguments[0])->val));
+}
+void *builtin_atan(TORAParserUnknownExpression **arguments, uint32_t num_arguments)
+{
+    TORA_UNUSED(num_arguments);
+    return new_numeric_expression(atan(((TORAParserNumericExpression *)arguments[0])->val));
+}
+void *builtin_log(TORAParserUnknownExpression **arguments, uint32_t num_arguments)
+{
+    TORA_UNUSED(num_arguments);
+    return new_numeric_expression(log(((TORAParserNumericExpression *)arguments[0])->val));
+}
+void *builtin_exp(TORAParserUnknownExpression **arguments, uint32_t num_arguments)
+{
+    TORA_UNUSED(num_arguments);
+    return new_numeric_expression(exp(((TORAParserNumericExpression *)arguments[0])->val));
+}
+void *builtin_round(TORAParserUnknownExpression **arguments, uint32_t num_arguments)
+{
+    TORA_UNUSED(num_arguments);
+    return new_numeric_expression(round(((TORAParserNumericExpression *)arguments[0])->val));
+}
+void *builtin_min(TORAParserUnknownExpression **arguments, uint32_t num_arguments)
+{
+    TORA_UNUSED(num_arguments);
+    TORAParserNumericExpression *a = (TORAParserNumericExpression *)arguments[0];
+    TORAParserNumericExpression *b = (TORAParserNumericExpression *)arguments[1];
+    return new_numeric_expression(fmin(a->val, b->val));
+}
+void *builtin_max(TORAParserUnknownExpression **arguments, uint32_t num_arguments)
+{
+    TORA_UNUSED(num_arguments);
+    TORAParserNumericExpression *a = (TORAParserNumericExpression *)arguments[0];
+    TORAParserNumericExpression *b = (TORAParserNumericExpression *)arguments[1];
+    return new_numeric_expression(fmax(a->val, b->val));
+}
+
+// Collection functions
+void *builtin_length(TORAParserUnknownExpression **arguments, uint32_t num_arguments)
+{
+    TORA_UNUSED(num_arguments);
+    TORAParserArrayExpression *array_expression = (TORAParserArrayExpression *)arguments[0];
+    if(!array_expression || array_expression->type != TORAExpressionTypeArray)
+    {
+        TORA_INTERPRETTER_EXCEPTION("Unable to determine collection length for invalid type: %i", array_expression ? (int)array_expression->type : -1);
+    }
+    
+    return new_numeric_expression(linked_list_length(array_expression->val));
+}
+
+// Logging functions
+void *builtin_print(TORAParserUnknownExpression **arguments, uint32_t num_arguments)
+{
+    TORA_UNUSED(num_arguments);
+    TORAParserStringExpression *string_expression = (TORAParserStringExpression *)arguments[0];
+    if(string_expression && string_expression->type == TORAExpressionTypeString)
+    {
+        printf("%s", string_expression->val);
+    }
+    return NULL;
+}
+void *builtin_println(TORAParserUnknownExpression **arguments, uint32_t num_arguments)
+{
+    TORA_UNUSED(num_arguments);
+    TORAParserUnknownExpression *expression = arguments[0];
+    if(expression)
+    {
+        TORAParserStringExpression *string_expression = string_representation_for_expression(expression);
+        if(string_expression)
+        {
+            printf("%s\n", string_expression->val);
+            
+            queue_raw_item(&interpretter_queue, NULL, string_expression);
+        }
+    }
+    return NULL;
+}
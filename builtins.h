@@ -0,0 +1,43 @@
+//
+//  builtins.h
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#ifndef builtins_h
+#define builtins_h
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "parser.h"
+
+// Builtins are found with a perfect hash of their length and first, second and
+// last characters, giving each of them its own slot in tora_builtins
+#define TORA_BUILTIN_TABLE_SIZE 16
+#define TORA_BUILTIN_HASH(str, length) (((length) + (unsigned char)(str)[0] + 2 * (unsigned char)(str)[1] + 2 * (unsigned char)(str)[(length) - 1]) & (TORA_BUILTIN_TABLE_SIZE - 1))
+
+// Builtins are handed their arguments already evaluated, and at least num_arguments
+// of them. Any value they return is new, and it's up to the caller to queue it
+typedef void *(*TORABuiltinFunction)(TORAParserUnknownExpression **arguments, uint32_t num_arguments);
+
+struct TORABuiltin {
+    const char *name;
+    size_t length;
+    uint32_t num_arguments;
+    
+    // Pure builtins take numbers, return a number and do nothing else, so can be
+    // called before the program is run when their arguments are all literals
+    bool pure;
+    TORABuiltinFunction function;
+};
+
+extern const TORABuiltin tora_builtins[TORA_BUILTIN_TABLE_SIZE];
+
+const TORABuiltin *builtin_lookup(const char *name, size_t length);
+void builtin_check_arguments(const TORABuiltin *builtin, uint32_t num_arguments);
+
+#endif /* builtins_h */
@@ -0,0 +1,817 @@
+//
+//  flat.c
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "tora.h"
+
+TORAFlatIndex flat_program_add_expression(TORAFlatProgram *program, void *expression);
+TORAFlatIndex flat_program_add_node(TORAFlatProgram *program, TORAExpressionType type, uint8_t op, uint32_t val);
+uint32_t flat_program_add_number(TORAFlatProgram *program, double val);
+uint32_t flat_program_add_string(TORAFlatProgram *program, const char *val);
+uint32_t flat_program_add_function(TORAFlatProgram *program, TORAParserLambdaExpression *lambda);
+uint32_t flat_program_add_list(TORAFlatProgram *program, TORAParserExpressionList *list, bool pairs);
+uint32_t flat_program_add_constants(TORAFlatProgram *program, TORAParserExpressionList *constants);
+void *flat_program_grow(void *pool, uint32_t *capacity, uint32_t needed, size_t item_size);
+uint32_t *flat_program_intern_slot(TORAFlatProgram *program, uint32_t **table, uint32_t *capacity, uint32_t count, uint32_t hash, uint32_t (*item_hash)(TORAFlatProgram *, uint32_t));
+uint32_t *flat_program_intern_next(uint32_t *table, uint32_t capacity, uint32_t *slot);
+uint32_t flat_program_number_hash(TORAFlatProgram *program, uint32_t number);
+uint32_t flat_program_string_hash(TORAFlatProgram *program, uint32_t string);
+
+// Dumping
+// The names of the scope a node's dumped within, and of those enclosing it
+typedef struct TORAFlatDumpScope {
+    uint32_t names;
+    const struct TORAFlatDumpScope *parent;
+} TORAFlatDumpScope;
+void flat_program_dump_statement(TORAFlatProgram *program, TORAFlatIndex node, const TORAFlatDumpScope *scope, uint32_t indent, FILE *file);
+void flat_program_dump_node(TORAFlatProgram *program, TORAFlatIndex node, const TORAFlatDumpScope *scope, uint32_t indent, FILE *file);
+void flat_program_dump_block(TORAFlatProgram *program, TORAFlatIndex node, const TORAFlatDumpScope *scope, uint32_t indent, FILE *file);
+void flat_program_dump_number(double val, FILE *file);
+void flat_program_dump_string(const char *val, FILE *file);
+
+// constants are the assignments optimise_program found to be constant, if any
+TORAFlatProgram *flat_program_from_expression(TORAParserProgExpression *prog, TORAParserExpressionList *constants)
+{
+    assert(prog);
+    
+    TORAFlatProgram *program = tora_malloc(sizeof(TORAFlatProgram));
+    if(!program)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for flat program");
+    }
+    memset(program, 0, sizeof(TORAFlatProgram));
+    
+    program->root = flat_program_add_expression(program, prog);
+    program->constants = flat_program_add_constants(program, constants);
+    resolve_program(program);
+    flat_program_create_values(program);
+    
+    return program;
+}
+// Returns the number of bytes used by the program's nodes and literals
+uint64_t flat_program_size(TORAFlatProgram *program)
+{
+    return (uint64_t)program->num_nodes * sizeof(TORAFlatNode) +
+           (uint64_t)program->num_children * sizeof(uint32_t) +
+           (uint64_t)program->num_numbers * sizeof(double) +
+           (uint64_t)program->num_strings * sizeof(uint32_t) +
+           (uint64_t)program->num_chars +
+           (uint64_t)program->num_functions * sizeof(TORAFlatFunction);
+}
+void free_flat_program(TORAFlatProgram *program)
+{
+    if(!program) return;
+    
+    if(program->image)
+    {
+        munmap(program->image, program->image_length);
+    }
+    else
+    {
+        if(program->nodes) tora_free(program->nodes);
+        if(program->children) tora_free(program->children);
+        if(program->numbers) tora_free(program->numbers);
+        if(program->strings) tora_free(program->strings);
+        if(program->chars) tora_free(program->chars);
+        if(program->functions) tora_free(program->functions);
+    }
+    if(program->number_values) tora_free(program->number_values);
+    if(program->string_values) tora_free(program->string_values);
+    if(program->function_values) tora_free(program->function_values);
+    if(program->number_table) tora_free(program->number_table);
+    if(program->string_table) tora_free(program->string_table);
+    if(program->resolver) free_resolver(program->resolver);
+    
+    free_arena(program->values);
+    tora_free(program);
+}
+
+// Accessors
+const char *flat_program_string(TORAFlatProgram *program, uint32_t string)
+{
+    return program->chars + program->strings[string];
+}
+uint32_t *flat_program_children(TORAFlatProgram *program, uint32_t offset)
+{
+    return program->children + offset;
+}
+// Returns the indices of a node's children, for anything that needs to walk a program
+// without caring about the details of each node. Nodes with only one child keep it in
+// val, so a pointer to that is returned. Lambdas have none, as their bodies belong to
+// their function rather than to them
+uint32_t *flat_program_node_children(TORAFlatProgram *program, TORAFlatIndex node, uint32_t *num_children)
+{
+    TORAFlatNode *flat_node = &program->nodes[node];
+    switch(flat_node->type)
+    {
+        case TORAExpressionTypeNegativeUnary:
+        case TORAExpressionTypeReturn:
+            *num_children = 1;
+            return &flat_node->val;
+        case TORAExpressionTypeAssign:
+        case TORAExpressionTypeBinary:
+        case TORAExpressionTypeArrayIndex:
+        case TORAExpressionTypeWhile:
+            *num_children = 2;
+            return program->children + flat_node->val;
+        case TORAExpressionTypeIfThenElse:
+            *num_children = program->children[flat_node->val + 2] == TORA_FLAT_NONE ? 2 : 3;
+            return program->children + flat_node->val;
+        case TORAExpressionTypeProg:
+        case TORAExpressionTypeBuiltinCall:
+        case TORAExpressionTypeConcat:
+            *num_children = program->children[flat_node->val];
+            return program->children + flat_node->val + 1;
+        case TORAExpressionTypeCall:
+            *num_children = program->children[flat_node->val] + 1;
+            return program->children + flat_node->val + 1;
+        case TORAExpressionTypeArray:
+            *num_children = program->children[flat_node->val] * 2;
+            return program->children + flat_node->val + 1;
+        default:
+            break;
+    }
+    
+    *num_children = 0;
+    return NULL;
+}
+
+// Flattening
+// Nodes are added before their children, so a parent always has a lower index
+// than anything beneath it and a walk of the tree moves forwards through memory
+TORAFlatIndex flat_program_add_expression(TORAFlatProgram *program, void *expression)
+{
+    if(!expression)
+    {
+        return TORA_FLAT_NONE;
+    }
+    
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeNumeric:
+        {
+            uint32_t number = flat_program_add_number(program, ((TORAParserNumericExpression *)expression)->val);
+            return flat_program_add_node(program, TORAExpressionTypeNumeric, 0, number);
+        }
+        case TORAExpressionTypeString:
+        case TORAExpressionTypeVariable:
+        {
+            // Strings and variables share a layout, both keeping their text in val
+            uint32_t string = flat_program_add_string(program, ((TORAParserStringExpression *)expression)->val);
+            return flat_program_add_node(program, unknown_expression->type, 0, string);
+        }
+        case TORAExpressionTypeBoolean:
+            return flat_program_add_node(program, TORAExpressionTypeBoolean, 0, ((TORAParserBoolExpression *)expression)->val ? 1 : 0);
+        case TORAExpressionTypeLambda:
+        {
+            TORAFlatIndex node = flat_program_add_node(program, TORAExpressionTypeLambda, 0, 0);
+            uint32_t function = flat_program_add_function(program, (TORAParserLambdaExpression *)expression);
+            program->nodes[node].val = function;
+            return node;
+        }
+        case TORAExpressionTypeNegativeUnary:
+        case TORAExpressionTypeReturn:
+        {
+            // Negation and return share a layout, both holding their operand in expression
+            TORAFlatIndex node = flat_program_add_node(program, unknown_expression->type, 0, 0);
+            TORAFlatIndex operand = flat_program_add_expression(program, ((TORAParserReturnExpression *)expression)->expression);
+            program->nodes[node].val = operand;
+            return node;
+        }
+        case TORAExpressionTypeAssign:
+        case TORAExpressionTypeBinary:
+        {
+            TORAParserAssignOrBinaryExpression *binary_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            uint8_t op = (uint8_t)operator_kind(binary_expression->op, strlen(binary_expression->op));
+            
+            uint32_t children = flat_program_add_children(program, 2);
+            TORAFlatIndex node = flat_program_add_node(program, unknown_expression->type, op, children);
+            
+            TORAFlatIndex left = flat_program_add_expression(program, binary_expression->left);
+            program->children[children] = left;
+            TORAFlatIndex right = flat_program_add_expression(program, binary_expression->right);
+            program->children[children+1] = right;
+            return node;
+        }
+        case TORAExpressionTypeArrayIndex:
+        {
+            TORAParserArrayIndexExpression *index_expression = (TORAParserArrayIndexExpression *)expression;
+            
+            uint32_t children = flat_program_add_children(program, 2);
+            TORAFlatIndex node = flat_program_add_node(program, TORAExpressionTypeArrayIndex, 0, children);
+            
+            TORAFlatIndex array = flat_program_add_expression(program, index_expression->array);
+            program->children[children] = array;
+            TORAFlatIndex index = flat_program_add_expression(program, index_expression->index);
+            program->children[children+1] = index;
+            return node;
+        }
+        case TORAExpressionTypeWhile:
+        {
+            TORAParserWhileExpression *while_expression = (TORAParserWhileExpression *)expression;
+            
+            uint32_t children = flat_program_add_children(program, 2);
+            TORAFlatIndex node = flat_program_add_node(program, TORAExpressionTypeWhile, 0, children);
+            
+            TORAFlatIndex condition = flat_program_add_expression(program, while_expression->condition);
+            program->children[children] = condition;
+            TORAFlatIndex body = flat_program_add_expression(program, while_expression->body);
+            program->children[children+1] = body;
+            return node;
+        }
+        case TORAExpressionTypeIfThenElse:
+        {
+            TORAParserIfThenElseExpression *if_expression = (TORAParserIfThenElseExpression *)expression;
+            
+            uint32_t children = flat_program_add_children(program, 3);
+            TORAFlatIndex node = flat_program_add_node(program, TORAExpressionTypeIfThenElse, 0, children);
+            
+            TORAFlatIndex condition = flat_program_add_expression(program, if_expression->condition);
+            program->children[children] = condition;
+            TORAFlatIndex then = flat_program_add_expression(program, if_expression->then);
+            program->children[children+1] = then;
+            TORAFlatIndex el = flat_program_add_expression(program, if_expression->el);
+            program->children[children+2] = el;
+            return node;
+        }
+        case TORAExpressionTypeProg:
+        {
+            TORAFlatIndex node = flat_program_add_node(program, TORAExpressionTypeProg, 0, 0);
+            uint32_t children = flat_program_add_list(program, ((TORAParserProgExpression *)expression)->val, false);
+            program->nodes[node].val = children;
+            return node;
+        }
+        case TORAExpressionTypeArray:
+        {
+            TORAFlatIndex node = flat_program_add_node(program, TORAExpressionTypeArray, 0, 0);
+            uint32_t children = flat_program_add_list(program, ((TORAParserArrayExpression *)expression)->items, true);
+            program->nodes[node].val = children;
+            return node;
+        }
+        case TORAExpressionTypeBuiltinCall:
+        {
+            TORAParserBuiltinCallExpression *call_expression = (TORAParserBuiltinCallExpression *)expression;
+            uint8_t builtin = (uint8_t)(call_expression->builtin - tora_builtins);
+            TORAFlatIndex node = flat_program_add_node(program, TORAExpressionTypeBuiltinCall, builtin, 0);
+            uint32_t children = flat_program_add_list(program, call_expression->arguments, false);
+            program->nodes[node].val = children;
+            return node;
+        }
+        case TORAExpressionTypeConcat:
+        {
+            TORAFlatIndex node = flat_program_add_node(program, TORAExpressionTypeConcat, 0, 0);
+            uint32_t children = flat_program_add_list(program, ((TORAParserConcatExpression *)expression)->pieces, false);
+            program->nodes[node].val = children;
+            return node;
+        }
+        case TORAExpressionTypeCall:
+        {
+            TORAParserCallExpression *call_expression = (TORAParserCallExpression *)expression;
+            uint32_t num_arguments = call_expression->arguments->length;
+            
+            uint32_t children = flat_program_add_children(program, num_arguments + 2);
+            TORAFlatIndex node = flat_program_add_node(program, TORAExpressionTypeCall, 0, children);
+            program->children[children] = num_arguments;
+            
+            TORAFlatIndex func = flat_program_add_expression(program, call_expression->func);
+            program->children[children+1] = func;
+            
+            for(uint32_t i = 0; i < num_arguments; i++)
+            {
+                TORAFlatIndex argument = flat_program_add_expression(program, call_expression->arguments->items[i]);
+                program->children[children + 2 + i] = argument;
+            }
+            return node;
+        }
+        default:
+            TORA_RUNTIME_EXCEPTION("Unable to flatten expression of type: %i", unknown_expression->type);
+            break;
+    }
+    
+    return TORA_FLAT_NONE;
+}
+TORAFlatIndex flat_program_add_node(TORAFlatProgram *program, TORAExpressionType type, uint8_t op, uint32_t val)
+{
+    program->nodes = flat_program_grow(program->nodes, &program->nodes_capacity, program->num_nodes + 1, sizeof(TORAFlatNode));
+    
+    TORAFlatNode *node = &program->nodes[program->num_nodes];
+    node->type = (uint8_t)type;
+    node->op = op;
+    node->flags = 0;
+    node->val = val;
+    
+    return program->num_nodes++;
+}
+// Reserves a run of count children, returning its offset. Since adding children
+// may move the pool, callers must index into it afresh after each addition
+uint32_t flat_program_add_children(TORAFlatProgram *program, uint32_t count)
+{
+    program->children = flat_program_grow(program->children, &program->children_capacity, program->num_children + count, sizeof(uint32_t));
+    
+    uint32_t offset = program->num_children;
+    for(uint32_t i = 0; i < count; i++)
+    {
+        program->children[offset+i] = TORA_FLAT_NONE;
+    }
+    program->num_children += count;
+    
+    return offset;
+}
+// Numbers and strings are interned, so each distinct literal (or name) is held once
+// however many times it appears, and shares a single value (see flat.h)
+uint32_t flat_program_add_number(TORAFlatProgram *program, double val)
+{
+    // Numbers are compared by their bits, keeping 0 and -0 apart
+    uint32_t hash = (uint32_t)tora_hash(&val, sizeof(double));
+    uint32_t *slot = flat_program_intern_slot(program, &program->number_table, &program->number_table_capacity, program->num_numbers, hash, flat_program_number_hash);
+    while(*slot != TORA_FLAT_NONE)
+    {
+        if(memcmp(&program->numbers[*slot], &val, sizeof(double)) == 0)
+        {
+            return *slot;
+        }
+        slot = flat_program_intern_next(program->number_table, program->number_table_capacity, slot);
+    }
+    
+    program->numbers = flat_program_grow(program->numbers, &program->numbers_capacity, program->num_numbers + 1, sizeof(double));
+    program->numbers[program->num_numbers] = val;
+    
+    *slot = program->num_numbers;
+    return program->num_numbers++;
+}
+uint32_t flat_program_add_string(TORAFlatProgram *program, const char *val)
+{
+    uint32_t hash = tora_strhash(val);
+    uint32_t *slot = flat_program_intern_slot(program, &program->string_table, &program->string_table_capacity, program->num_strings, hash, flat_program_string_hash);
+    while(*slot != TORA_FLAT_NONE)
+    {
+        if(strcmp(flat_program_string(program, *slot), val) == 0)
+        {
+            return *slot;
+        }
+        slot = flat_program_intern_next(program->string_table, program->string_table_capacity, slot);
+    }
+    *slot = program->num_strings;
+    
+    uint32_t length = (uint32_t)strlen(val);
+    program->chars = flat_program_grow(program->chars, &program->chars_capacity, program->num_chars + length + 1, sizeof(char));
+    program->strings = flat_program_grow(program->strings, &program->strings_capacity, program->num_strings + 1, sizeof(uint32_t));
+    
+    memcpy(program->chars + program->num_chars, val, length + 1);
+    program->strings[program->num_strings] = program->num_chars;
+    program->num_chars += length + 1;
+    
+    return program->num_strings++;
+}
+uint32_t flat_program_add_function(TORAFlatProgram *program, TORAParserLambdaExpression *lambda)
+{
+    // Reserve the function's slot up front, as its body may well define functions of its own
+    program->functions = flat_program_grow(program->functions, &program->functions_capacity, program->num_functions + 1, sizeof(TORAFlatFunction));
+    uint32_t function = program->num_functions++;
+    
+    uint32_t name = lambda->name ? flat_program_add_string(program, lambda->name) : TORA_FLAT_NONE;
+    
+    uint32_t num_parameters = lambda->arguments->length;
+    uint32_t parameters = flat_program_add_children(program, num_parameters + 1);
+    program->children[parameters] = num_parameters;
+    
+    for(uint32_t i = 0; i < num_parameters; i++)
+    {
+        uint32_t parameter = flat_program_add_string(program, ((TORAParserVariableExpression *)lambda->arguments->items[i])->val);
+        program->children[parameters + 1 + i] = parameter;
+    }
+    
+    TORAFlatIndex body = flat_program_add_expression(program, lambda->body);
+    
+    // Parameters are held as names until the function's scope is resolved
+    program->functions[function].name = name;
+    program->functions[function].slot = TORA_FLAT_NONE;
+    program->functions[function].parameters = parameters;
+    program->functions[function].names = TORA_FLAT_NONE;
+    program->functions[function].body = body;
+    program->functions[function].first_token = lambda->first_token;
+    program->functions[function].num_tokens = lambda->num_tokens;
+    program->functions[function].num_constants = lambda->num_constants;
+    
+    return function;
+}
+// Adds the body of a function that was parsed after the rest of the program, along
+// with values for anything new it brings
+void flat_program_add_function_body(TORAFlatProgram *program, uint32_t function, void *body)
+{
+    assert(program->functions[function].body == TORA_FLAT_NONE);
+    
+    uint32_t first_function = program->num_functions;
+    TORAFlatIndex flat_body = flat_program_add_expression(program, body);
+    program->functions[function].body = flat_body;
+    
+    resolve_function(program, function, first_function);
+    flat_program_create_values(program);
+}
+// Adds a run of a list's expressions, prefixed with how many there are (or how many
+// key/value pairs there are, for array literals)
+uint32_t flat_program_add_list(TORAFlatProgram *program, TORAParserExpressionList *list, bool pairs)
+{
+    uint32_t children = flat_program_add_children(program, list->length + 1);
+    program->children[children] = pairs ? list->length / 2 : list->length;
+    
+    for(uint32_t i = 0; i < list->length; i++)
+    {
+        TORAFlatIndex item = flat_program_add_expression(program, list->items[i]);
+        program->children[children + 1 + i] = item;
+    }
+    
+    return children;
+}
+uint32_t flat_program_add_constants(TORAFlatProgram *program, TORAParserExpressionList *constants)
+{
+    uint32_t num_constants = constants ? constants->length : 0;
+    uint32_t children = flat_program_add_children(program, num_constants * 2 + 1);
+    program->children[children] = num_constants;
+    
+    for(uint32_t i = 0; i < num_constants; i++)
+    {
+        TORAParserAssignOrBinaryExpression *statement = constants->items[i];
+        uint32_t name = flat_program_add_string(program, ((TORAParserVariableExpression *)statement->left)->val);
+        program->children[children + 1 + i * 2] = name;
+        TORAFlatIndex value = flat_program_add_expression(program, statement->right);
+        program->children[children + 2 + i * 2] = value;
+    }
+    
+    return children;
+}
+void *flat_program_grow(void *pool, uint32_t *capacity, uint32_t needed, size_t item_size)
+{
+    if(needed <= *capacity)
+    {
+        return pool;
+    }
+    
+    uint32_t new_capacity = *capacity ? *capacity : 64;
+    while(new_capacity < needed)
+    {
+        new_capacity *= 2;
+    }
+    
+    void *new_pool = pool ? realloc(pool, new_capacity * item_size) : tora_malloc(new_capacity * item_size);
+    if(!new_pool)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to realloc space for flat program pool");
+    }
+    *capacity = new_capacity;
+    
+    return new_pool;
+}
+// Returns the slot an intern table's probe for hash starts at, first growing the table
+// so it stays no more than half full once another item's been added. Tables hold the
+// index of each item, and are rebuilt using item_hash as they grow
+uint32_t *flat_program_intern_slot(TORAFlatProgram *program, uint32_t **table, uint32_t *capacity, uint32_t count, uint32_t hash, uint32_t (*item_hash)(TORAFlatProgram *, uint32_t))
+{
+    if((count + 1) * 2 > *capacity)
+    {
+        uint32_t new_capacity = *capacity ? *capacity * 2 : 64;
+        uint32_t *new_table = tora_malloc(new_capacity * sizeof(uint32_t));
+        if(!new_table)
+        {
+            TORA_RUNTIME_EXCEPTION("Failed to malloc space for flat program intern table");
+        }
+        memset(new_table, 0xFF, new_capacity * sizeof(uint32_t));
+        
+        for(uint32_t i = 0; i < count; i++)
+        {
+            uint32_t *slot = new_table + (item_hash(program, i) & (new_capacity - 1));
+            while(*slot != TORA_FLAT_NONE)
+            {
+                slot = flat_program_intern_next(new_table, new_capacity, slot);
+            }
+            *slot = i;
+        }
+        
+        if(*table) tora_free(*table);
+        *table = new_table;
+        *capacity = new_capacity;
+    }
+    
+    return *table + (hash & (*capacity - 1));
+}
+uint32_t *flat_program_intern_next(uint32_t *table, uint32_t capacity, uint32_t *slot)
+{
+    return table + ((uint32_t)(slot - table + 1) & (capacity - 1));
+}
+uint32_t flat_program_number_hash(TORAFlatProgram *program, uint32_t number)
+{
+    return (uint32_t)tora_hash(&program->numbers[number], sizeof(double));
+}
+uint32_t flat_program_string_hash(TORAFlatProgram *program, uint32_t string)
+{
+    return tora_strhash(flat_program_string(program, string));
+}
+
+// Values
+// Creates the objects handed out when evaluating the program's literals and functions,
+// for whichever of them don't have one yet. They're all immortal, and all freed along
+// with the program's values arena
+void flat_program_create_values(TORAFlatProgram *program)
+{
+    if(!program->values)
+    {
+        program->values = arena_create();
+    }
+    program->number_values = flat_program_grow(program->number_values, &program->number_values_capacity, program->num_numbers + 1, sizeof(void *));
+    program->string_values = flat_program_grow(program->string_values, &program->string_values_capacity, program->num_strings + 1, sizeof(void *));
+    program->function_values = flat_program_grow(program->function_values, &program->function_values_capacity, program->num_functions + 1, sizeof(void *));
+    
+    // String values share their text with the program, so follow it if it's moved
+    if(program->values_chars != program->chars)
+    {
+        for(uint32_t i = 0; i < program->num_string_values; i++)
+        {
+            program->string_values[i]->val = (char *)flat_program_string(program, i);
+        }
+        program->values_chars = program->chars;
+    }
+    
+    for(uint32_t i = program->num_number_values; i < program->num_numbers; i++)
+    {
+        TORAParserNumericExpression *value = arena_alloc(program->values, sizeof(TORAParserNumericExpression));
+        value->instance_type = TORAInstanceTypeExpression;
+        value->ref_count = TORA_REF_COUNT_IMMORTAL;
+        value->type = TORAExpressionTypeNumeric;
+        value->val = program->numbers[i];
+        program->number_values[i] = value;
+    }
+    for(uint32_t i = program->num_string_values; i < program->num_strings; i++)
+    {
+        TORAParserStringExpression *value = arena_alloc(program->values, sizeof(TORAParserStringExpression));
+        value->instance_type = TORAInstanceTypeExpression;
+        value->ref_count = TORA_REF_COUNT_IMMORTAL;
+        value->type = TORAExpressionTypeString;
+        value->val = (char *)flat_program_string(program, i);
+        value->hash = 0;
+        string_expression_hash(value);
+        program->string_values[i] = value;
+    }
+    for(uint32_t i = program->num_function_values; i < program->num_functions; i++)
+    {
+        TORAFlatFunctionValue *value = arena_alloc(program->values, sizeof(TORAFlatFunctionValue));
+        value->instance_type = TORAInstanceTypeExpression;
+        value->ref_count = TORA_REF_COUNT_IMMORTAL;
+        value->type = TORAExpressionTypeFunction;
+        value->function = i;
+        value->environment = NULL;
+        program->function_values[i] = value;
+    }
+    
+    program->num_number_values = program->num_numbers;
+    program->num_string_values = program->num_strings;
+    program->num_function_values = program->num_functions;
+}
+
+// Dumping
+// Writes the program out as source, with every operation bracketed and each
+// variable named as it was resolved. Anything the optimiser introduced that the
+// language has no syntax for is written as if it did: its temporaries keep their
+// # names, and a prog evaluated as part of an expression is written as a block
+void flat_program_dump(TORAFlatProgram *program, FILE *file)
+{
+    TORAFlatDumpScope scope = { program->globals, NULL };
+    uint32_t num_statements = 0;
+    uint32_t *statements = flat_program_node_children(program, program->root, &num_statements);
+    for(uint32_t i = 0; i < num_statements; i++)
+    {
+        flat_program_dump_statement(program, statements[i], &scope, 0, file);
+    }
+}
+void flat_program_dump_node(TORAFlatProgram *program, TORAFlatIndex node, const TORAFlatDumpScope *scope, uint32_t indent, FILE *file)
+{
+    TORAFlatNode flat_node = program->nodes[node];
+    uint32_t *children = flat_program_children(program, flat_node.val);
+    switch(flat_node.type)
+    {
+        case TORAExpressionTypeNumeric:
+            flat_program_dump_number(program->numbers[flat_node.val], file);
+            break;
+        case TORAExpressionTypeString:
+            flat_program_dump_string(flat_program_string(program, flat_node.val), file);
+            break;
+        case TORAExpressionTypeBoolean:
+            fprintf(file, "%s", flat_node.val ? "true" : "false");
+            break;
+        case TORAExpressionTypeVariable:
+        {
+            uint32_t name = flat_node.val;
+            if(flat_node.op == TORA_FLAT_SCOPE_GLOBAL)
+            {
+                name = program->children[program->globals + 1 + flat_node.val];
+            }
+            else if(flat_node.op != TORA_FLAT_SCOPE_UNRESOLVED)
+            {
+                const TORAFlatDumpScope *variable_scope = scope;
+                for(uint8_t depth = flat_node.op; depth > 0 && variable_scope->parent; depth--)
+                {
+                    variable_scope = variable_scope->parent;
+                }
+                name = program->children[variable_scope->names + 1 + flat_node.val];
+            }
+            fprintf(file, "%s", flat_program_string(program, name));
+        }
+            break;
+        case TORAExpressionTypeAssign:
+        case TORAExpressionTypeBinary:
+        {
+            fprintf(file, "(");
+            flat_program_dump_node(program, children[0], scope, indent, file);
+            fprintf(file, " %s ", tora_token_kind_text[flat_node.op]);
+            flat_program_dump_node(program, children[1], scope, indent, file);
+            fprintf(file, ")");
+        }
+            break;
+        case TORAExpressionTypeNegativeUnary:
+            fprintf(file, "-(");
+            flat_program_dump_node(program, flat_node.val, scope, indent, file);
+            fprintf(file, ")");
+            break;
+        case TORAExpressionTypeReturn:
+            fprintf(file, "return ");
+            flat_program_dump_node(program, flat_node.val, scope, indent, file);
+            break;
+        case TORAExpressionTypeArrayIndex:
+            flat_program_dump_node(program, children[0], scope, indent, file);
+            fprintf(file, "[");
+            flat_program_dump_node(program, children[1], scope, indent, file);
+            fprintf(file, "]");
+            break;
+        case TORAExpressionTypeArray:
+        {
+            fprintf(file, "[");
+            for(uint32_t i = 0; i < children[0]; i++)
+            {
+                fprintf(file, "%s", i > 0 ? ", " : "");
+                flat_program_dump_node(program, program->children[flat_node.val + 1 + i * 2], scope, indent, file);
+                fprintf(file, ": ");
+                flat_program_dump_node(program, program->children[flat_node.val + 2 + i * 2], scope, indent, file);
+            }
+            fprintf(file, "]");
+        }
+            break;
+        case TORAExpressionTypeCall:
+        case TORAExpressionTypeBuiltinCall:
+        {
+            // A call's first child is the function it calls
+            uint32_t first = 1;
+            if(flat_node.type == TORAExpressionTypeCall)
+            {
+                flat_program_dump_node(program, children[1], scope, indent, file);
+                first = 2;
+            }
+            else
+            {
+                fprintf(file, "%s", tora_builtins[flat_node.op].name);
+            }
+            
+            fprintf(file, "(");
+            for(uint32_t i = 0; i < children[0]; i++)
+            {
+                fprintf(file, "%s", i > 0 ? ", " : "");
+                flat_program_dump_node(program, program->children[flat_node.val + first + i], scope, indent, file);
+            }
+            fprintf(file, ")");
+        }
+            break;
+        case TORAExpressionTypeConcat:
+        {
+            fprintf(file, "(");
+            for(uint32_t i = 1; i <= children[0]; i++)
+            {
+                fprintf(file, "%s", i > 1 ? " + " : "");
+                flat_program_dump_node(program, program->children[flat_node.val + i], scope, indent, file);
+            }
+            fprintf(file, ")");
+        }
+            break;
+        case TORAExpressionTypeLambda:
+        {
+            TORAFlatFunction *function = &program->functions[flat_node.val];
+            fprintf(file, "func");
+            if(function->name != TORA_FLAT_NONE)
+            {
+                fprintf(file, " %s", flat_program_string(program, function->name));
+            }
+            
+            // Parameters are names until the function's resolved, and slots after
+            uint32_t *parameters = flat_program_children(program, function->parameters);
+            fprintf(file, "(");
+            for(uint32_t i = 1; i <= parameters[0]; i++)
+            {
+                uint32_t name = function->names == TORA_FLAT_NONE ? parameters[i] : program->children[function->names + 1 + parameters[i]];
+                fprintf(file, "%s%s", i > 1 ? ", " : "", flat_program_string(program, name));
+            }
+            fprintf(file, ") ");
+            
+            if(function->body == TORA_FLAT_NONE)
+            {
+                fprintf(file, "{ ... }");
+            }
+            else
+            {
+                TORAFlatDumpScope function_scope = { function->names, scope };
+                flat_program_dump_block(program, function->body, &function_scope, indent, file);
+            }
+        }
+            break;
+        case TORAExpressionTypeWhile:
+            fprintf(file, "while(");
+            flat_program_dump_node(program, children[0], scope, indent, file);
+            fprintf(file, ") ");
+            flat_program_dump_block(program, children[1], scope, indent, file);
+            break;
+        case TORAExpressionTypeIfThenElse:
+            fprintf(file, "if(");
+            flat_program_dump_node(program, children[0], scope, indent, file);
+            fprintf(file, ") ");
+            flat_program_dump_block(program, children[1], scope, indent, file);
+            if(children[2] != TORA_FLAT_NONE)
+            {
+                fprintf(file, " else ");
+                flat_program_dump_block(program, children[2], scope, indent, file);
+            }
+            break;
+        case TORAExpressionTypeProg:
+            flat_program_dump_block(program, node, scope, indent, file);
+            break;
+        default:
+            break;
+    }
+}
+// Statements are written on a line of their own, and assignments made as one aren't
+// bracketed as those made within an expression are
+void flat_program_dump_statement(TORAFlatProgram *program, TORAFlatIndex node, const TORAFlatDumpScope *scope, uint32_t indent, FILE *file)
+{
+    TORAFlatNode flat_node = program->nodes[node];
+    if(flat_node.type == TORAExpressionTypeAssign)
+    {
+        uint32_t *children = flat_program_children(program, flat_node.val);
+        flat_program_dump_node(program, children[0], scope, indent, file);
+        fprintf(file, " = ");
+        flat_program_dump_node(program, children[1], scope, indent, file);
+    }
+    else
+    {
+        flat_program_dump_node(program, node, scope, indent, file);
+    }
+    fprintf(file, ";\n");
+}
+// Writes a node within braces, with each statement of a prog on a line of its own
+void flat_program_dump_block(TORAFlatProgram *program, TORAFlatIndex node, const TORAFlatDumpScope *scope, uint32_t indent, FILE *file)
+{
+    uint32_t num_statements = 1;
+    uint32_t *statements = &node;
+    if(program->nodes[node].type == TORAExpressionTypeProg)
+    {
+        statements = flat_program_node_children(program, node, &num_statements);
+    }
+    
+    fprintf(file, "{\n");
+    for(uint32_t i = 0; i < num_statements; i++)
+    {
+        fprintf(file, "%*s", (int)(indent + 1) * 4, "");
+        flat_program_dump_statement(program, statements[i], scope, indent + 1, file);
+    }
+    fprintf(file, "%*s}", (int)indent * 4, "");
+}
+// Numbers are written with as few digits as will read back as the same number
+void flat_program_dump_number(double val, FILE *file)
+{
+    char text[32];
+    for(int precision = 15; precision <= 17; precision++)
+    {
+        snprintf(text, sizeof(text), "%.*g", precision, val);
+        if(strtod(text, NULL) == val)
+        {
+            break;
+        }
+    }
+    fprintf(file, "%s", text);
+}
+void flat_program_dump_string(const char *val, FILE *file)
+{
+    fputc('"', file);
+    for(const char *ch = val; *ch; ch++)
+    {
+        if(*ch == '"' || *ch == '\\')
+        {
+            fputc('\\', file);
+        }
+        fputc(*ch, file);
+    }
+    fputc('"', file);
+}
@@ -0,0 +1,183 @@
+//
+//  flat.h
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#ifndef flat_h
+#define flat_h
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "parser.h"
+
+// A flat program is the form of the AST the interpreter evaluates. Rather than
+// being a tree of individually allocated nodes it's a handful of contiguous pools,
+// and nodes refer to one another (and to their literals) by 32-bit index. None of
+// the pools contain pointers, so a program's image is position independent.
+//
+// Every node is an 8 byte header. What val refers to depends on the node's type:
+//
+//   Numeric                     index into numbers
+//   String                      index into strings
+//   Variable                    the variable's slot, with the scope holding it in op
+//                               (see below)
+//   Boolean                     0 or 1
+//   Lambda                      index into functions
+//   NegativeUnary, Return       the index of the node's only child
+//   Assign, Binary              offset into children of [left, right], with the
+//                               operator's TORATokenKind held in op
+//   ArrayIndex                  offset into children of [array, index]
+//   While                       offset into children of [condition, body]
+//   IfThenElse                  offset into children of [condition, then, else]
+//   Prog                        offset into children of [n, statement...]
+//   Call                        offset into children of [n, func, argument...]
+//   BuiltinCall                 offset into children of [n, argument...], with the
+//                               builtin's slot in tora_builtins held in op
+//   Array                       offset into children of [n, key, value, ...]
+//   Concat                      offset into children of [n, piece...]
+//
+// Ranges whose length varies are prefixed with it, and else is TORA_FLAT_NONE
+// when an if has no else branch
+#define TORA_FLAT_NONE UINT32_MAX
+
+// Every function, and the program's top level, is a scope with a slot for each
+// name bound within it. Its names are a length prefixed run of string indices, and
+// a function's parameters a length prefixed run of the slots they're bound to.
+//
+// Variables are resolved to a slot before the program's run, and op says which
+// environment holds it: how many parents out from the one the variable's evaluated
+// in, or TORA_FLAT_SCOPE_GLOBAL for the top level's. A name that no enclosing scope
+// binds is marked with TORA_FLAT_SCOPE_UNRESOLVED, and val is its index into strings
+#define TORA_FLAT_SCOPE_GLOBAL 0xFF
+#define TORA_FLAT_SCOPE_UNRESOLVED 0xFE
+#define TORA_FLAT_SCOPE_MAX_DEPTH 0xFE
+
+typedef uint32_t TORAFlatIndex;
+
+typedef struct {
+    uint8_t type;
+    uint8_t op;
+    uint16_t flags;
+    uint32_t val;
+} TORAFlatNode;
+
+// A function whose body was skipped by the parser has a body of TORA_FLAT_NONE
+// until it's first called, and until then keeps the range of tokens holding it
+// and how many of the program's constants it can use (see parse_function_body)
+typedef struct {
+    uint32_t name;
+    uint32_t slot;
+    uint32_t parameters;
+    uint32_t names;
+    TORAFlatIndex body;
+    
+    uint32_t first_token;
+    uint32_t num_tokens;
+    uint32_t num_constants;
+} TORAFlatFunction;
+
+// Values are the objects evaluate() hands out for a program's literals and functions.
+// They're created along with the program and shared by every evaluation, so are
+// immortal and live until the program is freed.
+//
+// A function's calls have the environment it was defined in as their parent. The
+// program's own function values are for functions defined at the top level, and
+// leave it NULL to stand for the global environment; functions defined within
+// others get a value of their own each time their definition's evaluated
+typedef struct {
+    TORAInstanceType instance_type;
+    int ref_count;
+    
+    TORAExpressionType type;
+    TORAFlatIndex function;
+    struct TORAEnvironment *environment;
+} TORAFlatFunctionValue;
+
+struct TORAFlatProgram {
+    TORAFlatNode *nodes;
+    uint32_t num_nodes;
+    uint32_t nodes_capacity;
+    
+    uint32_t *children;
+    uint32_t num_children;
+    uint32_t children_capacity;
+    
+    double *numbers;
+    uint32_t num_numbers;
+    uint32_t numbers_capacity;
+    
+    uint32_t *strings;
+    uint32_t num_strings;
+    uint32_t strings_capacity;
+    
+    char *chars;
+    uint32_t num_chars;
+    uint32_t chars_capacity;
+    
+    TORAFlatFunction *functions;
+    uint32_t num_functions;
+    uint32_t functions_capacity;
+    
+    // Open addressed tables of the numbers and strings added so far, which are
+    // interned so identical literals share one entry (and value)
+    uint32_t *number_table;
+    uint32_t number_table_capacity;
+    uint32_t *string_table;
+    uint32_t string_table_capacity;
+    
+    TORAFlatIndex root;
+    uint32_t globals;
+    
+    // The top level's constants, as a length prefixed run of name and literal
+    // node pairs in the order they're assigned
+    uint32_t constants;
+    
+    // Anything added once the program's been created (the bodies of functions
+    // parsed lazily) gets its values as it's added, and string values are moved
+    // along with chars
+    TORAArena *values;
+    TORAParserNumericExpression **number_values;
+    TORAParserStringExpression **string_values;
+    TORAFlatFunctionValue **function_values;
+    uint32_t num_number_values;
+    uint32_t number_values_capacity;
+    uint32_t num_string_values;
+    uint32_t string_values_capacity;
+    uint32_t num_function_values;
+    uint32_t function_values_capacity;
+    const char *values_chars;
+    
+    // Functions parsed lazily are read from the program's token stream, and
+    // resolved with what's left of the resolver (see resolver.h)
+    TORATokenStream *source;
+    struct TORAResolver *resolver;
+    
+    // A program loaded from an image (see image.h) has its pools mapped read-only
+    // from it rather than allocated, and can only be evaluated
+    char *image;
+    uint64_t image_length;
+};
+
+TORAFlatProgram *flat_program_from_expression(TORAParserProgExpression *prog, TORAParserExpressionList *constants);
+uint64_t flat_program_size(TORAFlatProgram *program);
+void free_flat_program(TORAFlatProgram *program);
+
+// Accessors
+const char *flat_program_string(TORAFlatProgram *program, uint32_t string);
+uint32_t *flat_program_children(TORAFlatProgram *program, uint32_t offset);
+uint32_t *flat_program_node_children(TORAFlatProgram *program, TORAFlatIndex node, uint32_t *num_children);
+
+// Building
+uint32_t flat_program_add_children(TORAFlatProgram *program, uint32_t count);
+void flat_program_add_function_body(TORAFlatProgram *program, uint32_t function, void *body);
+void flat_program_create_values(TORAFlatProgram *program);
+
+// Writes the program out as source, as it'll be evaluated
+void flat_program_dump(TORAFlatProgram *program, FILE *file);
+
+#endif /* flat_h */
@@ -0,0 +1,273 @@
+//
+//  image.c
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "tora.h"
+
+// Mapping
+TORAFlatProgram *image_map(const char *path, bool check_source, uint64_t source_hash, uint64_t source_length);
+
+// Sections
+uint64_t image_align(uint64_t offset);
+bool image_section_fits(TORAImageHeader *header, uint64_t offset, uint32_t count, size_t item_size);
+bool image_write(int fd, const void *data, uint64_t length);
+
+char *image_cache_path(const char *source, const char *cache_dir, uint64_t source_hash)
+{
+    size_t length = cache_dir ? strlen(cache_dir) + 24 : strlen(source) + 2;
+    char *path = tora_malloc(length);
+    if(!path)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for image path");
+    }
+    
+    if(cache_dir)
+    {
+        snprintf(path, length, "%s/%016llx.torac", cache_dir, (unsigned long long)source_hash);
+    }
+    else
+    {
+        snprintf(path, length, "%sc", source);
+    }
+    return path;
+}
+// Whether an image could be saved to path, so callers can avoid doing any work to
+// produce one that would only be thrown away
+bool image_cache_writable(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    if(!slash)
+    {
+        return access(".", W_OK) == 0;
+    }
+    
+    char *directory = tora_strncpy(path, slash == path ? 1 : (size_t)(slash - path));
+    bool writable = access(directory, W_OK) == 0;
+    tora_free(directory);
+    
+    return writable;
+}
+
+TORAFlatProgram *image_load(const char *path, uint64_t source_hash, uint64_t source_length)
+{
+    return image_map(path, true, source_hash, source_length);
+}
+TORAFlatProgram *image_load_any(const char *path)
+{
+    return image_map(path, false, 0, 0);
+}
+bool image_save(TORAFlatProgram *program, const char *path, uint64_t source_hash, uint64_t source_length)
+{
+    // Skipped function bodies only exist in the program's token stream
+    for(uint32_t i = 0; i < program->num_functions; i++)
+    {
+        if(program->functions[i].body == TORA_FLAT_NONE)
+        {
+            return false;
+        }
+    }
+    
+    TORAImageHeader header;
+    memset(&header, 0, sizeof(TORAImageHeader));
+    memcpy(header.magic, TORA_IMAGE_MAGIC, 4);
+    header.byte_order = TORA_IMAGE_BYTE_ORDER;
+    header.header_size = sizeof(TORAImageHeader);
+    strncpy(header.version, TORA_VERSION, sizeof(header.version) - 1);
+    header.source_hash = source_hash;
+    header.source_length = source_length;
+    header.root = program->root;
+    header.globals = program->globals;
+    header.constants = program->constants;
+    header.num_nodes = program->num_nodes;
+    header.num_children = program->num_children;
+    header.num_numbers = program->num_numbers;
+    header.num_strings = program->num_strings;
+    header.num_chars = program->num_chars;
+    header.num_functions = program->num_functions;
+    
+    header.nodes = image_align(sizeof(TORAImageHeader));
+    header.children = image_align(header.nodes + (uint64_t)program->num_nodes * sizeof(TORAFlatNode));
+    header.numbers = image_align(header.children + (uint64_t)program->num_children * sizeof(uint32_t));
+    header.strings = image_align(header.numbers + (uint64_t)program->num_numbers * sizeof(double));
+    header.chars = image_align(header.strings + (uint64_t)program->num_strings * sizeof(uint32_t));
+    header.functions = image_align(header.chars + (uint64_t)program->num_chars);
+    header.image_length = header.functions + (uint64_t)program->num_functions * sizeof(TORAFlatFunction);
+    
+    // The image is written alongside its final path and renamed into place, so a
+    // reader never sees one half written
+    size_t temp_length = strlen(path) + 24;
+    char *temp_path = tora_malloc(temp_length);
+    if(!temp_path)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for image path");
+    }
+    snprintf(temp_path, temp_length, "%s.%ld.tmp", path, (long)getpid());
+    
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+    {
+        tora_free(temp_path);
+        return false;
+    }
+    
+    static const char padding[8] = { 0 };
+    uint64_t written = 0;
+    bool success = image_write(fd, &header, sizeof(TORAImageHeader));
+    written += sizeof(TORAImageHeader);
+    
+    const void *sections[] = { program->nodes, program->children, program->numbers, program->strings, program->chars, program->functions };
+    uint64_t offsets[] = { header.nodes, header.children, header.numbers, header.strings, header.chars, header.functions };
+    uint64_t lengths[] = {
+        (uint64_t)program->num_nodes * sizeof(TORAFlatNode),
+        (uint64_t)program->num_children * sizeof(uint32_t),
+        (uint64_t)program->num_numbers * sizeof(double),
+        (uint64_t)program->num_strings * sizeof(uint32_t),
+        (uint64_t)program->num_chars,
+        (uint64_t)program->num_functions * sizeof(TORAFlatFunction)
+    };
+    for(int i = 0; i < 6 && success; i++)
+    {
+        success = image_write(fd, padding, offsets[i] - written) && image_write(fd, sections[i], lengths[i]);
+        written = offsets[i] + lengths[i];
+    }
+    
+    success = close(fd) == 0 && success;
+    if(success)
+    {
+        success = rename(temp_path, path) == 0;
+    }
+    if(!success)
+    {
+        unlink(temp_path);
+    }
+    tora_free(temp_path);
+    
+    return success;
+}
+
+// Mapping
+// Images are mapped read-only and evaluated in place, so every process running the
+// same image shares a single copy of it through the page cache. Only the values
+// handed out for its literals and functions are created per process
+TORAFlatProgram *image_map(const char *path, bool check_source, uint64_t source_hash, uint64_t source_length)
+{
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+    {
+        return NULL;
+    }
+    
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(TORAImageHeader))
+    {
+        close(fd);
+        return NULL;
+    }
+    
+    size_t length = (size_t)st.st_size;
+    char *image = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(image == MAP_FAILED)
+    {
+        return NULL;
+    }
+    
+    // Anything that doesn't match what we'd have built ourselves is ignored, and
+    // the source parsed instead
+    TORAImageHeader *header = (TORAImageHeader *)image;
+    if(memcmp(header->magic, TORA_IMAGE_MAGIC, 4) != 0 ||
+       header->byte_order != TORA_IMAGE_BYTE_ORDER ||
+       header->header_size != sizeof(TORAImageHeader) ||
+       strncmp(header->version, TORA_VERSION, sizeof(header->version)) != 0 ||
+       (check_source && (header->source_hash != source_hash || header->source_length != source_length)) ||
+       header->image_length != length ||
+       !image_section_fits(header, header->nodes, header->num_nodes, sizeof(TORAFlatNode)) ||
+       !image_section_fits(header, header->children, header->num_children, sizeof(uint32_t)) ||
+       !image_section_fits(header, header->numbers, header->num_numbers, sizeof(double)) ||
+       !image_section_fits(header, header->strings, header->num_strings, sizeof(uint32_t)) ||
+       !image_section_fits(header, header->chars, header->num_chars, sizeof(char)) ||
+       !image_section_fits(header, header->functions, header->num_functions, sizeof(TORAFlatFunction)) ||
+       header->root >= header->num_nodes ||
+       (header->num_chars > 0 && image[header->chars + header->num_chars - 1] != '\0'))
+    {
+        munmap(image, length);
+        return NULL;
+    }
+    
+    // A mapped program can't have functions parsed into it later on
+    TORAFlatFunction *functions = (TORAFlatFunction *)(image + header->functions);
+    for(uint32_t i = 0; i < header->num_functions; i++)
+    {
+        if(functions[i].body == TORA_FLAT_NONE)
+        {
+            munmap(image, length);
+            return NULL;
+        }
+    }
+    
+    TORAFlatProgram *program = tora_malloc(sizeof(TORAFlatProgram));
+    if(!program)
+    {
+        munmap(image, length);
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for flat program");
+    }
+    memset(program, 0, sizeof(TORAFlatProgram));
+    
+    program->image = image;
+    program->image_length = length;
+    program->root = header->root;
+    program->globals = header->globals;
+    program->constants = header->constants;
+    program->num_nodes = program->nodes_capacity = header->num_nodes;
+    program->num_children = program->children_capacity = header->num_children;
+    program->num_numbers = program->numbers_capacity = header->num_numbers;
+    program->num_strings = program->strings_capacity = header->num_strings;
+    program->num_chars = program->chars_capacity = header->num_chars;
+    program->num_functions = program->functions_capacity = header->num_functions;
+    program->nodes = (TORAFlatNode *)(image + header->nodes);
+    program->children = (uint32_t *)(image + header->children);
+    program->numbers = (double *)(image + header->numbers);
+    program->strings = (uint32_t *)(image + header->strings);
+    program->chars = image + header->chars;
+    program->functions = functions;
+    
+    flat_program_create_values(program);
+    return program;
+}
+
+// Sections
+uint64_t image_align(uint64_t offset)
+{
+    return (offset + 7) & ~(uint64_t)7;
+}
+bool image_section_fits(TORAImageHeader *header, uint64_t offset, uint32_t count, size_t item_size)
+{
+    return offset >= sizeof(TORAImageHeader) && offset % 8 == 0 &&
+           offset <= header->image_length && (uint64_t)count * item_size <= header->image_length - offset;
+}
+bool image_write(int fd, const void *data, uint64_t length)
+{
+    const char *bytes = data;
+    while(length > 0)
+    {
+        ssize_t result = write(fd, bytes, (size_t)length);
+        if(result <= 0)
+        {
+            return false;
+        }
+        bytes += result;
+        length -= (uint64_t)result;
+    }
+    return true;
+}
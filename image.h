@@ -0,0 +1,69 @@
+//
+//  image.h
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#ifndef image_h
+#define image_h
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "flat.h"
+
+// A program image is a flat program's pools written out as they are, preceded by
+// a header identifying the source it was built from and the interpreter that built
+// it. The pools hold no pointers, so loading an image is a matter of checking its
+// header and mapping it. Sections are 8 byte aligned, and a mapped image is
+// evaluated in place without ever being written to, so any number of processes
+// running the same program share one copy of it
+#define TORA_IMAGE_MAGIC "TORA"
+#define TORA_IMAGE_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char magic[4];
+    uint32_t byte_order;
+    uint32_t header_size;
+    char version[16];
+    uint64_t source_hash;
+    uint64_t source_length;
+    uint64_t image_length;
+    
+    TORAFlatIndex root;
+    uint32_t globals;
+    uint32_t constants;
+    
+    uint32_t num_nodes;
+    uint32_t num_children;
+    uint32_t num_numbers;
+    uint32_t num_strings;
+    uint32_t num_chars;
+    uint32_t num_functions;
+    
+    // Each section's offset from the start of the image
+    uint64_t nodes;
+    uint64_t children;
+    uint64_t numbers;
+    uint64_t strings;
+    uint64_t chars;
+    uint64_t functions;
+} TORAImageHeader;
+
+// Images are cached next to their source (file.tora's in file.torac), or in
+// cache_dir named after the source's hash when one's given
+char *image_cache_path(const char *source, const char *cache_dir, uint64_t source_hash);
+bool image_cache_writable(const char *path);
+
+// Loading returns NULL if there's no image at path, or it was built from a different
+// source or by a different version of the interpreter. image_load_any accepts an
+// image built from any source, for running images without their sources. Saving
+// fails for a program whose functions haven't all been parsed
+TORAFlatProgram *image_load(const char *path, uint64_t source_hash, uint64_t source_length);
+TORAFlatProgram *image_load_any(const char *path);
+bool image_save(TORAFlatProgram *program, const char *path, uint64_t source_hash, uint64_t source_length);
+
+#endif /* image_h */
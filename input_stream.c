@@ -7,34 +7,92 @@
 //
 
 #include <stdlib.h>
+#include <string.h>
 #include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "tora.h"
 
-char *get_file_contents(const char *filename, unsigned long *length);
+// Streamed input is read in chunks of at least this many bytes
+#define TORA_INPUT_STREAM_CHUNK_SIZE (64 * 1024)
+
+TORAInputStream *input_stream_create(const char *contents, unsigned long length, size_t mapped_length);
+char *get_file_contents(int fd, unsigned long *length, size_t *mapped_length);
+char *map_file_contents(int fd, unsigned long length, size_t *mapped_length);
+char *read_file_contents(int fd, unsigned long *length);
 
 // Input stream
 TORAInputStream *input_stream_from_file_contents(const char *filename)
 {
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0)
+    {
+        return NULL;
+    }
+    
+    // Pipes, terminals and the like can't be sized (or mapped) up front, so we
+    // read them through a sliding window as the lexer asks for more input
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode))
+    {
+        return input_stream_from_fd(fd);
+    }
+    
     unsigned long contents_length = 0;
+    size_t mapped_length = 0;
+    
+    const char *contents = get_file_contents(fd, &contents_length, &mapped_length);
+    close(fd);
     
-    const char *contents = get_file_contents(filename, &contents_length);
     if(contents)
     {
-        TORAInputStream *stream = tora_malloc(sizeof(TORAInputStream));
-        if(stream)
-        {
-            stream->pos = 0;
-            stream->line = 1;
-            stream->col = 0;
-            stream->contents = contents;
-            stream->length = contents_length;
-            
-            return stream;
-        }
+        return input_stream_create(contents, contents_length, mapped_length);
     }
     return NULL;
 }
+// Creates a streamed input stream which reads from fd as needed, taking
+// ownership of the file descriptor
+TORAInputStream *input_stream_from_fd(int fd)
+{
+    char *buffer = tora_malloc(TORA_INPUT_STREAM_CHUNK_SIZE + 1);
+    if(!buffer)
+    {
+        close(fd);
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for input stream buffer");
+    }
+    buffer[0] = '\0';
+    
+    TORAInputStream *stream = input_stream_create(buffer, 0, 0);
+    if(stream)
+    {
+        stream->fd = fd;
+        stream->capacity = TORA_INPUT_STREAM_CHUNK_SIZE;
+    }
+    return stream;
+}
+TORAInputStream *input_stream_create(const char *contents, unsigned long length, size_t mapped_length)
+{
+    TORAInputStream *stream = tora_malloc(sizeof(TORAInputStream));
+    if(stream)
+    {
+        stream->pos = 0;
+        stream->line = 1;
+        stream->col = 0;
+        stream->contents = contents;
+        stream->length = length;
+        stream->mapped_length = mapped_length;
+        
+        stream->fd = -1;
+        stream->base = 0;
+        stream->retain_pos = 0;
+        stream->capacity = length;
+    }
+    return stream;
+}
 
 // Internal logic
 char input_stream_next_char(TORAInputStream *stream)
@@ -42,7 +100,12 @@ char input_stream_next_char(TORAInputStream *stream)
     assert(stream);
     assert(stream->contents);
     
-    char next_char = stream->contents[stream->pos];
+    if(stream->pos >= stream->length && !input_stream_refill(stream))
+    {
+        return '\0';
+    }
+    
+    char next_char = stream->contents[stream->pos - stream->base];
     if(next_char == '\n')
     {
         stream->line++;
@@ -58,38 +121,236 @@ char input_stream_next_char(TORAInputStream *stream)
 }
 char input_stream_peek(TORAInputStream *stream)
 {
-    return stream->contents[stream->pos];
+    if(stream->pos >= stream->length)
+    {
+        input_stream_refill(stream);
+    }
+    return stream->contents[stream->pos - stream->base];
+}
+// Moves the head position along by count bytes in one go, keeping our line
+// and column tracking in step with what input_stream_next_char would produce
+void input_stream_advance(TORAInputStream *stream, uint64_t count)
+{
+    assert(stream->pos + count <= stream->length);
+    
+    const char *start = input_stream_cursor(stream);
+    const char *end = start + count;
+    const char *last_newline = NULL;
+    
+    uint64_t newlines = tora_scan.count_newlines(start, end, &last_newline);
+    if(newlines)
+    {
+        stream->line += newlines;
+        stream->col = (uint64_t)(end - last_newline - 1);
+    }
+    else
+    {
+        stream->col += count;
+    }
+    stream->pos += count;
+}
+// Pointers to the current head position and the end of our buffered contents, used
+// by the lexer to hand whole runs of bytes to the scanning kernels. A run which reaches
+// the limit of a streamed input may continue once the stream has been refilled
+const char *input_stream_cursor(TORAInputStream *stream)
+{
+    return stream->contents + (stream->pos - stream->base);
+}
+const char *input_stream_limit(TORAInputStream *stream)
+{
+    return stream->contents + (stream->length - stream->base);
 }
 bool input_stream_eof(TORAInputStream *stream)
 {
-    return stream->pos >= stream->length;
+    return stream->pos >= stream->length && !input_stream_refill(stream);
+}
+
+// Streamed input
+// Reads more input into our window, returning false once there's nothing left to read.
+// Anything before both retain_pos and the head position is discarded to make room, and
+// the window only grows when the bytes we've been asked to keep won't leave space for
+// a full chunk, so memory use is bounded by the longest token rather than the source
+bool input_stream_refill(TORAInputStream *stream)
+{
+    if(stream->fd < 0)
+    {
+        return false;
+    }
+    
+    char *buffer = (char *)stream->contents;
+    uint64_t keep_pos = stream->retain_pos < stream->pos ? stream->retain_pos : stream->pos;
+    if(keep_pos > stream->base)
+    {
+        size_t discard = (size_t)(keep_pos - stream->base);
+        memmove(buffer, buffer + discard, (size_t)(stream->length - keep_pos));
+        stream->base = keep_pos;
+    }
+    
+    size_t buffered = (size_t)(stream->length - stream->base);
+    if(stream->capacity - buffered < TORA_INPUT_STREAM_CHUNK_SIZE)
+    {
+        size_t capacity = stream->capacity * 2;
+        while(capacity - buffered < TORA_INPUT_STREAM_CHUNK_SIZE) capacity *= 2;
+        
+        char *resized_buffer = realloc(buffer, capacity + 1);
+        if(!resized_buffer)
+        {
+            TORA_RUNTIME_EXCEPTION("Failed to realloc space for input stream buffer");
+        }
+        buffer = resized_buffer;
+        stream->contents = buffer;
+        stream->capacity = capacity;
+    }
+    
+    ssize_t bytes_read;
+    do
+    {
+        bytes_read = read(stream->fd, buffer + buffered, stream->capacity - buffered);
+    }
+    while(bytes_read < 0 && errno == EINTR);
+    
+    if(bytes_read < 0)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to read from input stream");
+    }
+    else if(bytes_read == 0)
+    {
+        // Nothing more will be coming, so stop trying
+        close(stream->fd);
+        stream->fd = -1;
+        return false;
+    }
+    
+    stream->length += (uint64_t)bytes_read;
+    buffer[stream->length - stream->base] = '\0';
+    return true;
+}
+// Makes sure at least count bytes past the head position are buffered, refilling
+// streamed input as needed. Returns false if our input ends before then
+bool input_stream_ensure(TORAInputStream *stream, uint64_t count)
+{
+    while(stream->length - stream->pos < count)
+    {
+        if(!input_stream_refill(stream))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+// Lets a streamed input stream discard everything before pos the next time it
+// needs to refill. Bytes at or after the head position are never discarded
+void input_stream_retain_from(TORAInputStream *stream, uint64_t pos)
+{
+    stream->retain_pos = pos;
+}
+bool input_stream_is_streamed(TORAInputStream *stream)
+{
+    return stream->fd >= 0;
 }
 
 // Helpers
 void free_input_stream(TORAInputStream *stream)
 {
-    tora_free((void *)stream->contents);
+    if(stream->fd >= 0)
+    {
+        close(stream->fd);
+    }
+    
+    if(stream->mapped_length)
+    {
+        munmap((void *)stream->contents, stream->mapped_length);
+    }
+    else
+    {
+        tora_free((void *)stream->contents);
+    }
     tora_free(stream);
 }
-char *get_file_contents(const char *filename, unsigned long *length)
+// Regular files are memory mapped so the page cache can serve them directly,
+// anything we fail to map is read into a heap buffer instead. Either way
+// the returned contents are followed by a '\0' sentinel byte
+char *get_file_contents(int fd, unsigned long *length, size_t *mapped_length)
 {
     char *buffer = NULL;
+    *mapped_length = 0;
+    
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) == 0 && file_stat.st_size > 0)
+    {
+        *length = (unsigned long)file_stat.st_size;
+        buffer = map_file_contents(fd, *length, mapped_length);
+    }
+    
+    if(!buffer)
+    {
+        buffer = read_file_contents(fd, length);
+    }
+    
+    return buffer;
+}
+char *map_file_contents(int fd, unsigned long length, size_t *mapped_length)
+{
+    // Reserve enough zeroed pages to hold the file plus our sentinel byte, then map the
+    // file over the start of that reservation. The kernel zero fills whatever is left of
+    // the file's final page, and if the file ends exactly on a page boundary the sentinel
+    // lands in the extra anonymous page instead, so contents[length] is always '\0'
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t reserved_length = ((size_t)length + 1 + page_size - 1) / page_size * page_size;
+    
+    char *reservation = mmap(NULL, reserved_length, PROT_READ, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if(reservation == MAP_FAILED)
+    {
+        return NULL;
+    }
     
-    FILE *fp = fopen(filename, "rb");
-    if(fp)
+    char *contents = mmap(reservation, (size_t)length, PROT_READ, MAP_PRIVATE|MAP_FIXED, fd, 0);
+    if(contents == MAP_FAILED)
     {
-        fseek(fp, 0, SEEK_END);
-        *length = (unsigned long)ftell(fp);
-        fseek(fp, 0, SEEK_SET);
+        munmap(reservation, reserved_length);
+        return NULL;
+    }
+    
+    // We lex the file from front to back exactly once
+    madvise(contents, (size_t)length, MADV_SEQUENTIAL);
+    
+    *mapped_length = reserved_length;
+    return contents;
+}
+char *read_file_contents(int fd, unsigned long *length)
+{
+    size_t buffer_size = 4096;
+    size_t buffer_length = 0;
+    char *buffer = tora_malloc(buffer_size);
+    if(!buffer)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for source file contents");
+    }
+    
+    while(true)
+    {
+        // Always leave room for our sentinel byte
+        if(buffer_length + 1 >= buffer_size)
+        {
+            buffer_size *= 2;
+            char *resized_buffer = realloc(buffer, buffer_size);
+            if(!resized_buffer)
+            {
+                tora_free(buffer);
+                TORA_RUNTIME_EXCEPTION("Failed to realloc space for source file contents");
+            }
+            buffer = resized_buffer;
+        }
         
-        buffer = tora_malloc(*length * sizeof(char));
-        if(!buffer)
+        ssize_t bytes_read = read(fd, buffer + buffer_length, buffer_size - buffer_length - 1);
+        if(bytes_read <= 0)
         {
-            TORA_RUNTIME_EXCEPTION("Failed to malloc space for source file contents");
+            break;
         }
-        fread(buffer, 1, *length, fp);
-        fclose(fp);
+        buffer_length += (size_t)bytes_read;
     }
     
+    buffer[buffer_length] = '\0';
+    *length = (unsigned long)buffer_length;
     return buffer;
 }
\ No newline at end of file
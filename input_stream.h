@@ -11,19 +11,40 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 
+// pos and length are absolute offsets into the source, and contents holds the
+// bytes from base up to length followed by a '\0' sentinel byte. Files are read
+// in one go (base is always 0), and when the source was memory mapped mapped_length
+// holds the size of the mapping to unmap. Streamed input (fd >= 0) is instead read
+// through a sliding window: refilling it may discard anything before retain_pos
+// and move contents, so pointers into it are only valid until the next refill
 typedef struct {
     uint64_t pos;
     uint64_t line;
     uint64_t col;
     unsigned long length;
     const char *contents;
+    size_t mapped_length;
+    
+    int fd;
+    uint64_t base;
+    uint64_t retain_pos;
+    size_t capacity;
 } TORAInputStream;
 
 TORAInputStream *input_stream_from_file_contents(const char *filename);
+TORAInputStream *input_stream_from_fd(int fd);
 char input_stream_next_char(TORAInputStream *stream);
 char input_stream_peek(TORAInputStream *stream);
+void input_stream_advance(TORAInputStream *stream, uint64_t count);
+const char *input_stream_cursor(TORAInputStream *stream);
+const char *input_stream_limit(TORAInputStream *stream);
 bool input_stream_eof(TORAInputStream *stream);
+bool input_stream_refill(TORAInputStream *stream);
+bool input_stream_ensure(TORAInputStream *stream, uint64_t count);
+void input_stream_retain_from(TORAInputStream *stream, uint64_t pos);
+bool input_stream_is_streamed(TORAInputStream *stream);
 void free_input_stream(TORAInputStream *stream);
 
 #endif /* defined(__tora__char_stream__) */
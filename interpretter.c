@@ -11,23 +11,35 @@
 #include <math.h>
 #include "interpretter.h"
 
-void *environment_set_var(TORAEnvironment *environment, TORAParserUnknownExpression *key, TORAParserUnknownExpression *val);
-TORALinkedList *environment_get_var(TORAEnvironment *environment, char *name, bool search_parent_scope);
+// Environments
+void environment_set_slot(TORAEnvironment *environment, uint32_t slot, void *val);
+void *environment_set_var(TORAFlatProgram *program, TORAFlatIndex variable, TORAEnvironment *environment, TORAParserUnknownExpression *val);
+void *environment_get_var(TORAFlatProgram *program, TORAFlatIndex variable, TORAEnvironment *environment);
+void *environment_find_var(TORAFlatProgram *program, TORAEnvironment *environment, uint32_t name);
+uint32_t environment_variable_name(TORAFlatProgram *program, TORAFlatIndex variable, TORAEnvironment *environment);
+TORAFlatFunctionValue *create_function_value(TORAFlatIndex function, TORAEnvironment *environment);
 
-void *apply_op(char *op, TORAParserUnknownExpression *a, TORAParserUnknownExpression *b, TORAEnvironment *environment);
 void *concat_expressions(TORAParserUnknownExpression *a, TORAParserUnknownExpression *b);
 bool expressions_are_equal(TORAParserUnknownExpression *a, TORAParserUnknownExpression *b);
-void *maybe_standard_lib_call(char *method, TORALinkedList *arguments, TORAEnvironment *environment);
+void *call_function(TORAFlatProgram *program, TORAFlatFunctionValue *function_value, uint32_t *arguments, TORAEnvironment *environment, bool *return_encountered);
 
 // Helpers
 bool expression_is_truthy(TORAParserUnknownExpression *exp);
 TORALinkedList *get_array_value_for_key(TORAParserArrayExpression *array, TORAParserUnknownExpression *key);
-TORAParserArrayExpression *get_array_for_index_expression(TORAParserArrayIndexExpression *index_expression, TORAEnvironment *environment);
-void *string_representation_for_expression(void *expression);
+TORAParserArrayExpression *get_array_for_index_expression(TORAFlatProgram *program, TORAFlatIndex index_expression, TORAEnvironment *environment);
 
-TORAEnvironment *create_environment(TORAEnvironment *parent)
+// Evaluating a boolean literal (or a loop or if statement without a result) hands
+// out one of these rather than allocating a new value
+TORAParserBoolExpression tora_true_value = { TORAInstanceTypeExpression, TORA_REF_COUNT_IMMORTAL, TORAExpressionTypeBoolean, true };
+TORAParserBoolExpression tora_false_value = { TORAInstanceTypeExpression, TORA_REF_COUNT_IMMORTAL, TORAExpressionTypeBoolean, false };
+
+TORAEnvironment *create_environment(TORAEnvironment *parent, TORAFlatProgram *program, uint32_t names)
 {
-    TORAEnvironment *environment = tora_malloc(sizeof(TORAEnvironment));
+    assert(program);
+    assert(names != TORA_FLAT_NONE);
+    
+    uint32_t num_slots = program->children[names];
+    TORAEnvironment *environment = tora_malloc(sizeof(TORAEnvironment) + num_slots * sizeof(void *));
     if(!environment)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for environment");
@@ -36,91 +48,65 @@ TORAEnvironment *create_environment(TORAEnvironment *parent)
     environment->ref_count = 0;
     
     environment->parent = parent;
-    environment->var_list_head = NULL;
-    environment->var_list_tail = NULL;
+    environment->global = parent ? parent->global : environment;
+    environment->names = names;
+    environment->num_slots = num_slots;
+    memset(environment->slots, 0, num_slots * sizeof(void *));
     
     queue_raw_item(&environment_queue, NULL, environment);
     return environment;
 }
-void environment_define_var(TORAEnvironment *environment, char *name, void *val, bool local_declaration)
+void environment_set_slot(TORAEnvironment *environment, uint32_t slot, void *val)
 {
     assert(environment);
-    assert(name);
+    assert(slot < environment->num_slots);
     assert(val);
     
-    // If a variable with this name already exists, set it's value and then bail out
-    TORALinkedList *var = environment_get_var(environment, name, !local_declaration);
-    if(var)
+    // Retain before releasing, in case we're reassigning the value already held
+    tora_retain(val);
+    if(environment->slots[slot])
     {
-        tora_release(var->value);
-        var->value = tora_retain(val);
-        return;
+        tora_release(environment->slots[slot]);
     }
-    
-    // Otherwise create a new link in our vars linked list and stash the value away
-    TORALinkedList *item = tora_malloc(sizeof(TORALinkedList));
-    if(!item)
-    {
-        TORA_RUNTIME_EXCEPTION("Failed to malloc space for environment variable list item");
-    }
-    item->instance_type = TORAInstanceTypeLinkedList;
-    item->ref_count = 0;
-   
-    item->name = tora_retain(new_string_expression(name));
-    item->value = tora_retain(val);
-    item->next = NULL;
-    
-    // Assign this item as the head of our environment variables list if no other
-    // variables have been declared, and likewise point the tail item towards it
-    if(environment->var_list_head == NULL)
-    {
-        environment->var_list_head = item;
-        environment->var_list_tail = item;
-    }
-    // If we already have an established list of variables add this to our tail
-    // and set our tail to point to the new item
-    else
-    {
-        environment->var_list_tail->next = item;
-        environment->var_list_tail = item;
-    }
-    tora_retain(item);
+    environment->slots[slot] = val;
 }
-void *environment_set_var(TORAEnvironment *environment, TORAParserUnknownExpression *variable, TORAParserUnknownExpression *val)
+void *environment_set_var(TORAFlatProgram *program, TORAFlatIndex variable, TORAEnvironment *environment, TORAParserUnknownExpression *val)
 {
     assert(environment);
-    assert(variable);
+    assert(variable != TORA_FLAT_NONE);
     assert(val);
     
-    void *key = NULL;
+    // The resolver gives everything assigned to a slot in the assigning scope, so
+    // all we need to find is which one
+    uint32_t slot = TORA_FLAT_NONE;
+    TORAFlatNode *variable_node = &program->nodes[variable];
     
-    // We need to derive a 'name' (key) for this variable assignment. Depending on whether we've been passed
-    // a variable on the left-side of the assignment, or an array index look-up we need to perform some alternative logic
-    if(variable->type == TORAExpressionTypeVariable)
+    if(variable_node->type == TORAExpressionTypeVariable)
     {
-        // If we're assigning to a standard variable, i.e: a = 1,
-        // we just need to ask the left-side variable expression for it's 'val'
-        // which in the case of the above example will be 'a'.
-        key = ((TORAParserVariableExpression *)variable)->val;
+        // If we're assigning to a standard variable, i.e: a = 1, that's its own slot
+        assert(variable_node->op == 0);
+        slot = variable_node->val;
     }
     // This is an array look-up
-    else if(variable->type == TORAExpressionTypeArrayIndex)
+    else if(variable_node->type == TORAExpressionTypeArrayIndex)
     {
         // Assigning to an array index, i.e: a[2] = 1, is slightly more complex...
-        TORAParserArrayIndexExpression *array_index_expression = (TORAParserArrayIndexExpression *)variable;
-        TORAParserUnknownExpression *array_ref_expression = array_index_expression->array;
-        if(array_ref_expression->type == TORAExpressionTypeVariable)
+        uint32_t *children = flat_program_children(program, variable_node->val);
+        TORAFlatNode array_ref_node = program->nodes[children[0]];
+        if(array_ref_node.type == TORAExpressionTypeVariable)
         {
-            // key here relates to the lookup offset, i.e: a[2] name will = 2
-            key = evaluate(array_index_expression->index, environment, NULL);
-
+            // index here relates to the lookup offset, i.e: a[2] index will = 2
+            void *index = evaluate(program, children[1], environment, NULL);
+            
             // Next we use the look-up expression to grab the current defined value for the variable 'a'.
-            TORAParserArrayExpression *array_expression = get_array_for_index_expression(array_index_expression, environment);
+            assert(array_ref_node.op == 0);
+            slot = array_ref_node.val;
+            TORAParserArrayExpression *array_expression = get_array_for_index_expression(program, variable, environment);
             if(array_expression)
             {
                 // Then we use a helper function to grab a pointer to the value stored at the offset our
                 // array index expression points to, i.e: 2.
-                TORALinkedList *array_val = get_array_value_for_key(array_expression, key);
+                TORALinkedList *array_val = get_array_value_for_key(array_expression, index);
                 if(array_val)
                 {
                     tora_release(array_val->value);
@@ -133,7 +119,7 @@ void *environment_set_var(TORAEnvironment *environment, TORAParserUnknownExpress
                     {
                         TORA_RUNTIME_EXCEPTION("Failed to malloc space for new array list item");
                     }
-                    new_array_val->name = tora_retain(key);
+                    new_array_val->name = tora_retain(index);
                     new_array_val->value = tora_retain(val);
                     new_array_val->next = NULL;
                     new_array_val->ref_count = 0;
@@ -169,114 +155,176 @@ void *environment_set_var(TORAEnvironment *environment, TORAParserUnknownExpress
         TORA_INTERPRETTER_EXCEPTION("Attempting value set on invalid left-hand expression");
     }
     
-    environment_define_var(environment, key, val, true);
+    environment_set_slot(environment, slot, val);
     return val;
 }
-TORALinkedList *environment_get_var(TORAEnvironment *environment, char *name, bool search_parent_scope)
+void *environment_get_var(TORAFlatProgram *program, TORAFlatIndex variable, TORAEnvironment *environment)
 {
     assert(environment);
-    assert(name);
     
-    TORALinkedList *cur_item = environment->var_list_head;
-    while(cur_item)
+    TORAFlatNode *variable_node = &program->nodes[variable];
+    if(variable_node->op == TORA_FLAT_SCOPE_GLOBAL)
     {
-        TORAParserStringExpression *key = (TORAParserStringExpression *)cur_item->name;
-        if(key && key->type == TORAExpressionTypeString && strcmp(key->val, name) == 0)
+        environment = environment->global;
+    }
+    else if(variable_node->op == TORA_FLAT_SCOPE_UNRESOLVED)
+    {
+        return NULL;
+    }
+    else
+    {
+        for(uint8_t depth = variable_node->op; depth > 0; depth--)
         {
-            return cur_item;
+            environment = environment->parent;
         }
-        cur_item = cur_item->next;
     }
     
-    if(environment->parent && search_parent_scope)
+    // Until a variable's been assigned to in the environment binding it, the name
+    // refers to whatever holds it further up the chain
+    void *val = environment->slots[variable_node->val];
+    if(!val && environment->parent)
     {
-        return environment_get_var(environment->parent, name, search_parent_scope);
+        val = environment_find_var(program, environment->parent, program->children[environment->names + 1 + variable_node->val]);
+    }
+    return val;
+}
+void *environment_find_var(TORAFlatProgram *program, TORAEnvironment *environment, uint32_t name)
+{
+    for(; environment; environment = environment->parent)
+    {
+        uint32_t *names = program->children + environment->names;
+        for(uint32_t i = 0; i < names[0]; i++)
+        {
+            if(names[1 + i] == name && environment->slots[i])
+            {
+                return environment->slots[i];
+            }
+        }
     }
     return NULL;
 }
+uint32_t environment_variable_name(TORAFlatProgram *program, TORAFlatIndex variable, TORAEnvironment *environment)
+{
+    TORAFlatNode *variable_node = &program->nodes[variable];
+    if(variable_node->op == TORA_FLAT_SCOPE_GLOBAL)
+    {
+        return program->children[program->globals + 1 + variable_node->val];
+    }
+    else if(variable_node->op == TORA_FLAT_SCOPE_UNRESOLVED)
+    {
+        return variable_node->val;
+    }
+    
+    for(uint8_t depth = variable_node->op; depth > 0; depth--)
+    {
+        environment = environment->parent;
+    }
+    return program->children[environment->names + 1 + variable_node->val];
+}
+TORAFlatFunctionValue *create_function_value(TORAFlatIndex function, TORAEnvironment *environment)
+{
+    // Environments live until the environment queue's drained, which outlasts any
+    // value, so the function's environment doesn't need retaining
+    TORAFlatFunctionValue *function_value = tora_malloc(sizeof(TORAFlatFunctionValue));
+    if(!function_value)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for function value");
+    }
+    function_value->instance_type = TORAInstanceTypeGeneric;
+    function_value->ref_count = 0;
+    function_value->type = TORAExpressionTypeFunction;
+    function_value->function = function;
+    function_value->environment = environment;
+    
+    queue_raw_item(&interpretter_queue, NULL, function_value);
+    return function_value;
+}
 void free_environment(TORAEnvironment *environment)
 {
     assert(environment);
     
-    if(environment->var_list_head)
+    for(uint32_t i = 0; i < environment->num_slots; i++)
     {
-        tora_release(environment->var_list_head);
-        environment->var_list_head = NULL;
+        if(environment->slots[i])
+        {
+            tora_release(environment->slots[i]);
+            environment->slots[i] = NULL;
+        }
     }
-    environment->var_list_tail = NULL;
     
     tora_free(environment);
 }
 
 // Evaluator
-void* evaluate(void *expression, TORAEnvironment *environment, bool *return_encountered)
+void* evaluate(TORAFlatProgram *program, TORAFlatIndex expression, TORAEnvironment *environment, bool *return_encountered)
 {
-    assert(expression);
+    assert(program);
+    assert(expression != TORA_FLAT_NONE);
     assert(environment);
     
-    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
-    switch(unknown_expression->type)
+    // Functions are parsed as they're first called, which can move any of the
+    // program's pools, so nothing's held from them across evaluating another node
+    TORAFlatNode node = program->nodes[expression];
+    switch(node.type)
     {
         case TORAExpressionTypeString:
-        case TORAExpressionTypeBoolean:
+            return program->string_values[node.val];
+            break;
         case TORAExpressionTypeNumeric:
-            return expression;
-            break;        
+            return program->number_values[node.val];
+            break;
+        case TORAExpressionTypeBoolean:
+            return node.val ? &tora_true_value : &tora_false_value;
+            break;
         case TORAExpressionTypeVariable:
         {
-            TORAParserVariableExpression *variable_expression = (TORAParserVariableExpression *)expression;
-            TORALinkedList *val = environment_get_var(environment, variable_expression->val, true);
-            if(val)
-            {
-                return val->value;
-            }
-            else
-            {
-                return NULL;
-                //TORA_INTERPRETTER_EXCEPTION("Undefined variable: %s", ((TORAParserVariableExpression *)expression)->val);
-            }
+            return environment_get_var(program, expression, environment);
+            //TORA_INTERPRETTER_EXCEPTION("Undefined variable: %s", flat_program_string(program, environment_variable_name(program, expression, environment)));
         }
             break;
         
         case TORAExpressionTypeArrayIndex:
         {
-            TORAParserArrayExpression *array_expression = get_array_for_index_expression((TORAParserArrayIndexExpression*)expression, environment);
-            TORAParserUnknownExpression *key = evaluate(((TORAParserArrayIndexExpression*)expression)->index, environment, NULL);
-
+            TORAFlatIndex key_index = program->children[node.val + 1];
+            TORAParserArrayExpression *array_expression = get_array_for_index_expression(program, expression, environment);
+            TORAParserUnknownExpression *key = evaluate(program, key_index, environment, NULL);
+            
+            // Array values are evaluated as they're stored, so can be returned as they are
             TORALinkedList *val = get_array_value_for_key(array_expression, key);
             if(val)
             {
-                void *result = evaluate(val->value, environment, NULL);
-                queue_raw_item(&interpretter_queue, NULL, result);
-                return result;
+                return val->value;
             }
         }
             break;
-            
+        
         case TORAExpressionTypeAssign:
         {
-            TORAParserAssignOrBinaryExpression *assign_expression = (TORAParserAssignOrBinaryExpression *)expression;
-            TORAParserUnknownExpression *left_expression = (TORAParserUnknownExpression *)assign_expression->left;
+            uint32_t *children = flat_program_children(program, node.val);
+            TORAFlatIndex left = children[0];
+            TORAFlatIndex right = children[1];
             
             // Only allow us to assign values to variables or array look-ups
-            if(left_expression->type != TORAExpressionTypeVariable &&
-               left_expression->type != TORAExpressionTypeArrayIndex)
+            uint8_t left_type = program->nodes[left].type;
+            if(left_type != TORAExpressionTypeVariable &&
+               left_type != TORAExpressionTypeArrayIndex)
             {
-                TORA_INTERPRETTER_EXCEPTION("Cannot assign to values of this type: %i", left_expression->type);
+                TORA_INTERPRETTER_EXCEPTION("Cannot assign to values of this type: %i", left_type);
             }
             
-            void *right_expression = evaluate(assign_expression->right, environment, NULL);
-            return environment_set_var(environment, left_expression, right_expression);
+            void *right_expression = evaluate(program, right, environment, NULL);
+            return environment_set_var(program, left, environment, right_expression);
         }
             break;
-
+        
         case TORAExpressionTypeBinary:
         {
-            TORAParserAssignOrBinaryExpression *binary_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            uint32_t *children = flat_program_children(program, node.val);
+            TORAFlatIndex right_index = children[1];
             
-            void *left = evaluate(binary_expression->left, environment, NULL);
-            void *right = evaluate(binary_expression->right, environment, NULL);
-            void *result = apply_op(binary_expression->op, left, right, environment);
+            void *left = evaluate(program, children[0], environment, NULL);
+            void *right = evaluate(program, right_index, environment, NULL);
+            void *result = apply_op((TORATokenKind)node.op, left, right);
             if(result)
             {
                 queue_raw_item(&interpretter_queue, NULL, result);
@@ -284,28 +332,33 @@ void* evaluate(void *expression, TORAEnvironment *environment, bool *return_enco
             return result;
         }
             break;
-            
+        
         case TORAExpressionTypeLambda:
         {
-            TORAParserLambdaExpression *lamda_expression = (TORAParserLambdaExpression *)expression;
-            if(lamda_expression->name)
+            TORAFlatFunction *function = &program->functions[node.val];
+            TORAFlatFunctionValue *function_value = program->function_values[node.val];
+            if(environment != environment->global)
             {
-                environment_define_var(environment, lamda_expression->name, expression, true);
+                function_value = create_function_value(node.val, environment);
             }
-            return expression;
+            if(function->slot != TORA_FLAT_NONE)
+            {
+                environment_set_slot(environment, function->slot, function_value);
+            }
+            return function_value;
         }
             break;
-            
+        
         case TORAExpressionTypeProg:
         {
-            TORAParserProgExpression *prog_expression = (TORAParserProgExpression *)expression;
-            TORALinkedList *cur_expression = prog_expression->val;
+            uint32_t *children = flat_program_children(program, node.val);
+            uint32_t num_statements = children[0];
             void *val = NULL;
             
             bool return_encountered_in_prog = false;
-            while(cur_expression)
+            for(uint32_t i = 1; i <= num_statements; i++)
             {
-                val = evaluate(cur_expression->value, environment, &return_encountered_in_prog);
+                val = evaluate(program, program->children[node.val + i], environment, &return_encountered_in_prog);
                 if(val)
                 {
                     queue_raw_item(&interpretter_queue, NULL, val);
@@ -317,112 +370,188 @@ void* evaluate(void *expression, TORAEnvironment *environment, bool *return_enco
                         return val;
                     }
                 }
-                
-                // Otherwise continue parsing the prog
-                cur_expression = cur_expression->next;
             }
             
             if(!val)
             {
-                val = new_boolean_expression(false);
-                queue_raw_item(&interpretter_queue, NULL, val);
+                val = &tora_false_value;
             }
             return val;
         }
             break;
         case TORAExpressionTypeReturn:
         {
-            TORAParserReturnExpression *return_expression = (TORAParserReturnExpression *)expression;
-            
             // Signals to evaluate() callers up the chain that we've encountered a return node
             if(return_encountered) *return_encountered = true;
-            return evaluate(return_expression->expression, environment, NULL);
+            return evaluate(program, node.val, environment, NULL);
         }
             break;
         case TORAExpressionTypeNegativeUnary:
         {
-            TORAParserNegativeUnaryExpression *negative_expression = (TORAParserNegativeUnaryExpression *)expression;
-            TORAParserUnknownExpression *val = (TORAParserUnknownExpression *)evaluate(negative_expression->expression, environment, NULL);
-            if(val->type == TORAExpressionTypeNumeric)
-            {
-                ((TORAParserNumericExpression *)val)->val *= -1;
-            }
-            else
+            TORAParserUnknownExpression *val = (TORAParserUnknownExpression *)evaluate(program, node.val, environment, NULL);
+            if(!val || val->type != TORAExpressionTypeNumeric)
             {
                 TORA_INTERPRETTER_EXCEPTION("Attempted to negate a non-numeric value");
             }
-            return val;
+            
+            // The value we've been handed may well be a literal from the program or one stored in
+            // a variable, so rather than negating it in place we always produce a new value
+            void *result = new_numeric_expression(-((TORAParserNumericExpression *)val)->val);
+            queue_raw_item(&interpretter_queue, NULL, result);
+            return result;
         }
             break;
         case TORAExpressionTypeArray:
         {
-            // Iterate over our array and evaluate each of it's values
-            // This is necessary when returning arrays from functions
-            // due to the fact that they can contain locally scoped variables
-            TORALinkedList *cur = ((TORAParserArrayExpression *)expression)->val;
-            while(cur)
-            {
-                void *old_value = cur->value;
-                void *new_value = evaluate(cur->value, environment, NULL);
-                cur->value = tora_retain(new_value);
-                tora_release(old_value);
-                cur = cur->next;
-            } 
-            return expression;
+            // Array literals are evaluated into a new array each time they're encountered,
+            // with each of their values evaluated in the current environment. This is
+            // necessary when returning arrays from functions due to the fact that they can
+            // contain locally scoped variables, and leaves the program itself untouched
+            uint32_t num_items = program->children[node.val];
+            TORALinkedList *head = NULL;
+            TORALinkedList *tail = NULL;
+            for(uint32_t i = 0; i < num_items; i++)
+            {
+                TORALinkedList *item = tora_malloc(sizeof(TORALinkedList));
+                if(!item)
+                {
+                    TORA_RUNTIME_EXCEPTION("Failed to malloc space for array list item");
+                }
+                item->instance_type = TORAInstanceTypeLinkedList;
+                item->ref_count = 0;
+                item->next = NULL;
+                
+                uint32_t *pair = flat_program_children(program, node.val + 1 + i * 2);
+                TORAFlatIndex value = pair[1];
+                item->name = tora_retain(evaluate(program, pair[0], environment, NULL));
+                item->value = tora_retain(evaluate(program, value, environment, NULL));
+                
+                if(tail)
+                {
+                    tail->next = tora_retain(item);
+                }
+                else
+                {
+                    head = item;
+                }
+                tail = item;
+            }
+            
+            void *result = new_array_expression(head);
+            queue_raw_item(&interpretter_queue, NULL, result);
+            return result;
         }
             break;
-            
+        
         case TORAExpressionTypeCall:
         {
-            TORAParserCallExpression *call_expression = (TORAParserCallExpression *)expression;
-            TORAParserLambdaExpression *function_expression = (TORAParserLambdaExpression *)evaluate(call_expression->func, environment, NULL);
+            uint32_t *children = flat_program_children(program, node.val);
+            uint32_t num_arguments = children[0];
+            TORAFlatIndex func = children[1];
+            TORAParserUnknownExpression *function_expression = (TORAParserUnknownExpression *)evaluate(program, func, environment, NULL);
             
             // If our function call evalutes to a known function we can try to execute it...
-            if(function_expression)
+            if(function_expression && function_expression->type == TORAExpressionTypeFunction)
             {
-                TORAEnvironment *new_environment = create_environment(environment);
-                
-                TORALinkedList *cur_argument = function_expression->arguments;
-                TORALinkedList *cur_value = call_expression->arguments;
-                while(cur_argument)
+                return call_function(program, (TORAFlatFunctionValue *)function_expression, flat_program_children(program, node.val), environment, return_encountered);
+            }
+            // Otherwise check whether this call is referencing something from our standard lib. Most
+            // are resolved before the program's run, so this is only reached when the program binds
+            // a builtin's name to something other than a function
+            else if(program->nodes[func].type == TORAExpressionTypeVariable)
+            {
+                TORAParserUnknownExpression *arguments[num_arguments > 0 ? num_arguments : 1];
+                for(uint32_t i = 0; i < num_arguments; i++)
                 {
-                    void *val = evaluate(cur_value->value, environment, NULL);
-                    
-                    TORAParserVariableExpression *variable_expression = (TORAParserVariableExpression *)cur_argument->value;
-                    environment_define_var(new_environment, variable_expression->val, val, true);
-
-                    cur_argument = cur_argument->next;
-                    cur_value = cur_value->next;
+                    arguments[i] = evaluate(program, program->children[node.val + 2 + i], environment, NULL);
                 }
                 
-                bool return_encountered_in_call = false;
-                void *result = evaluate(function_expression->body, new_environment, &return_encountered_in_call);
-                if(return_encountered && return_encountered_in_call)
+                const char *method = flat_program_string(program, environment_variable_name(program, func, environment));
+                const TORABuiltin *builtin = builtin_lookup(method, strlen(method));
+                if(builtin)
                 {
-                    *return_encountered = return_encountered_in_call;
+                    builtin_check_arguments(builtin, num_arguments);
+                    
+                    void *result = builtin->function(arguments, num_arguments);
+                    if(result)
+                    {
+                        queue_raw_item(&interpretter_queue, NULL, result);
+                    }
+                    return result;
                 }
-                return result;
             }
-            // Otherwise check whether this call is referencing something from our standard lib
-            else
+            return NULL;
+        }
+            break;
+        case TORAExpressionTypeBuiltinCall:
+        {
+            const TORABuiltin *builtin = &tora_builtins[node.op];
+            uint32_t num_arguments = program->children[node.val];
+            
+            TORAParserUnknownExpression *arguments[num_arguments > 0 ? num_arguments : 1];
+            for(uint32_t i = 0; i < num_arguments; i++)
+            {
+                arguments[i] = evaluate(program, program->children[node.val + 1 + i], environment, NULL);
+            }
+            
+            void *result = builtin->function(arguments, num_arguments);
+            if(result)
+            {
+                queue_raw_item(&interpretter_queue, NULL, result);
+            }
+            return result;
+        }
+            break;
+        case TORAExpressionTypeConcat:
+        {
+            // Every piece is converted to a string before any are copied, so the result
+            // is built in one allocation of exactly the right size
+            uint32_t num_pieces = program->children[node.val];
+            TORAParserStringExpression *pieces[num_pieces];
+            size_t lengths[num_pieces];
+            size_t length = 0;
+            for(uint32_t i = 0; i < num_pieces; i++)
             {
-                TORAParserVariableExpression *function_name_func = (TORAParserVariableExpression *)call_expression->func;
-                if(function_name_func->type == TORAExpressionTypeVariable)
+                TORAParserUnknownExpression *piece = evaluate(program, program->children[node.val + 1 + i], environment, NULL);
+                assert(piece);
+                
+                pieces[i] = string_representation_for_expression(piece);
+                if(pieces[i] != (TORAParserStringExpression *)piece)
                 {
-                    return maybe_standard_lib_call(function_name_func->val, call_expression->arguments, environment);
+                    queue_raw_item(&interpretter_queue, NULL, pieces[i]);
                 }
+                lengths[i] = strlen(pieces[i]->val);
+                length += lengths[i];
             }
-            return NULL;
+            
+            char *val = tora_malloc(length + 1);
+            if(!val)
+            {
+                TORA_RUNTIME_EXCEPTION("Malloc failed during string concatenation");
+            }
+            char *end = val;
+            for(uint32_t i = 0; i < num_pieces; i++)
+            {
+                memcpy(end, pieces[i]->val, lengths[i]);
+                end += lengths[i];
+            }
+            *end = '\0';
+            
+            void *result = new_string_expression_with_buffer(val);
+            queue_raw_item(&interpretter_queue, NULL, result);
+            return result;
         }
             break;
         case TORAExpressionTypeWhile:
         {
             bool return_encountered_in_while = false;
             
-            TORAParserWhileExpression *while_expression = (TORAParserWhileExpression *)expression;
-            while(((TORAParserBoolExpression *)evaluate(while_expression->condition, environment, NULL))->val)
+            uint32_t *children = flat_program_children(program, node.val);
+            TORAFlatIndex condition = children[0];
+            TORAFlatIndex body = children[1];
+            while(((TORAParserBoolExpression *)evaluate(program, condition, environment, NULL))->val)
             {
-                void *val = evaluate(while_expression->body, environment, &return_encountered_in_while);
+                void *val = evaluate(program, body, environment, &return_encountered_in_while);
                 if(return_encountered && return_encountered_in_while)
                 {
                     *return_encountered = return_encountered_in_while;
@@ -430,19 +559,21 @@ void* evaluate(void *expression, TORAEnvironment *environment, bool *return_enco
                 }
             }
             
-            return new_boolean_expression(false);
+            return &tora_false_value;
         }
             break;
         case TORAExpressionTypeIfThenElse:
         {
-            TORAParserIfThenElseExpression *if_expression = (TORAParserIfThenElseExpression *)expression;
-            TORAParserBoolExpression *condition = evaluate(if_expression->condition, environment, NULL);
+            uint32_t *children = flat_program_children(program, node.val);
+            TORAFlatIndex then = children[1];
+            TORAFlatIndex el = children[2];
+            TORAParserBoolExpression *condition = evaluate(program, children[0], environment, NULL);
             
             // If this statements condition evaluated true
             if(condition->val)
             {
                 bool return_encountered_in_if_then = false;
-                void *result = evaluate(if_expression->then, environment, &return_encountered_in_if_then);
+                void *result = evaluate(program, then, environment, &return_encountered_in_if_then);
                 if(return_encountered && return_encountered_in_if_then)
                 {
                     *return_encountered = return_encountered_in_if_then;
@@ -450,10 +581,10 @@ void* evaluate(void *expression, TORAEnvironment *environment, bool *return_enco
                 return result;
             }
             // Otherwise, execute our else block
-            else if(if_expression->el)
+            else if(el != TORA_FLAT_NONE)
             {
                 bool return_encountered_in_if_then_else = false;
-                void *result = evaluate(if_expression->el, environment, &return_encountered_in_if_then_else);
+                void *result = evaluate(program, el, environment, &return_encountered_in_if_then_else);
                 if(return_encountered && return_encountered_in_if_then_else)
                 {
                     *return_encountered = return_encountered_in_if_then_else;
@@ -462,7 +593,7 @@ void* evaluate(void *expression, TORAEnvironment *environment, bool *return_enco
             }
             else
             {
-                return new_boolean_expression(false);
+                return &tora_false_value;
             }
         }
             break;
@@ -472,142 +603,49 @@ void* evaluate(void *expression, TORAEnvironment *environment, bool *return_enco
     
     return NULL;
 }
-void *maybe_standard_lib_call(char *method, TORALinkedList *arguments, TORAEnvironment *environment)
+// Calls a user defined function, binding each of its parameters to the value of the
+// matching argument expression. arguments is the call's [n, func, argument...] range
+void *call_function(TORAFlatProgram *program, TORAFlatFunctionValue *function_value, uint32_t *arguments, TORAEnvironment *environment, bool *return_encountered)
 {
-    // Math functions
-    if(strcmp(method, "sin") == 0)
-    {
-        TORAParserNumericExpression *numeric = (TORAParserNumericExpression *)evaluate(arguments->value, environment, NULL);
-        void *result = new_numeric_expression(sin(numeric->val));
-        queue_raw_item(&interpretter_queue, NULL, numeric);
-        queue_raw_item(&interpretter_queue, NULL, result);
-        return result;
-    }
-    else if(strcmp(method, "cos") == 0)
-    {
-        TORAParserNumericExpression *numeric = (TORAParserNumericExpression *)evaluate(arguments->value, environment, NULL);
-        void *result = new_numeric_expression(cos(numeric->val));
-        queue_raw_item(&interpretter_queue, NULL, numeric);
-        queue_raw_item(&interpretter_queue, NULL, result);
-        return result;
-    }
-    else if(strcmp(method, "tan") == 0)
-    {
-        TORAParserNumericExpression *numeric = (TORAParserNumericExpression *)evaluate(arguments->value, environment, NULL);
-        void *result = new_numeric_expression(tan(numeric->val));
-        queue_raw_item(&interpretter_queue, NULL, numeric);
-        queue_raw_item(&interpretter_queue, NULL, result);
-        return result;
-    }
-    else if(strcmp(method, "atan") == 0)
-    {
-        TORAParserNumericExpression *numeric = (TORAParserNumericExpression *)evaluate(arguments->value, environment, NULL);
-        void *result = new_numeric_expression(atan(numeric->val));
-        queue_raw_item(&interpretter_queue, NULL, numeric);
-        queue_raw_item(&interpretter_queue, NULL, result);
-        return result;
-    }
-    else if(strcmp(method, "log") == 0)
-    {
-        TORAParserNumericExpression *numeric = (TORAParserNumericExpression *)evaluate(arguments->value, environment, NULL);
-        void *result = new_numeric_expression(log(numeric->val));
-        queue_raw_item(&interpretter_queue, NULL, numeric);
-        queue_raw_item(&interpretter_queue, NULL, result);
-        return result;
-    }
-    else if(strcmp(method, "exp") == 0)
-    {
-        TORAParserNumericExpression *numeric = (TORAParserNumericExpression *)evaluate(arguments->value, environment, NULL);
-        void *result = new_numeric_expression(exp(numeric->val));
-        queue_raw_item(&interpretter_queue, NULL, numeric);
-        queue_raw_item(&interpretter_queue, NULL, result);
-        return result;
-    }
-    else if(strcmp(method, "round") == 0)
+    // Functions defined at the top level may not have had their bodies parsed yet.
+    // Doing so moves the program's pools, so the call's found again by offset
+    uint32_t call = (uint32_t)(arguments - program->children);
+    uint32_t f = function_value->function;
+    if(program->functions[f].body == TORA_FLAT_NONE)
     {
-        TORAParserNumericExpression *numeric = (TORAParserNumericExpression *)evaluate(arguments->value, environment, NULL);
-        void *result = new_numeric_expression(round(numeric->val));
-        queue_raw_item(&interpretter_queue, NULL, numeric);
-        queue_raw_item(&interpretter_queue, NULL, result);
-        return result;
-    }
-    else if(strcmp(method, "min") == 0)
-    {
-        TORAParserNumericExpression *a = (TORAParserNumericExpression *)evaluate(arguments->value, environment, NULL);
-        TORAParserNumericExpression *b = (TORAParserNumericExpression *)evaluate(arguments->next->value, environment, NULL);
-        void *result = new_numeric_expression(fmin(a->val, b->val));
-        queue_raw_item(&interpretter_queue, NULL, a);
-        queue_raw_item(&interpretter_queue, NULL, b);
-        queue_raw_item(&interpretter_queue, NULL, result);
-        return result;
-    }
-    else if(strcmp(method, "max") == 0)
-    {
-        TORAParserNumericExpression *a = (TORAParserNumericExpression *)evaluate(arguments->value, environment, NULL);
-        TORAParserNumericExpression *b = (TORAParserNumericExpression *)evaluate(arguments->next->value, environment, NULL);
-        void *result = new_numeric_expression(fmax(a->val, b->val));
-        queue_raw_item(&interpretter_queue, NULL, a);
-        queue_raw_item(&interpretter_queue, NULL, b);
-        queue_raw_item(&interpretter_queue, NULL, result);
-        return result;
+        parse_function_body(program, f);
     }
     
-    // Collection functions
-    else if(strcmp(method, "length") == 0)
+    uint32_t num_parameters = program->children[program->functions[f].parameters];
+    uint32_t num_arguments = program->children[call];
+    if(num_arguments < num_parameters)
     {
-        TORAParserArrayExpression *array_expression = (TORAParserArrayExpression *)evaluate(arguments->value, environment, NULL);
-        if(array_expression && array_expression->type == TORAExpressionTypeArray)
-        {
-            queue_raw_item(&interpretter_queue, NULL, array_expression);
-            
-            void *result = new_numeric_expression(linked_list_length(array_expression->val));
-            queue_raw_item(&interpretter_queue, NULL, result);
-            return result;
-        }
-        else
-        {
-            TORA_INTERPRETTER_EXCEPTION("Unable to determine collection length for invalid type: %i", array_expression->type);
-        }
+        TORA_INTERPRETTER_EXCEPTION("Function expects %u arguments, but was called with %u", num_parameters, num_arguments);
     }
     
-    // Logging functions
-    else if(strcmp(method, "print") == 0)
+    // Calls have the environment the function was defined in as their parent, so
+    // looking a variable up never walks further than the function's nesting. Each
+    // parameter's run entry is the slot the resolver gave it
+    TORAEnvironment *parent = function_value->environment ? function_value->environment : environment->global;
+    TORAEnvironment *new_environment = create_environment(parent, program, program->functions[f].names);
+    for(uint32_t i = 0; i < num_parameters; i++)
     {
-        TORAParserStringExpression *string_expression = (TORAParserStringExpression *)evaluate(arguments->value, environment, NULL);
-        if(string_expression)
-        {
-            queue_raw_item(&interpretter_queue, NULL, string_expression);
-            
-            if(string_expression->type == TORAExpressionTypeString)
-            {
-                printf("%s", string_expression->val);
-            }
-        }
+        void *val = evaluate(program, program->children[call + 2 + i], environment, NULL);
+        environment_set_slot(new_environment, program->children[program->functions[f].parameters + 1 + i], val);
     }
-    else if(strcmp(method, "println") == 0)
+    
+    bool return_encountered_in_call = false;
+    void *result = evaluate(program, program->functions[f].body, new_environment, &return_encountered_in_call);
+    if(return_encountered && return_encountered_in_call)
     {
-        TORAParserUnknownExpression *expression = (TORAParserUnknownExpression *)evaluate(arguments->value, environment, NULL);
-        if(expression)
-        {
-            queue_raw_item(&interpretter_queue, NULL, expression);
-            
-            TORAParserStringExpression *string_expression = string_representation_for_expression(expression);
-            if(string_expression)
-            {
-                printf("%s\n", string_expression->val);
-                
-                queue_raw_item(&interpretter_queue, NULL, string_expression);
-            }
-        }
+        *return_encountered = return_encountered_in_call;
     }
-    return NULL;
+    return result;
 }
-void *apply_op(char *op,
+void *apply_op(TORATokenKind op,
                TORAParserUnknownExpression *a,
-               TORAParserUnknownExpression *b,
-               TORAEnvironment *environment)
+               TORAParserUnknownExpression *b)
 {
-    assert(op);
     assert(a);
     assert(b);
     
@@ -615,61 +653,55 @@ void *apply_op(char *op,
     TORAParserNumericExpression *num_b = (TORAParserNumericExpression *)b;
     
     void *result = NULL;
-    if(strcmp(op, "+") == 0)
+    if(op == TORATokenKindAdd)
     {
         result = (void *)concat_expressions(a, b);
     }
-    else if(strcmp(op, "-") == 0)
+    else if(op == TORATokenKindSubtract)
     {
         result = (void *)new_numeric_expression(num_a->val - num_b->val);
     }
-    else if(strcmp(op, "*") == 0)
+    else if(op == TORATokenKindMultiply)
     {
         result = (void *)new_numeric_expression(num_a->val * num_b->val);
     }
-    else if(strcmp(op, "/") == 0)
+    else if(op == TORATokenKindDivide)
     {
         result = (void *)new_numeric_expression(num_a->val / num_b->val);
     }
-    else if(strcmp(op, "%") == 0)
+    else if(op == TORATokenKindModulo)
     {
         result = (void *)new_numeric_expression(fmod(num_a->val, num_b->val));
     }
-    else if(strcmp(op, "&&") == 0)
+    else if(op == TORATokenKindAnd)
     {
-        TORAParserUnknownExpression *eval_a = (TORAParserUnknownExpression *)evaluate(a, environment, NULL);
-        TORAParserUnknownExpression *eval_b = (TORAParserUnknownExpression *)evaluate(b, environment, NULL);
-        bool val = expression_is_truthy(eval_a) && expression_is_truthy(eval_b);
-        result = (void *)new_boolean_expression(val);
+        result = (void *)new_boolean_expression(expression_is_truthy(a) && expression_is_truthy(b));
     }
-    else if(strcmp(op, "||") == 0)
+    else if(op == TORATokenKindOr)
     {
-        TORAParserUnknownExpression *eval_a = (TORAParserUnknownExpression *)evaluate(a, environment, NULL);
-        TORAParserUnknownExpression *eval_b = (TORAParserUnknownExpression *)evaluate(b, environment, NULL);
-        bool val = expression_is_truthy(eval_a) || expression_is_truthy(eval_b);
-        result = (void *)new_boolean_expression(val);
+        result = (void *)new_boolean_expression(expression_is_truthy(a) || expression_is_truthy(b));
     }
-    else if(strcmp(op, "<") == 0)
+    else if(op == TORATokenKindLess)
     {
         result = (void *)new_boolean_expression(num_a->val < num_b->val);
     }
-    else if(strcmp(op, ">") == 0)
+    else if(op == TORATokenKindGreater)
     {
         result = (void *)new_boolean_expression(num_a->val > num_b->val);
     }
-    else if(strcmp(op, "<=") == 0)
+    else if(op == TORATokenKindLessEqual)
     {
         result = (void *)new_boolean_expression(num_a->val <= num_b->val);
     }
-    else if(strcmp(op, ">=") == 0)
+    else if(op == TORATokenKindGreaterEqual)
     {
         result = (void *)new_boolean_expression(num_a->val >= num_b->val);
     }
-    else if(strcmp(op, "==") == 0)
+    else if(op == TORATokenKindEqual)
     {
         result = (void *)new_boolean_expression(expressions_are_equal(a, b));
     }
-    else if(strcmp(op, "!=") == 0)
+    else if(op == TORATokenKindNotEqual)
     {
         result = (void *)new_boolean_expression(!expressions_are_equal(a, b));
     }
@@ -691,10 +723,11 @@ bool expressions_are_equal(TORAParserUnknownExpression *a, TORAParserUnknownExpr
         TORAParserStringExpression *string_a = (TORAParserStringExpression *)a;
         TORAParserStringExpression *string_b = (TORAParserStringExpression *)b;
         
-        // string/string equality check
+        // string/string equality check. A program's string literals are interned,
+        // so the same literal is always the same value
         if(b->type == TORAExpressionTypeString)
         {
-            return strcmp(string_a->val, string_b->val) == 0;
+            return string_a == string_b || strcmp(string_a->val, string_b->val) == 0;
         }
     }
     else if(a->type == TORAExpressionTypeNumeric)
@@ -773,7 +806,7 @@ void free_expression(void *expression)
         case TORAExpressionTypeProg:
         {
             TORAParserProgExpression *prog_expression = (TORAParserProgExpression *)expression;
-            tora_release(prog_expression->val);
+            free_expression_list(prog_expression->val);
             prog_expression->val = NULL;
         }
             break;
@@ -792,6 +825,12 @@ void free_expression(void *expression)
                 tora_release(array_expression->val);
                 array_expression->val = NULL;
             }
+            
+            if(array_expression->items)
+            {
+                free_expression_list(array_expression->items);
+                array_expression->items = NULL;
+            }
         }
             break;
         case TORAExpressionTypeArrayIndex:
@@ -815,13 +854,27 @@ void free_expression(void *expression)
             
             if(function_expression->arguments)
             {
-                tora_release(function_expression->arguments);
+                free_expression_list(function_expression->arguments);
                 function_expression->arguments = NULL;
             }
             
             tora_release(function_expression->body);
         }
             break;
+        case TORAExpressionTypeBuiltinCall:
+        {
+            TORAParserBuiltinCallExpression *call_expression = (TORAParserBuiltinCallExpression *)expression;
+            free_expression_list(call_expression->arguments);
+            call_expression->arguments = NULL;
+        }
+            break;
+        case TORAExpressionTypeConcat:
+        {
+            TORAParserConcatExpression *concat_expression = (TORAParserConcatExpression *)expression;
+            free_expression_list(concat_expression->pieces);
+            concat_expression->pieces = NULL;
+        }
+            break;
         case TORAExpressionTypeCall:
         {
             TORAParserCallExpression *call_expression = (TORAParserCallExpression *)expression;
@@ -830,7 +883,7 @@ void free_expression(void *expression)
             
             if(call_expression->arguments)
             {
-                tora_release(call_expression->arguments);
+                free_expression_list(call_expression->arguments);
                 call_expression->arguments = NULL;
             }
         }
@@ -947,29 +1000,25 @@ void *string_representation_for_expression(void *expression)
     
     return NULL;
 }
-TORAParserArrayExpression *get_array_for_index_expression(TORAParserArrayIndexExpression *index_expression, TORAEnvironment *environment)
+TORAParserArrayExpression *get_array_for_index_expression(TORAFlatProgram *program, TORAFlatIndex index_expression, TORAEnvironment *environment)
 {
-    assert(index_expression->array);
-    assert(index_expression->type == TORAExpressionTypeArrayIndex);
+    assert(program->nodes[index_expression].type == TORAExpressionTypeArrayIndex);
     
     // In this instance array_expression will either be a variable will evaluate to an array expression
-    TORAParserUnknownExpression *array_name_expression = (TORAParserUnknownExpression *)index_expression->array;
+    TORAFlatIndex array_name_expression = program->children[program->nodes[index_expression].val];
+    TORAFlatNode *array_name_node = &program->nodes[array_name_expression];
     TORAParserArrayExpression *array = NULL;
-    if(array_name_expression->type == TORAExpressionTypeVariable)
+    if(array_name_node->type == TORAExpressionTypeVariable)
     {
-        TORALinkedList *val = environment_get_var(environment, ((TORAParserVariableExpression *)array_name_expression)->val, true);
-        if(val)
-        {
-            array = (TORAParserArrayExpression *)val->value;
-        }
-        else
+        array = environment_get_var(program, array_name_expression, environment);
+        if(!array)
         {
             TORA_INTERPRETTER_EXCEPTION("Undefined array");
         }
     }
     else
     {
-        array = evaluate(array_name_expression, environment, NULL);
+        array = evaluate(program, array_name_expression, environment, NULL);
     }
     
     // TODO: check array type
@@ -983,6 +1032,29 @@ TORALinkedList *get_array_value_for_key(TORAParserArrayExpression *array, TORAPa
     }
     
     TORALinkedList *cur_array_val = array->val;
+    if(key->type == TORAExpressionTypeString)
+    {
+        // String keys are most often literals, which share one value for each distinct
+        // string, and otherwise are told apart by their hashes before their text
+        TORAParserStringExpression *string_key = (TORAParserStringExpression *)key;
+        uint32_t hash = string_expression_hash(string_key);
+        while(cur_array_val)
+        {
+            TORAParserStringExpression *name = cur_array_val->name;
+            if(name == string_key)
+            {
+                return cur_array_val;
+            }
+            if(name && name->type == TORAExpressionTypeString && string_expression_hash(name) == hash &&
+               strcmp(name->val, string_key->val) == 0)
+            {
+                return cur_array_val;
+            }
+            cur_array_val = cur_array_val->next;
+        }
+        return NULL;
+    }
+    
     while(cur_array_val)
     {
         if(cur_array_val->name && expressions_are_equal(cur_array_val->name, key))
@@ -994,6 +1066,16 @@ TORALinkedList *get_array_value_for_key(TORAParserArrayExpression *array, TORAPa
     
     return NULL;
 }
+// Strings hash to anything but 0, which marks one that's yet to be hashed
+uint32_t string_expression_hash(TORAParserStringExpression *string)
+{
+    if(string->hash == 0)
+    {
+        uint32_t hash = tora_strhash(string->val);
+        string->hash = hash ? hash : 1;
+    }
+    return string->hash;
+}
 // Determines whether an expression (evaluated or otherwise) represents a truthy value
 bool expression_is_truthy(TORAParserUnknownExpression *exp)
 {
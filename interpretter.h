@@ -18,12 +18,20 @@ struct TORAEnvironment {
     int ref_count;
     
     TORAEnvironment *parent;
-    TORALinkedList *var_list_head;
-    TORALinkedList *var_list_tail;
+    TORAEnvironment *global;
+    
+    // Every name bound in the environment's scope has a slot, in the order of the
+    // scope's run of names (see flat.h). A slot is NULL until it's assigned to
+    uint32_t names;
+    uint32_t num_slots;
+    void *slots[];
 };
 
-TORAEnvironment *create_environment(TORAEnvironment *parent);
-void* evaluate(void *expression, TORAEnvironment *environment, bool *return_encountered);
+TORAEnvironment *create_environment(TORAEnvironment *parent, TORAFlatProgram *program, uint32_t names);
+void* evaluate(TORAFlatProgram *program, TORAFlatIndex expression, TORAEnvironment *environment, bool *return_encountered);
+void *apply_op(TORATokenKind op, TORAParserUnknownExpression *a, TORAParserUnknownExpression *b);
+void *string_representation_for_expression(void *expression);
+uint32_t string_expression_hash(TORAParserStringExpression *string);
 
 void free_expression(void *expression);
 void free_environment(TORAEnvironment *enviroment);
@@ -8,76 +8,232 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include "tora.h"
 
 int main(int argc, const char * argv[])
 {
     try
     {
-        if(argc < 2)
+        // Any arguments beginning with -- are treated as options, anything
+        // else is taken to be the .tora file we want to run (- for stdin)
+        const char *filename = NULL;
+        bool streaming_lexer = false;
+        bool parallel_lexer = false;
+        bool print_stats = false;
+        bool eager = false;
+        bool use_cache = true;
+        bool compile = false;
+        bool dump = false;
+        const char *cache_dir = NULL;
+        for(int i = 1; i < argc; i++)
+        {
+            if(strcmp(argv[i], "--streaming-lexer") == 0)
+            {
+                streaming_lexer = true;
+            }
+            else if(strcmp(argv[i], "--parallel-lexer") == 0)
+            {
+                parallel_lexer = true;
+            }
+            else if(strcmp(argv[i], "--stats") == 0)
+            {
+                print_stats = true;
+            }
+            else if(strcmp(argv[i], "--eager") == 0)
+            {
+                // Parse every function up front, rather than as each is first called,
+                // so a syntax error anywhere is reported before the program runs
+                eager = true;
+            }
+            else if(strcmp(argv[i], "--no-cache") == 0)
+            {
+                use_cache = false;
+            }
+            else if(strcmp(argv[i], "--compile") == 0)
+            {
+                // Only build the file's image, for deploying ahead of running it
+                compile = true;
+            }
+            else if(strcmp(argv[i], "--dump") == 0)
+            {
+                // Print the program as the optimiser left it, rather than running it.
+                // Only functions that have been parsed can be printed
+                dump = true;
+                eager = true;
+            }
+            else if(strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc)
+            {
+                cache_dir = argv[++i];
+            }
+            else
+            {
+                filename = argv[i];
+            }
+        }
+        
+        if(!filename)
         {
             printf("Please provide a .tora file to parse!\n");
+            printf("Usage: tora [--streaming-lexer] [--parallel-lexer] [--stats] [--eager] [--no-cache] [--compile] [--dump] [--cache-dir dir] file.tora|file.torac|-\n");
             exit(1);
         }
-
+        
         if(!tora_init())
         {
             TORA_RUNTIME_EXCEPTION("Failed to initialise parser!");
         }
         
-        // Create an input stream to begin parsing our document
-        TORAInputStream *input_stream = input_stream_from_file_contents(argv[1]);
-        if(!input_stream)
+        // Images can be run without their sources, in which case they're taken to be
+        // whatever their name says they are
+        TORAFlatProgram *program = NULL;
+        TORAInputStream *input_stream = NULL;
+        TORATokenStream *token_stream = NULL;
+        char *cache_path = NULL;
+        uint64_t source_hash = 0;
+        size_t filename_length = strlen(filename);
+        if(filename_length > 6 && strcmp(filename + filename_length - 6, ".torac") == 0)
         {
-            TORA_RUNTIME_EXCEPTION("Failed to parse input stream!");
+            program = image_load_any(filename);
+            if(!program)
+            {
+                TORA_RUNTIME_EXCEPTION("Unable to load %s as an image built by this version of TORA", filename);
+            }
         }
-        
-        // Create a token stream from our TORAInputStream
-        TORATokenStream *token_stream = token_stream_from_input(input_stream);
-        if(!token_stream)
+        else
         {
-            free_input_stream(input_stream);
+            // Create an input stream to begin parsing our document
+            input_stream = strcmp(filename, "-") == 0 ? input_stream_from_fd(dup(STDIN_FILENO)) : input_stream_from_file_contents(filename);
+            if(!input_stream)
+            {
+                TORA_RUNTIME_EXCEPTION("Failed to parse input stream!");
+            }
             
-            TORA_RUNTIME_EXCEPTION("Failed to malloc input stream!");
-        }
-        
-        // Parse the top level of our program and generate an AST
-        TORAParserProgExpression *prog = parse_top_level(token_stream);
-        if(!prog)
-        {
-            free_token_stream(token_stream);
-            free_input_stream(input_stream);
+            // Files we've run before are loaded from the image cached alongside them, so
+            // long as it was built from the same source by this version of the interpreter
+            if((use_cache || compile) && !input_stream_is_streamed(input_stream))
+            {
+                source_hash = tora_hash(input_stream->contents, input_stream->length);
+                cache_path = image_cache_path(filename, cache_dir, source_hash);
+                program = image_load(cache_path, source_hash, input_stream->length);
+                if(program)
+                {
+                    if(print_stats)
+                    {
+                        fprintf(stderr, "Loaded %u nodes into %llu bytes from %s\n", program->num_nodes, (unsigned long long)flat_program_size(program), cache_path);
+                    }
+                }
+                else if(image_cache_writable(cache_path))
+                {
+                    // Images hold every function. Building one is all --compile does, so
+                    // there's nothing to gain from leaving any to be parsed later
+                    eager = eager || compile;
+                }
+                else
+                {
+                    tora_free(cache_path);
+                    cache_path = NULL;
+                }
+            }
             
-            TORA_RUNTIME_EXCEPTION("Failed to generate expression tree!");
+            // Create a token stream from our TORAInputStream. By default we lex the whole
+            // file up front, but tokens can also be pulled from the input as the parser needs them.
+            // Streamed input (pipes, stdin) is always pulled so that parsing can begin before the
+            // writer has finished, without having to hold the entire source in memory
+            if(input_stream_is_streamed(input_stream))
+            {
+                streaming_lexer = true;
+            }
+            if(!program)
+            {
+                if(streaming_lexer)
+                {
+                    token_stream = token_stream_from_input(input_stream);
+                }
+                else if(parallel_lexer)
+                {
+                    token_stream = token_stream_parallel_from_input(input_stream, 0);
+                }
+                else
+                {
+                    token_stream = token_stream_buffered_from_input(input_stream);
+                }
+                if(!token_stream)
+                {
+                    free_input_stream(input_stream);
+                    
+                    TORA_RUNTIME_EXCEPTION("Failed to malloc input stream!");
+                }
+                
+                // Parse our program and generate the flattened AST we evaluate
+                program = parse_program(token_stream, !eager);
+                if(!program)
+                {
+                    free_token_stream(token_stream);
+                    free_input_stream(input_stream);
+                    
+                    TORA_RUNTIME_EXCEPTION("Failed to generate expression tree!");
+                }
+                
+                if(print_stats)
+                {
+                    fprintf(stderr, "Lexed %llu tokens from %lu bytes\n", (unsigned long long)token_stream->num_tokens, input_stream->length);
+                    fprintf(stderr, "Parsed %u nodes into %llu bytes\n", program->num_nodes, (unsigned long long)flat_program_size(program));
+                }
+            }
+            if(!cache_path && compile)
+            {
+                TORA_RUNTIME_EXCEPTION("Unable to save an image for %s", filename);
+            }
         }
         
         // Create a base environment for use when evaluating the AST
-        TORAEnvironment *environment = create_environment(NULL);
+        TORAEnvironment *environment = create_environment(NULL, program, program->globals);
         if(!environment)
         {
-            free_expression(prog);
-            free_token_stream(token_stream);
-            free_input_stream(input_stream);
+            free_flat_program(program);
+            if(token_stream) free_token_stream(token_stream);
+            if(input_stream) free_input_stream(input_stream);
             
             TORA_RUNTIME_EXCEPTION("Failed to malloc root environment!");
         }
         
         // Evaluate the program!
-        bool return_encountered = false;
-        evaluate(prog, environment, &return_encountered);
+        if(dump)
+        {
+            flat_program_dump(program, stdout);
+        }
+        else if(!compile)
+        {
+            bool return_encountered = false;
+            evaluate(program, program->root, environment, &return_encountered);
+        }
+        
+        // A program that missed the cache is saved once it's finished running, so it
+        // only parses the functions it never called on its way out. Failing to save
+        // an image only costs the next run its head start
+        if(cache_path)
+        {
+            if(token_stream && !(parse_function_bodies(program) && image_save(program, cache_path, source_hash, input_stream->length)) && compile)
+            {
+                TORA_RUNTIME_EXCEPTION("Failed to save image to %s", cache_path);
+            }
+            tora_free(cache_path);
+        }
         
-        // Cleanup
-        free_expression(prog);
+        // Cleanup. Our queues may still reference the program's values, so
+        // they need to be drained before the program is freed
         drain_queue(environment_queue);
         drain_queue(interpretter_queue);
+        free_flat_program(program);
         
-        free_token_stream(token_stream);
-        free_input_stream(input_stream);
+        if(token_stream) free_token_stream(token_stream);
+        if(input_stream) free_input_stream(input_stream);
         
         if(num_malloc != num_free)
         {
             printf("Num malloc'd blocks: %i, num freed: %i, lost: %i\n", num_malloc, num_free, num_malloc-num_free);
-            printf("Num un-freed tokens: %i\n", num_tok);
         }
         
         // Teardown
@@ -0,0 +1,210 @@
+//
+//  number.c
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+// strtod_l is a GNU/BSD extension
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <locale.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+
+#include "tora.h"
+
+// The largest integer a double can represent exactly, and the largest power
+// of ten which is itself exactly representable
+#define TORA_NUMBER_MAX_EXACT_MANTISSA (1ULL << 53)
+#define TORA_NUMBER_MAX_EXACT_POW10 22
+
+// Mantissas with more significant digits than this no longer fit in 64 bits
+#define TORA_NUMBER_MAX_DIGITS 19
+
+double parse_number_fallback(const char *str, size_t length);
+bool parse_number_fast(const char *str, size_t length, double *value);
+int hex_digit_value(char ch);
+
+static const double tora_exact_pow10[TORA_NUMBER_MAX_EXACT_POW10 + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Literals are always parsed in the C locale, whatever the host has set
+static locale_t tora_c_locale = (locale_t)0;
+
+bool tora_number_init(void)
+{
+    if(!tora_c_locale)
+    {
+        tora_c_locale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+    }
+    return tora_c_locale != (locale_t)0;
+}
+void tora_number_shutdown(void)
+{
+    if(tora_c_locale)
+    {
+        freelocale(tora_c_locale);
+        tora_c_locale = (locale_t)0;
+    }
+}
+
+// Conversion
+double tora_parse_number(const char *str, size_t length)
+{
+    double value = 0;
+    if(parse_number_fast(str, length, &value))
+    {
+        return value;
+    }
+    return parse_number_fallback(str, length);
+}
+// Handles the overwhelmingly common case of literals whose significant digits fit
+// in a double's 53 bit mantissa and whose decimal exponent is small enough for the
+// matching power of ten to be exact. A single multiply or divide of two exact values
+// is correctly rounded by IEEE arithmetic (Clinger's fast path). Hex literals of up
+// to 16 digits are exact integers, so the conversion from 64 bits rounds correctly
+bool parse_number_fast(const char *str, size_t length, double *value)
+{
+    const char *cur = str;
+    const char *end = str + length;
+    uint64_t mantissa = 0;
+    
+    if(length > 2 && cur[0] == '0' && (cur[1] == 'x' || cur[1] == 'X'))
+    {
+        cur += 2;
+        while(cur < end && *cur == '0') cur++;
+        if(end - cur > 16)
+        {
+            return false;
+        }
+        
+        for(; cur < end; cur++)
+        {
+            mantissa = (mantissa << 4) | (uint64_t)hex_digit_value(*cur);
+        }
+        *value = (double)mantissa;
+        return true;
+    }
+    
+    // Accumulate every digit either side of the dot into a single mantissa, with
+    // each fractional digit moving our decimal exponent down by one
+    int digits = 0;
+    int64_t exponent = 0;
+    bool in_fraction = false;
+    for(; cur < end; cur++)
+    {
+        char ch = *cur;
+        if(ch == '.')
+        {
+            in_fraction = true;
+            continue;
+        }
+        else if(ch == 'e' || ch == 'E')
+        {
+            break;
+        }
+        
+        if(mantissa != 0 || ch != '0')
+        {
+            if(++digits > TORA_NUMBER_MAX_DIGITS)
+            {
+                return false;
+            }
+        }
+        mantissa = mantissa * 10 + (uint64_t)(ch - '0');
+        if(in_fraction)
+        {
+            exponent--;
+        }
+    }
+    
+    if(cur < end)
+    {
+        // Skip past the e and handle any explicit sign. Exponents are clamped well
+        // beyond anything a double can represent so they can't overflow
+        cur++;
+        bool negative = false;
+        if(cur < end && (*cur == '+' || *cur == '-'))
+        {
+            negative = (*cur == '-');
+            cur++;
+        }
+        
+        int64_t explicit_exponent = 0;
+        for(; cur < end; cur++)
+        {
+            if(explicit_exponent < 100000)
+            {
+                explicit_exponent = explicit_exponent * 10 + (*cur - '0');
+            }
+        }
+        exponent += negative ? -explicit_exponent : explicit_exponent;
+    }
+    
+    if(mantissa == 0)
+    {
+        *value = 0;
+        return true;
+    }
+    if(mantissa > TORA_NUMBER_MAX_EXACT_MANTISSA || exponent < -TORA_NUMBER_MAX_EXACT_POW10 || exponent > TORA_NUMBER_MAX_EXACT_POW10)
+    {
+        return false;
+    }
+    
+    if(exponent < 0)
+    {
+        *value = (double)mantissa / tora_exact_pow10[-exponent];
+    }
+    else
+    {
+        *value = (double)mantissa * tora_exact_pow10[exponent];
+    }
+    return true;
+}
+// Anything the fast path can't guarantee to round correctly is handed to strtod,
+// which does, pinned to the C locale so a host using ',' as its radix still works
+double parse_number_fallback(const char *str, size_t length)
+{
+    // strtod needs a null terminated string, so copy our literal somewhere
+    // suitable first. Most numbers comfortably fit on the stack. As we may be
+    // called from lexing worker threads, this can neither throw nor tora_malloc
+    char buffer[64];
+    char *value = buffer;
+    if(length >= sizeof(buffer))
+    {
+        value = malloc(length + 1);
+        if(!value)
+        {
+            return NAN;
+        }
+    }
+    memcpy(value, str, length);
+    value[length] = '\0';
+    
+    double result = tora_c_locale ? strtod_l(value, NULL, tora_c_locale) : strtod(value, NULL);
+    
+    if(value != buffer)
+    {
+        free(value);
+    }
+    return result;
+}
+
+// Helpers
+int hex_digit_value(char ch)
+{
+    if(ch >= '0' && ch <= '9') return ch - '0';
+    if(ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    if(ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return 0;
+}
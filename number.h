@@ -0,0 +1,23 @@
+//
+//  number.h
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#ifndef number_h
+#define number_h
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// Converts a numeric literal which has already been recognised by the lexer
+// (decimal with optional fraction and exponent, or 0x prefixed hex) into its
+// correctly rounded double value, independent of the current locale
+double tora_parse_number(const char *str, size_t length);
+
+bool tora_number_init(void);
+void tora_number_shutdown(void);
+
+#endif /* number_h */
@@ -0,0 +1,2313 @@
+//
+//  optimiser.c
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "tora.h"
+
+// The most nodes a function's result can be built from for its calls to be inlined
+#define TORA_OPTIMISER_INLINE_NODES 24
+
+// The most statements, and expressions within them, that are searched at once for
+// expressions worked out more than once
+#define TORA_OPTIMISER_SHARE_STATEMENTS 32
+#define TORA_OPTIMISER_SHARE_OCCURRENCES 256
+
+// Every name the program binds, whether it's assigned to, names a function or is one
+// of a function's parameters. A name that's only ever bound once, by a top-level
+// assignment of a literal, is a constant. local_bindings counts those made within
+// a function, which could hide a top-level name from a function's callers
+typedef struct {
+    const char *name;
+    uint32_t bindings;
+    uint32_t local_bindings;
+    void *constant;
+    
+    // How many times the name's read, once the program's been optimised
+    uint32_t uses;
+    
+    // A function bound once at the top level whose calls can be replaced by the
+    // expression its body works out (see optimiser_inline_body)
+    TORAParserLambdaExpression *function;
+    void *inline_body;
+} TORAOptimiserSymbol;
+
+// Somewhere an expression that could be shared is evaluated, or where an assignment's
+// made that could change what one evaluates to (see optimiser_share)
+typedef struct {
+    void **slot;
+    void *parent;
+    bool store;
+} TORAOptimiserOccurrence;
+
+typedef struct {
+    TORAOptimiserSymbol *symbols;
+    uint32_t num_symbols;
+    uint32_t capacity;
+    
+    // The top-level assignments which made constants, in the order they were made
+    TORAParserAssignOrBinaryExpression **constants;
+    uint32_t num_constants;
+    uint32_t constants_capacity;
+    
+    // How many functions deep the bindings being counted are
+    uint32_t depth;
+    
+    // How many temporaries inlined calls have assigned their arguments to
+    uint32_t num_temporaries;
+    
+    // The function whose body's being eliminated from, if any, and whether any
+    // function's body is still to be parsed
+    TORAParserLambdaExpression *function;
+    bool lazy;
+    
+    // The expressions that could be shared within the run of statements being searched
+    TORAOptimiserOccurrence *occurrences;
+    uint32_t num_occurrences;
+    uint32_t occurrences_capacity;
+} TORAOptimiser;
+
+// Symbols
+void optimiser_init(TORAOptimiser *optimiser);
+void optimiser_free(TORAOptimiser *optimiser);
+TORAOptimiserSymbol *optimiser_symbol(TORAOptimiser *optimiser, const char *name);
+void optimiser_grow_symbols(TORAOptimiser *optimiser);
+void optimiser_add_constant(TORAOptimiser *optimiser, TORAParserAssignOrBinaryExpression *statement);
+void optimiser_count_bindings(TORAOptimiser *optimiser, void *expression);
+void optimiser_count_list_bindings(TORAOptimiser *optimiser, TORAParserExpressionList *list);
+void optimiser_bind(TORAOptimiser *optimiser, const char *name);
+
+// Folding
+void *optimiser_fold(TORAOptimiser *optimiser, void *expression);
+void *optimiser_fold_statement(TORAOptimiser *optimiser, void *expression);
+void optimiser_fold_list(TORAOptimiser *optimiser, TORAParserExpressionList *list);
+void optimiser_fold_index(TORAOptimiser *optimiser, TORAParserArrayIndexExpression *index_expression);
+void *optimiser_fold_binary(TORAOptimiser *optimiser, TORAParserAssignOrBinaryExpression *binary_expression);
+void *optimiser_fold_literals(TORATokenKind op, TORAParserUnknownExpression *a, TORAParserUnknownExpression *b);
+void *optimiser_concat(void *left, void *right);
+void *optimiser_fold_negation(TORAOptimiser *optimiser, TORAParserNegativeUnaryExpression *negative_expression);
+void *optimiser_fold_call(TORAOptimiser *optimiser, TORAParserCallExpression *call_expression, bool inline_call);
+
+// Inlining
+void *optimiser_inline_body(TORAOptimiser *optimiser, TORAParserLambdaExpression *function);
+void *optimiser_inline_call(TORAOptimiser *optimiser, TORAParserCallExpression *call_expression);
+void *optimiser_inline_copy(void *expression, TORAParserExpressionList *parameters, TORAParserExpressionList *arguments);
+TORAParserExpressionList *optimiser_inline_copy_list(TORAParserExpressionList *list, TORAParserExpressionList *parameters, TORAParserExpressionList *arguments);
+void optimiser_inline_uses(void *expression, TORAParserExpressionList *parameters, uint32_t *uses, bool *indexed);
+int32_t optimiser_parameter(TORAParserExpressionList *parameters, const char *name);
+uint32_t optimiser_size(void *expression);
+
+// Elimination
+void *optimiser_eliminate(TORAOptimiser *optimiser, void *expression, bool statement);
+void optimiser_eliminate_list(TORAOptimiser *optimiser, TORAParserExpressionList *list);
+void optimiser_eliminate_statements(TORAOptimiser *optimiser, TORAParserProgExpression *prog, bool statement);
+bool optimiser_is_dead_store(TORAOptimiser *optimiser, TORAParserProgExpression *prog, uint32_t i);
+bool optimiser_is_unused(TORAOptimiser *optimiser, void *expression, TORAParserExpressionList *statements, uint32_t num_statements);
+bool optimiser_is_safe(TORAOptimiser *optimiser, void *expression, TORAParserExpressionList *statements, uint32_t num_statements);
+bool optimiser_is_assigned(TORAOptimiser *optimiser, const char *name, TORAParserExpressionList *statements, uint32_t num_statements);
+bool optimiser_can_return(void *expression);
+bool optimiser_always_returns(TORAOptimiser *optimiser, void *expression, TORAParserExpressionList *statements, uint32_t num_statements);
+bool optimiser_uses_name(void *expression, const char *name);
+bool optimiser_is_captured(void *expression, const char *name);
+void optimiser_count_uses(TORAOptimiser *optimiser, void *expression, int32_t delta);
+void optimiser_remove_unused_functions(TORAOptimiser *optimiser, TORAParserProgExpression *prog);
+int32_t optimiser_count_name(void *expression, const char *name);
+
+// Sharing
+void optimiser_share(TORAOptimiser *optimiser, void *expression);
+void optimiser_share_statements(TORAOptimiser *optimiser, TORAParserExpressionList *statements);
+bool optimiser_share_run(TORAOptimiser *optimiser, TORAParserExpressionList *statements, uint32_t first, uint32_t last);
+void optimiser_gather(TORAOptimiser *optimiser, void **slot, void *parent);
+void optimiser_add_occurrence(TORAOptimiser *optimiser, void **slot, void *parent, bool store);
+bool optimiser_is_straight(void *expression);
+bool optimiser_can_hold(TORAOptimiserOccurrence *occurrence);
+bool optimiser_is_killed(TORAOptimiserOccurrence *store, void *expression);
+bool optimiser_reads_array(void *expression);
+bool optimiser_equal(void *a, void *b);
+
+// Helpers
+const TORABuiltin *optimiser_builtin(TORAOptimiser *optimiser, void *func);
+bool optimiser_is_literal(void *expression);
+bool optimiser_is_numeric(TORAOptimiser *optimiser, void *expression);
+bool optimiser_is_number(void *expression, double val);
+bool optimiser_is_pure(TORAOptimiser *optimiser, void *expression, TORAParserExpressionList *parameters);
+bool optimiser_has_value(void *expression);
+uint32_t optimiser_num_children(void *expression);
+void *optimiser_child(void *expression, uint32_t i);
+
+TORAParserExpressionList *optimise_program(TORAParserProgExpression *prog, TORAArena *arena)
+{
+    assert(prog);
+    assert(arena);
+    
+    TORAOptimiser optimiser;
+    optimiser_init(&optimiser);
+    optimiser_count_bindings(&optimiser, prog);
+    
+    parser_arena = arena;
+    for(uint32_t i = 0; i < prog->val->length; i++)
+    {
+        TORAParserAssignOrBinaryExpression *statement = optimiser_fold_statement(&optimiser, prog->val->items[i]);
+        prog->val->items[i] = statement;
+        
+        // Top-level statements run in order, so once a constant has been assigned any
+        // statement after this one can use its value in place of its name
+        if(statement->type == TORAExpressionTypeAssign &&
+           ((TORAParserUnknownExpression *)statement->left)->type == TORAExpressionTypeVariable &&
+           optimiser_is_literal(statement->right))
+        {
+            TORAOptimiserSymbol *symbol = optimiser_symbol(&optimiser, ((TORAParserVariableExpression *)statement->left)->val);
+            if(symbol->bindings == 1)
+            {
+                symbol->constant = statement->right;
+                optimiser_add_constant(&optimiser, statement);
+            }
+        }
+        
+        // Likewise a function's calls can be inlined once it's been defined, if its
+        // body's been parsed by now
+        if(statement->type == TORAExpressionTypeLambda)
+        {
+            TORAParserLambdaExpression *function_expression = (TORAParserLambdaExpression *)statement;
+            if(function_expression->name && function_expression->body)
+            {
+                TORAOptimiserSymbol *symbol = optimiser_symbol(&optimiser, function_expression->name);
+                if(symbol->bindings == 1)
+                {
+                    symbol->inline_body = optimiser_inline_body(&optimiser, function_expression);
+                    symbol->function = function_expression;
+                }
+            }
+        }
+    }
+    
+    // With everything folded, whatever can't affect the program's removed. Functions
+    // are only known to be unused once every function's body has been parsed
+    optimiser_eliminate(&optimiser, prog, true);
+    optimiser_count_uses(&optimiser, prog, 1);
+    if(!optimiser.lazy)
+    {
+        optimiser_remove_unused_functions(&optimiser, prog);
+    }
+    optimiser_share(&optimiser, prog);
+    
+    TORAParserExpressionList *constants = arena_alloc(arena, sizeof(TORAParserExpressionList) + optimiser.num_constants * sizeof(void *));
+    constants->length = optimiser.num_constants;
+    for(uint32_t i = 0; i < optimiser.num_constants; i++)
+    {
+        constants->items[i] = optimiser.constants[i];
+    }
+    parser_arena = NULL;
+    
+    optimiser_free(&optimiser);
+    return constants;
+}
+void optimise_function(TORAParserLambdaExpression *function, TORAParserExpressionList *globals, TORAParserExpressionList *constants, TORAArena *arena)
+{
+    assert(function);
+    assert(arena);
+    
+    TORAOptimiser optimiser;
+    optimiser_init(&optimiser);
+    
+    // The top level's names are each bound there once. Anything the function binds
+    // itself adds to that, so a constant it rebinds is no longer treated as one
+    for(uint32_t i = 0; i < globals->length; i++)
+    {
+        optimiser_symbol(&optimiser, ((TORAParserVariableExpression *)globals->items[i])->val)->bindings++;
+    }
+    for(uint32_t i = 0; i < constants->length; i++)
+    {
+        TORAParserAssignOrBinaryExpression *statement = constants->items[i];
+        optimiser_symbol(&optimiser, ((TORAParserVariableExpression *)statement->left)->val)->constant = statement->right;
+    }
+    optimiser_count_bindings(&optimiser, function);
+    
+    parser_arena = arena;
+    function->body = optimiser_fold(&optimiser, function->body);
+    optimiser_eliminate(&optimiser, function, false);
+    optimiser_share(&optimiser, function);
+    parser_arena = NULL;
+    
+    optimiser_free(&optimiser);
+}
+
+// Symbols
+void optimiser_init(TORAOptimiser *optimiser)
+{
+    optimiser->num_symbols = 0;
+    optimiser->capacity = 0;
+    optimiser->symbols = NULL;
+    optimiser_grow_symbols(optimiser);
+    
+    optimiser->constants = NULL;
+    optimiser->num_constants = 0;
+    optimiser->constants_capacity = 0;
+    optimiser->depth = 0;
+    optimiser->num_temporaries = 0;
+    optimiser->function = NULL;
+    optimiser->lazy = false;
+    optimiser->occurrences = NULL;
+    optimiser->num_occurrences = 0;
+    optimiser->occurrences_capacity = 0;
+}
+void optimiser_free(TORAOptimiser *optimiser)
+{
+    tora_free(optimiser->symbols);
+    if(optimiser->constants)
+    {
+        tora_free(optimiser->constants);
+    }
+    if(optimiser->occurrences)
+    {
+        tora_free(optimiser->occurrences);
+    }
+}
+TORAOptimiserSymbol *optimiser_symbol(TORAOptimiser *optimiser, const char *name)
+{
+    // Keep the table no more than half full, so probes stay short
+    if((optimiser->num_symbols + 1) * 2 > optimiser->capacity)
+    {
+        optimiser_grow_symbols(optimiser);
+    }
+    
+    uint32_t mask = optimiser->capacity - 1;
+    uint32_t i = tora_strhash(name) & mask;
+    while(optimiser->symbols[i].name)
+    {
+        if(strcmp(optimiser->symbols[i].name, name) == 0)
+        {
+            return &optimiser->symbols[i];
+        }
+        i = (i + 1) & mask;
+    }
+    
+    optimiser->symbols[i].name = name;
+    optimiser->num_symbols++;
+    return &optimiser->symbols[i];
+}
+void optimiser_grow_symbols(TORAOptimiser *optimiser)
+{
+    uint32_t capacity = optimiser->capacity ? optimiser->capacity * 2 : 64;
+    TORAOptimiserSymbol *symbols = tora_malloc(capacity * sizeof(TORAOptimiserSymbol));
+    if(!symbols)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for optimiser symbols");
+    }
+    memset(symbols, 0, capacity * sizeof(TORAOptimiserSymbol));
+    
+    for(uint32_t i = 0; i < optimiser->capacity; i++)
+    {
+        TORAOptimiserSymbol *symbol = &optimiser->symbols[i];
+        if(!symbol->name) continue;
+        
+        uint32_t j = tora_strhash(symbol->name) & (capacity - 1);
+        while(symbols[j].name)
+        {
+            j = (j + 1) & (capacity - 1);
+        }
+        symbols[j] = *symbol;
+    }
+    
+    if(optimiser->symbols)
+    {
+        tora_free(optimiser->symbols);
+    }
+    optimiser->symbols = symbols;
+    optimiser->capacity = capacity;
+}
+void optimiser_add_constant(TORAOptimiser *optimiser, TORAParserAssignOrBinaryExpression *statement)
+{
+    if(optimiser->num_constants == optimiser->constants_capacity)
+    {
+        uint32_t capacity = optimiser->constants_capacity ? optimiser->constants_capacity * 2 : 16;
+        TORAParserAssignOrBinaryExpression **constants = optimiser->constants ? realloc(optimiser->constants, capacity * sizeof(void *)) : tora_malloc(capacity * sizeof(void *));
+        if(!constants)
+        {
+            TORA_RUNTIME_EXCEPTION("Failed to malloc space for optimiser constants");
+        }
+        optimiser->constants = constants;
+        optimiser->constants_capacity = capacity;
+    }
+    optimiser->constants[optimiser->num_constants++] = statement;
+}
+void optimiser_count_bindings(TORAOptimiser *optimiser, void *expression)
+{
+    if(!expression) return;
+    
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeAssign:
+        {
+            TORAParserAssignOrBinaryExpression *assign_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            TORAParserUnknownExpression *left = assign_expression->left;
+            
+            // Assigning to an index of an array rebinds the array's name too
+            if(left->type == TORAExpressionTypeArrayIndex)
+            {
+                left = ((TORAParserArrayIndexExpression *)left)->array;
+            }
+            if(left->type == TORAExpressionTypeVariable)
+            {
+                optimiser_bind(optimiser, ((TORAParserVariableExpression *)left)->val);
+            }
+            
+            optimiser_count_bindings(optimiser, assign_expression->left);
+            optimiser_count_bindings(optimiser, assign_expression->right);
+        }
+            break;
+        case TORAExpressionTypeBinary:
+        {
+            TORAParserAssignOrBinaryExpression *binary_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            optimiser_count_bindings(optimiser, binary_expression->left);
+            optimiser_count_bindings(optimiser, binary_expression->right);
+        }
+            break;
+        case TORAExpressionTypeLambda:
+        {
+            TORAParserLambdaExpression *function_expression = (TORAParserLambdaExpression *)expression;
+            if(function_expression->name)
+            {
+                optimiser_bind(optimiser, function_expression->name);
+            }
+            
+            optimiser->depth++;
+            for(uint32_t i = 0; i < function_expression->arguments->length; i++)
+            {
+                TORAParserVariableExpression *parameter = function_expression->arguments->items[i];
+                optimiser_bind(optimiser, parameter->val);
+            }
+            optimiser_count_bindings(optimiser, function_expression->body);
+            optimiser->depth--;
+        }
+            break;
+        case TORAExpressionTypeCall:
+        {
+            TORAParserCallExpression *call_expression = (TORAParserCallExpression *)expression;
+            optimiser_count_bindings(optimiser, call_expression->func);
+            optimiser_count_list_bindings(optimiser, call_expression->arguments);
+        }
+            break;
+        case TORAExpressionTypeWhile:
+        {
+            TORAParserWhileExpression *while_expression = (TORAParserWhileExpression *)expression;
+            optimiser_count_bindings(optimiser, while_expression->condition);
+            optimiser_count_bindings(optimiser, while_expression->body);
+        }
+            break;
+        case TORAExpressionTypeIfThenElse:
+        {
+            TORAParserIfThenElseExpression *if_expression = (TORAParserIfThenElseExpression *)expression;
+            optimiser_count_bindings(optimiser, if_expression->condition);
+            optimiser_count_bindings(optimiser, if_expression->then);
+            optimiser_count_bindings(optimiser, if_expression->el);
+        }
+            break;
+        case TORAExpressionTypeProg:
+            optimiser_count_list_bindings(optimiser, ((TORAParserProgExpression *)expression)->val);
+            break;
+        case TORAExpressionTypeArray:
+        {
+            TORAParserArrayExpression *array_expression = (TORAParserArrayExpression *)expression;
+            if(array_expression->items)
+            {
+                optimiser_count_list_bindings(optimiser, array_expression->items);
+            }
+        }
+            break;
+        case TORAExpressionTypeArrayIndex:
+        {
+            TORAParserArrayIndexExpression *index_expression = (TORAParserArrayIndexExpression *)expression;
+            optimiser_count_bindings(optimiser, index_expression->array);
+            optimiser_count_bindings(optimiser, index_expression->index);
+        }
+            break;
+        case TORAExpressionTypeNegativeUnary:
+            optimiser_count_bindings(optimiser, ((TORAParserNegativeUnaryExpression *)expression)->expression);
+            break;
+        case TORAExpressionTypeReturn:
+            optimiser_count_bindings(optimiser, ((TORAParserReturnExpression *)expression)->expression);
+            break;
+        default:
+            break;
+    }
+}
+void optimiser_count_list_bindings(TORAOptimiser *optimiser, TORAParserExpressionList *list)
+{
+    for(uint32_t i = 0; i < list->length; i++)
+    {
+        optimiser_count_bindings(optimiser, list->items[i]);
+    }
+}
+void optimiser_bind(TORAOptimiser *optimiser, const char *name)
+{
+    TORAOptimiserSymbol *symbol = optimiser_symbol(optimiser, name);
+    symbol->bindings++;
+    if(optimiser->depth > 0)
+    {
+        symbol->local_bindings++;
+    }
+}
+
+// Folding
+// Returns the expression to use in place of the one given, which may be the same
+// expression with its children folded or a literal holding the value it evaluates to
+void *optimiser_fold(TORAOptimiser *optimiser, void *expression)
+{
+    if(!expression) return NULL;
+    
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeVariable:
+        {
+            TORAOptimiserSymbol *symbol = optimiser_symbol(optimiser, ((TORAParserVariableExpression *)expression)->val);
+            if(symbol->constant && symbol->bindings == 1)
+            {
+                return symbol->constant;
+            }
+        }
+            break;
+        case TORAExpressionTypeAssign:
+        {
+            // The left-hand side names where the value is stored, so only an array index within it can be folded
+            TORAParserAssignOrBinaryExpression *assign_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            if(((TORAParserUnknownExpression *)assign_expression->left)->type == TORAExpressionTypeArrayIndex)
+            {
+                optimiser_fold_index(optimiser, assign_expression->left);
+            }
+            assign_expression->right = optimiser_fold(optimiser, assign_expression->right);
+        }
+            break;
+        case TORAExpressionTypeBinary:
+            return optimiser_fold_binary(optimiser, expression);
+            break;
+        case TORAExpressionTypeNegativeUnary:
+            return optimiser_fold_negation(optimiser, expression);
+            break;
+        case TORAExpressionTypeCall:
+            return optimiser_fold_call(optimiser, expression, true);
+            break;
+        case TORAExpressionTypeBuiltinCall:
+            optimiser_fold_list(optimiser, ((TORAParserBuiltinCallExpression *)expression)->arguments);
+            break;
+        case TORAExpressionTypeArrayIndex:
+            optimiser_fold_index(optimiser, expression);
+            break;
+        case TORAExpressionTypeLambda:
+        {
+            // A function whose body hasn't been parsed yet can use whichever constants
+            // have been assigned by now once it is
+            TORAParserLambdaExpression *function_expression = (TORAParserLambdaExpression *)expression;
+            function_expression->body = optimiser_fold(optimiser, function_expression->body);
+            if(!function_expression->body)
+            {
+                function_expression->num_constants = optimiser->num_constants;
+            }
+        }
+            break;
+        case TORAExpressionTypeWhile:
+        {
+            TORAParserWhileExpression *while_expression = (TORAParserWhileExpression *)expression;
+            while_expression->condition = optimiser_fold(optimiser, while_expression->condition);
+            while_expression->body = optimiser_fold_statement(optimiser, while_expression->body);
+        }
+            break;
+        case TORAExpressionTypeIfThenElse:
+        {
+            TORAParserIfThenElseExpression *if_expression = (TORAParserIfThenElseExpression *)expression;
+            if_expression->condition = optimiser_fold(optimiser, if_expression->condition);
+            if_expression->then = optimiser_fold_statement(optimiser, if_expression->then);
+            if_expression->el = optimiser_fold_statement(optimiser, if_expression->el);
+        }
+            break;
+        case TORAExpressionTypeProg:
+        {
+            TORAParserExpressionList *statements = ((TORAParserProgExpression *)expression)->val;
+            for(uint32_t i = 0; i < statements->length; i++)
+            {
+                statements->items[i] = optimiser_fold_statement(optimiser, statements->items[i]);
+            }
+        }
+            break;
+        case TORAExpressionTypeArray:
+        {
+            TORAParserArrayExpression *array_expression = (TORAParserArrayExpression *)expression;
+            if(array_expression->items)
+            {
+                optimiser_fold_list(optimiser, array_expression->items);
+            }
+        }
+            break;
+        case TORAExpressionTypeReturn:
+        {
+            TORAParserReturnExpression *return_expression = (TORAParserReturnExpression *)expression;
+            return_expression->expression = optimiser_fold(optimiser, return_expression->expression);
+        }
+            break;
+        default:
+            break;
+    }
+    
+    return expression;
+}
+// A call made as a statement (or as the body of a loop or if) returns from whichever
+// function it's made in when the function it calls does, so is never inlined
+void *optimiser_fold_statement(TORAOptimiser *optimiser, void *expression)
+{
+    if(expression && ((TORAParserUnknownExpression *)expression)->type == TORAExpressionTypeCall)
+    {
+        return optimiser_fold_call(optimiser, expression, false);
+    }
+    return optimiser_fold(optimiser, expression);
+}
+void optimiser_fold_list(TORAOptimiser *optimiser, TORAParserExpressionList *list)
+{
+    for(uint32_t i = 0; i < list->length; i++)
+    {
+        list->items[i] = optimiser_fold(optimiser, list->items[i]);
+    }
+}
+// Arrays are looked up by name when they're indexed, so a variable naming one is left alone
+void optimiser_fold_index(TORAOptimiser *optimiser, TORAParserArrayIndexExpression *index_expression)
+{
+    if(((TORAParserUnknownExpression *)index_expression->array)->type != TORAExpressionTypeVariable)
+    {
+        index_expression->array = optimiser_fold(optimiser, index_expression->array);
+    }
+    index_expression->index = optimiser_fold(optimiser, index_expression->index);
+}
+void *optimiser_fold_binary(TORAOptimiser *optimiser, TORAParserAssignOrBinaryExpression *binary_expression)
+{
+    binary_expression->left = optimiser_fold(optimiser, binary_expression->left);
+    binary_expression->right = optimiser_fold(optimiser, binary_expression->right);
+    
+    TORATokenKind op = operator_kind(binary_expression->op, strlen(binary_expression->op));
+    void *left = binary_expression->left;
+    void *right = binary_expression->right;
+    if(optimiser_is_literal(left) && optimiser_is_literal(right))
+    {
+        void *result = optimiser_fold_literals(op, left, right);
+        if(result)
+        {
+            return result;
+        }
+    }
+    
+    // Adding anything to a string builds a string, so a run of + that starts with
+    // one is gathered up into a single concatenation as it's folded
+    if(op == TORATokenKindAdd &&
+       (((TORAParserUnknownExpression *)left)->type == TORAExpressionTypeString ||
+        ((TORAParserUnknownExpression *)left)->type == TORAExpressionTypeConcat))
+    {
+        return optimiser_concat(left, right);
+    }
+    
+    // x * 1, 1 * x, x / 1 and x - 0 leave any number as it was. x + 0 isn't included,
+    // as it turns -0 into 0 (and would append "0" to a string)
+    if(op == TORATokenKindMultiply)
+    {
+        if(optimiser_is_number(right, 1) && optimiser_is_numeric(optimiser, left)) return left;
+        if(optimiser_is_number(left, 1) && optimiser_is_numeric(optimiser, right)) return right;
+    }
+    else if(op == TORATokenKindDivide)
+    {
+        if(optimiser_is_number(right, 1) && optimiser_is_numeric(optimiser, left)) return left;
+    }
+    else if(op == TORATokenKindSubtract)
+    {
+        if(optimiser_is_number(right, 0) && optimiser_is_numeric(optimiser, left)) return left;
+    }
+    
+    return binary_expression;
+}
+// Evaluates an operator over two literals, or returns NULL if their types mean it
+// can't be (or would fail when the program's run, which is left to happen then)
+void *optimiser_fold_literals(TORATokenKind op, TORAParserUnknownExpression *a, TORAParserUnknownExpression *b)
+{
+    bool numeric = a->type == TORAExpressionTypeNumeric && b->type == TORAExpressionTypeNumeric;
+    switch(op)
+    {
+        case TORATokenKindAdd:
+        {
+            // Concatenating onto a string is done here, as the interpreter's own
+            // implementation queues the intermediate string it creates for release
+            if(a->type == TORAExpressionTypeString)
+            {
+                TORAParserStringExpression *string_a = (TORAParserStringExpression *)a;
+                TORAParserStringExpression *string_b = string_representation_for_expression(b);
+                
+                size_t length_a = strlen(string_a->val);
+                size_t length_b = strlen(string_b->val);
+                char *val = tora_malloc(length_a + length_b + 1);
+                if(!val)
+                {
+                    TORA_RUNTIME_EXCEPTION("Malloc failed during string concatenation");
+                }
+                memcpy(val, string_a->val, length_a);
+                memcpy(val + length_a, string_b->val, length_b + 1);
+                
+                void *result = new_string_expression_with_length(val, length_a + length_b);
+                tora_free(val);
+                return result;
+            }
+            else if(a->type == TORAExpressionTypeNumeric && b->type != TORAExpressionTypeBoolean)
+            {
+                return apply_op(op, a, b);
+            }
+        }
+            break;
+        case TORATokenKindSubtract:
+        case TORATokenKindMultiply:
+        case TORATokenKindDivide:
+        case TORATokenKindModulo:
+        case TORATokenKindLess:
+        case TORATokenKindGreater:
+        case TORATokenKindLessEqual:
+        case TORATokenKindGreaterEqual:
+            if(numeric)
+            {
+                return apply_op(op, a, b);
+            }
+            break;
+        case TORATokenKindAnd:
+        case TORATokenKindOr:
+        case TORATokenKindEqual:
+        case TORATokenKindNotEqual:
+            return apply_op(op, a, b);
+            break;
+        default:
+            break;
+    }
+    
+    return NULL;
+}
+// Appends right to the pieces of left, which is either a string or a concatenation
+// already. Neighbouring string literals are joined as they're added
+void *optimiser_concat(void *left, void *right)
+{
+    TORAParserExpressionList *pieces = NULL;
+    if(((TORAParserUnknownExpression *)left)->type == TORAExpressionTypeConcat)
+    {
+        pieces = ((TORAParserConcatExpression *)left)->pieces;
+    }
+    uint32_t num_pieces = pieces ? pieces->length : 1;
+    void *last = pieces ? pieces->items[num_pieces - 1] : left;
+    
+    bool join = ((TORAParserUnknownExpression *)last)->type == TORAExpressionTypeString &&
+                ((TORAParserUnknownExpression *)right)->type == TORAExpressionTypeString;
+    uint32_t length = join ? num_pieces : num_pieces + 1;
+    
+    TORAParserExpressionList *new_pieces = arena_alloc(parser_arena, sizeof(TORAParserExpressionList) + length * sizeof(void *));
+    new_pieces->length = length;
+    for(uint32_t i = 0; i < num_pieces; i++)
+    {
+        new_pieces->items[i] = pieces ? pieces->items[i] : left;
+    }
+    
+    if(join)
+    {
+        const char *val_a = ((TORAParserStringExpression *)last)->val;
+        const char *val_b = ((TORAParserStringExpression *)right)->val;
+        size_t length_a = strlen(val_a);
+        size_t length_b = strlen(val_b);
+        
+        char *val = arena_alloc(parser_arena, length_a + length_b + 1);
+        memcpy(val, val_a, length_a);
+        memcpy(val + length_a, val_b, length_b + 1);
+        new_pieces->items[num_pieces - 1] = new_string_expression_with_length(val, length_a + length_b);
+    }
+    else
+    {
+        new_pieces->items[num_pieces] = right;
+    }
+    
+    return new_concat_expression(new_pieces);
+}
+void *optimiser_fold_negation(TORAOptimiser *optimiser, TORAParserNegativeUnaryExpression *negative_expression)
+{
+    void *operand = optimiser_fold(optimiser, negative_expression->expression);
+    negative_expression->expression = operand;
+    
+    TORAParserUnknownExpression *unknown_operand = (TORAParserUnknownExpression *)operand;
+    if(unknown_operand->type == TORAExpressionTypeNumeric)
+    {
+        return new_numeric_expression(-((TORAParserNumericExpression *)operand)->val);
+    }
+    // Negating a number twice leaves it as it was
+    else if(unknown_operand->type == TORAExpressionTypeNegativeUnary)
+    {
+        void *inner = ((TORAParserNegativeUnaryExpression *)operand)->expression;
+        if(optimiser_is_numeric(optimiser, inner))
+        {
+            return inner;
+        }
+    }
+    
+    return negative_expression;
+}
+void *optimiser_fold_call(TORAOptimiser *optimiser, TORAParserCallExpression *call_expression, bool inline_call)
+{
+    // Functions are called by name, so only a function produced some other way is folded
+    if(((TORAParserUnknownExpression *)call_expression->func)->type != TORAExpressionTypeVariable)
+    {
+        call_expression->func = optimiser_fold(optimiser, call_expression->func);
+    }
+    optimiser_fold_list(optimiser, call_expression->arguments);
+    
+    // Calls to builtins are resolved here rather than being looked up by name each time
+    // they're made. One with too few arguments is left to fail when it's called
+    const TORABuiltin *builtin = optimiser_builtin(optimiser, call_expression->func);
+    if(!builtin || call_expression->arguments->length < builtin->num_arguments)
+    {
+        void *inlined = inline_call ? optimiser_inline_call(optimiser, call_expression) : NULL;
+        return inlined ? inlined : call_expression;
+    }
+    
+    bool constant = builtin->pure;
+    for(uint32_t i = 0; i < call_expression->arguments->length && constant; i++)
+    {
+        constant = ((TORAParserUnknownExpression *)call_expression->arguments->items[i])->type == TORAExpressionTypeNumeric;
+    }
+    
+    if(constant)
+    {
+        return builtin->function((TORAParserUnknownExpression **)call_expression->arguments->items, call_expression->arguments->length);
+    }
+    return new_builtin_call_expression(builtin, call_expression->arguments);
+}
+
+// Inlining
+// Works out the expression a call to function can be replaced with, or NULL if it has
+// to be called. That's only when its body does nothing but work out a result from its
+// parameters and names no function binds, after any number of ifs returning early. A
+// call never evaluates to nothing, so a result which might is wrapped in a prog, which
+// evaluates to false in its place just as the call would
+void *optimiser_inline_body(TORAOptimiser *optimiser, TORAParserLambdaExpression *function)
+{
+    // A parameter bound to nothing is looked up by name outside the function instead,
+    // which only finds the same thing as an inlined call would if nothing's there
+    TORAParserExpressionList *parameters = function->arguments;
+    for(uint32_t i = 0; i < parameters->length; i++)
+    {
+        const char *name = ((TORAParserVariableExpression *)parameters->items[i])->val;
+        TORAOptimiserSymbol *symbol = optimiser_symbol(optimiser, name);
+        if(symbol->bindings != symbol->local_bindings || optimiser_parameter(parameters, name) != (int32_t)i)
+        {
+            return NULL;
+        }
+    }
+    
+    TORAParserProgExpression *body = function->body;
+    if(body->type != TORAExpressionTypeProg || body->val->length == 0)
+    {
+        return NULL;
+    }
+    
+    TORAParserExpressionList *statements = body->val;
+    void *result = statements->items[statements->length - 1];
+    if(((TORAParserUnknownExpression *)result)->type == TORAExpressionTypeReturn)
+    {
+        result = ((TORAParserReturnExpression *)result)->expression;
+    }
+    if(!result || !optimiser_is_pure(optimiser, result, parameters))
+    {
+        return NULL;
+    }
+    if(!optimiser_has_value(result))
+    {
+        TORAParserExpressionList *list = arena_alloc(parser_arena, sizeof(TORAParserExpressionList) + sizeof(void *));
+        list->length = 1;
+        list->items[0] = result;
+        result = new_prog_expression(list);
+    }
+    
+    // Each if returning early has the rest of the body as its else
+    for(uint32_t i = statements->length - 1; i-- > 0;)
+    {
+        TORAParserIfThenElseExpression *if_expression = statements->items[i];
+        if(if_expression->type != TORAExpressionTypeIfThenElse || if_expression->el)
+        {
+            return NULL;
+        }
+        
+        TORAParserReturnExpression *return_expression = if_expression->then;
+        if(return_expression->type == TORAExpressionTypeProg && ((TORAParserProgExpression *)if_expression->then)->val->length == 1)
+        {
+            return_expression = ((TORAParserProgExpression *)if_expression->then)->val->items[0];
+        }
+        if(return_expression->type != TORAExpressionTypeReturn ||
+           !return_expression->expression ||
+           !optimiser_is_pure(optimiser, return_expression->expression, parameters) ||
+           !optimiser_is_pure(optimiser, if_expression->condition, parameters))
+        {
+            return NULL;
+        }
+        result = new_if_expression(if_expression->condition, return_expression->expression, result);
+    }
+    
+    return optimiser_size(result) <= TORA_OPTIMISER_INLINE_NODES ? result : NULL;
+}
+// Replaces a call to a function that can be inlined with the expression its body works
+// out, with the call's arguments in place of its parameters. A call evaluates each of
+// its arguments once before anything else, so one that isn't a literal or a variable
+// can only replace a parameter used once, and never after an early return. Otherwise
+// it's assigned to a temporary first, if it's certain to have a value to assign
+void *optimiser_inline_call(TORAOptimiser *optimiser, TORAParserCallExpression *call_expression)
+{
+    if(((TORAParserUnknownExpression *)call_expression->func)->type != TORAExpressionTypeVariable)
+    {
+        return NULL;
+    }
+    
+    TORAOptimiserSymbol *symbol = optimiser_symbol(optimiser, ((TORAParserVariableExpression *)call_expression->func)->val);
+    if(!symbol->inline_body || symbol->bindings != 1)
+    {
+        return NULL;
+    }
+    
+    // Any arguments past the function's parameters would never be evaluated
+    TORAParserExpressionList *parameters = symbol->function->arguments;
+    TORAParserExpressionList *arguments = call_expression->arguments;
+    if(arguments->length != parameters->length)
+    {
+        return NULL;
+    }
+    
+    uint32_t num_parameters = parameters->length > 0 ? parameters->length : 1;
+    uint32_t uses[num_parameters];
+    bool indexed[num_parameters];
+    memset(uses, 0, sizeof(uses));
+    memset(indexed, 0, sizeof(indexed));
+    optimiser_inline_uses(symbol->inline_body, parameters, uses, indexed);
+    
+    // A prog carries on past a return of nothing, so each early return has to be certain
+    // to return something once the call's arguments are in place
+    bool early_return = false;
+    for(TORAParserIfThenElseExpression *if_expression = symbol->inline_body; if_expression->type == TORAExpressionTypeIfThenElse; if_expression = if_expression->el)
+    {
+        TORAParserUnknownExpression *result = if_expression->then;
+        if(result->type == TORAExpressionTypeVariable && optimiser_parameter(parameters, ((TORAParserVariableExpression *)result)->val) >= 0)
+        {
+            result = arguments->items[optimiser_parameter(parameters, ((TORAParserVariableExpression *)result)->val)];
+        }
+        if(!optimiser_has_value(result))
+        {
+            return NULL;
+        }
+        early_return = true;
+    }
+    
+    uint32_t num_temporaries = 0;
+    for(uint32_t i = 0; i < arguments->length; i++)
+    {
+        TORAParserUnknownExpression *argument = arguments->items[i];
+        if(argument->type == TORAExpressionTypeVariable || optimiser_is_literal(argument))
+        {
+            continue;
+        }
+        if(!optimiser_is_pure(optimiser, argument, NULL))
+        {
+            return NULL;
+        }
+        
+        // Indexing a parameter looks it up by name, which reports an undefined array
+        // where indexing anything else wouldn't
+        if(indexed[i] || uses[i] != 1 || early_return)
+        {
+            if(!optimiser_has_value(argument))
+            {
+                return NULL;
+            }
+            num_temporaries++;
+        }
+    }
+    
+    // Temporaries are named so that they can't be confused with any of the program's
+    // own variables, or each other's when one inlined call is an argument to another
+    TORAParserExpressionList *statements = arena_alloc(parser_arena, sizeof(TORAParserExpressionList) + (num_temporaries + 1) * sizeof(void *));
+    TORAParserExpressionList *replacements = arena_alloc(parser_arena, sizeof(TORAParserExpressionList) + arguments->length * sizeof(void *));
+    statements->length = 0;
+    replacements->length = arguments->length;
+    for(uint32_t i = 0; i < arguments->length; i++)
+    {
+        TORAParserUnknownExpression *argument = arguments->items[i];
+        replacements->items[i] = argument;
+        if(argument->type != TORAExpressionTypeVariable && !optimiser_is_literal(argument) &&
+           (indexed[i] || uses[i] != 1 || early_return))
+        {
+            char name[16];
+            snprintf(name, sizeof(name), "#%u", ++optimiser->num_temporaries);
+            replacements->items[i] = new_variable_expression(name);
+            statements->items[statements->length++] = new_assign_expression("=", replacements->items[i], argument);
+        }
+    }
+    
+    void *inlined = optimiser_inline_copy(symbol->inline_body, parameters, replacements);
+    if(statements->length > 0)
+    {
+        // A prog already evaluates to false in place of nothing
+        if(((TORAParserUnknownExpression *)inlined)->type == TORAExpressionTypeProg)
+        {
+            inlined = ((TORAParserProgExpression *)inlined)->val->items[0];
+        }
+        statements->items[statements->length++] = inlined;
+        return optimiser_fold(optimiser, new_prog_expression(statements));
+    }
+    
+    // The arguments may have left a result that could have been nothing certain to be something
+    inlined = optimiser_fold(optimiser, inlined);
+    if(((TORAParserUnknownExpression *)inlined)->type == TORAExpressionTypeProg &&
+       optimiser_has_value(((TORAParserProgExpression *)inlined)->val->items[0]))
+    {
+        return ((TORAParserProgExpression *)inlined)->val->items[0];
+    }
+    return inlined;
+}
+// Copies an inlined function's result, replacing each of its parameters with the matching argument
+void *optimiser_inline_copy(void *expression, TORAParserExpressionList *parameters, TORAParserExpressionList *arguments)
+{
+    if(!expression) return NULL;
+    
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeVariable:
+        {
+            int32_t parameter = optimiser_parameter(parameters, ((TORAParserVariableExpression *)expression)->val);
+            return parameter >= 0 ? arguments->items[parameter] : expression;
+        }
+            break;
+        case TORAExpressionTypeBinary:
+        {
+            TORAParserAssignOrBinaryExpression *binary_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            return new_binary_expression(binary_expression->op,
+                                         optimiser_inline_copy(binary_expression->left, parameters, arguments),
+                                         optimiser_inline_copy(binary_expression->right, parameters, arguments));
+        }
+            break;
+        case TORAExpressionTypeNegativeUnary:
+        {
+            TORAParserNegativeUnaryExpression *negative_expression = (TORAParserNegativeUnaryExpression *)expression;
+            return new_negative_unary_expression(optimiser_inline_copy(negative_expression->expression, parameters, arguments));
+        }
+            break;
+        case TORAExpressionTypeArrayIndex:
+        {
+            TORAParserArrayIndexExpression *index_expression = (TORAParserArrayIndexExpression *)expression;
+            return new_array_index_expression(optimiser_inline_copy(index_expression->index, parameters, arguments),
+                                              optimiser_inline_copy(index_expression->array, parameters, arguments));
+        }
+            break;
+        case TORAExpressionTypeBuiltinCall:
+        {
+            TORAParserBuiltinCallExpression *call_expression = (TORAParserBuiltinCallExpression *)expression;
+            return new_builtin_call_expression(call_expression->builtin, optimiser_inline_copy_list(call_expression->arguments, parameters, arguments));
+        }
+            break;
+        case TORAExpressionTypeConcat:
+            return new_concat_expression(optimiser_inline_copy_list(((TORAParserConcatExpression *)expression)->pieces, parameters, arguments));
+            break;
+        case TORAExpressionTypeIfThenElse:
+        {
+            TORAParserIfThenElseExpression *if_expression = (TORAParserIfThenElseExpression *)expression;
+            return new_if_expression(optimiser_inline_copy(if_expression->condition, parameters, arguments),
+                                     optimiser_inline_copy(if_expression->then, parameters, arguments),
+                                     optimiser_inline_copy(if_expression->el, parameters, arguments));
+        }
+            break;
+        case TORAExpressionTypeProg:
+            return new_prog_expression(optimiser_inline_copy_list(((TORAParserProgExpression *)expression)->val, parameters, arguments));
+            break;
+        default:
+            break;
+    }
+    
+    return expression;
+}
+TORAParserExpressionList *optimiser_inline_copy_list(TORAParserExpressionList *list, TORAParserExpressionList *parameters, TORAParserExpressionList *arguments)
+{
+    TORAParserExpressionList *copy = arena_alloc(parser_arena, sizeof(TORAParserExpressionList) + list->length * sizeof(void *));
+    copy->length = list->length;
+    for(uint32_t i = 0; i < list->length; i++)
+    {
+        copy->items[i] = optimiser_inline_copy(list->items[i], parameters, arguments);
+    }
+    return copy;
+}
+// Counts how many times each parameter's used, and notes those which are indexed
+void optimiser_inline_uses(void *expression, TORAParserExpressionList *parameters, uint32_t *uses, bool *indexed)
+{
+    if(!expression) return;
+    
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeVariable:
+        {
+            int32_t parameter = optimiser_parameter(parameters, ((TORAParserVariableExpression *)expression)->val);
+            if(parameter >= 0)
+            {
+                uses[parameter]++;
+            }
+        }
+            break;
+        case TORAExpressionTypeBinary:
+        {
+            TORAParserAssignOrBinaryExpression *binary_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            optimiser_inline_uses(binary_expression->left, parameters, uses, indexed);
+            optimiser_inline_uses(binary_expression->right, parameters, uses, indexed);
+        }
+            break;
+        case TORAExpressionTypeNegativeUnary:
+            optimiser_inline_uses(((TORAParserNegativeUnaryExpression *)expression)->expression, parameters, uses, indexed);
+            break;
+        case TORAExpressionTypeArrayIndex:
+        {
+            TORAParserArrayIndexExpression *index_expression = (TORAParserArrayIndexExpression *)expression;
+            TORAParserVariableExpression *array = index_expression->array;
+            if(array->type == TORAExpressionTypeVariable && optimiser_parameter(parameters, array->val) >= 0)
+            {
+                indexed[optimiser_parameter(parameters, array->val)] = true;
+            }
+            optimiser_inline_uses(index_expression->array, parameters, uses, indexed);
+            optimiser_inline_uses(index_expression->index, parameters, uses, indexed);
+        }
+            break;
+        case TORAExpressionTypeBuiltinCall:
+        case TORAExpressionTypeConcat:
+        case TORAExpressionTypeProg:
+        {
+            TORAParserExpressionList *list = ((TORAParserBuiltinCallExpression *)expression)->arguments;
+            if(unknown_expression->type == TORAExpressionTypeConcat)
+            {
+                list = ((TORAParserConcatExpression *)expression)->pieces;
+            }
+            else if(unknown_expression->type == TORAExpressionTypeProg)
+            {
+                list = ((TORAParserProgExpression *)expression)->val;
+            }
+            
+            for(uint32_t i = 0; i < list->length; i++)
+            {
+                optimiser_inline_uses(list->items[i], parameters, uses, indexed);
+            }
+        }
+            break;
+        case TORAExpressionTypeIfThenElse:
+        {
+            TORAParserIfThenElseExpression *if_expression = (TORAParserIfThenElseExpression *)expression;
+            optimiser_inline_uses(if_expression->condition, parameters, uses, indexed);
+            optimiser_inline_uses(if_expression->then, parameters, uses, indexed);
+            optimiser_inline_uses(if_expression->el, parameters, uses, indexed);
+        }
+            break;
+        default:
+            break;
+    }
+}
+int32_t optimiser_parameter(TORAParserExpressionList *parameters, const char *name)
+{
+    for(uint32_t i = 0; i < parameters->length; i++)
+    {
+        if(strcmp(((TORAParserVariableExpression *)parameters->items[i])->val, name) == 0)
+        {
+            return (int32_t)i;
+        }
+    }
+    return -1;
+}
+// The number of nodes in an expression made up of the kinds an inlined function's result can hold
+uint32_t optimiser_size(void *expression)
+{
+    if(!expression) return 0;
+    
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeBinary:
+        {
+            TORAParserAssignOrBinaryExpression *binary_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            return 1 + optimiser_size(binary_expression->left) + optimiser_size(binary_expression->right);
+        }
+            break;
+        case TORAExpressionTypeNegativeUnary:
+            return 1 + optimiser_size(((TORAParserNegativeUnaryExpression *)expression)->expression);
+            break;
+        case TORAExpressionTypeArrayIndex:
+        {
+            TORAParserArrayIndexExpression *index_expression = (TORAParserArrayIndexExpression *)expression;
+            return 1 + optimiser_size(index_expression->array) + optimiser_size(index_expression->index);
+        }
+            break;
+        case TORAExpressionTypeBuiltinCall:
+        case TORAExpressionTypeConcat:
+        case TORAExpressionTypeProg:
+        {
+            TORAParserExpressionList *list = ((TORAParserBuiltinCallExpression *)expression)->arguments;
+            if(unknown_expression->type == TORAExpressionTypeConcat)
+            {
+                list = ((TORAParserConcatExpression *)expression)->pieces;
+            }
+            else if(unknown_expression->type == TORAExpressionTypeProg)
+            {
+                list = ((TORAParserProgExpression *)expression)->val;
+            }
+            
+            uint32_t size = 1;
+            for(uint32_t i = 0; i < list->length; i++)
+            {
+                size += optimiser_size(list->items[i]);
+            }
+            return size;
+        }
+            break;
+        case TORAExpressionTypeIfThenElse:
+        {
+            TORAParserIfThenElseExpression *if_expression = (TORAParserIfThenElseExpression *)expression;
+            return 1 + optimiser_size(if_expression->condition) + optimiser_size(if_expression->then) + optimiser_size(if_expression->el);
+        }
+            break;
+        default:
+            break;
+    }
+    
+    return 1;
+}
+
+// Elimination
+// Removes whatever can't affect the program from an expression that's been folded.
+// statement says whether it's evaluated as a statement (or as the body of a function,
+// loop or if), which is the only place a return can end the prog it's in
+void *optimiser_eliminate(TORAOptimiser *optimiser, void *expression, bool statement)
+{
+    if(!expression) return NULL;
+    
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeAssign:
+        case TORAExpressionTypeBinary:
+        {
+            TORAParserAssignOrBinaryExpression *binary_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            if(unknown_expression->type == TORAExpressionTypeBinary ||
+               ((TORAParserUnknownExpression *)binary_expression->left)->type == TORAExpressionTypeArrayIndex)
+            {
+                binary_expression->left = optimiser_eliminate(optimiser, binary_expression->left, false);
+            }
+            binary_expression->right = optimiser_eliminate(optimiser, binary_expression->right, false);
+        }
+            break;
+        case TORAExpressionTypeNegativeUnary:
+        case TORAExpressionTypeReturn:
+        {
+            TORAParserReturnExpression *return_expression = (TORAParserReturnExpression *)expression;
+            return_expression->expression = optimiser_eliminate(optimiser, return_expression->expression, false);
+        }
+            break;
+        case TORAExpressionTypeArrayIndex:
+        {
+            TORAParserArrayIndexExpression *index_expression = (TORAParserArrayIndexExpression *)expression;
+            index_expression->array = optimiser_eliminate(optimiser, index_expression->array, false);
+            index_expression->index = optimiser_eliminate(optimiser, index_expression->index, false);
+        }
+            break;
+        case TORAExpressionTypeCall:
+        {
+            TORAParserCallExpression *call_expression = (TORAParserCallExpression *)expression;
+            call_expression->func = optimiser_eliminate(optimiser, call_expression->func, false);
+            optimiser_eliminate_list(optimiser, call_expression->arguments);
+        }
+            break;
+        case TORAExpressionTypeBuiltinCall:
+            optimiser_eliminate_list(optimiser, ((TORAParserBuiltinCallExpression *)expression)->arguments);
+            break;
+        case TORAExpressionTypeConcat:
+            optimiser_eliminate_list(optimiser, ((TORAParserConcatExpression *)expression)->pieces);
+            break;
+        case TORAExpressionTypeArray:
+        {
+            TORAParserArrayExpression *array_expression = (TORAParserArrayExpression *)expression;
+            if(array_expression->items)
+            {
+                optimiser_eliminate_list(optimiser, array_expression->items);
+            }
+        }
+            break;
+        case TORAExpressionTypeLambda:
+        {
+            TORAParserLambdaExpression *function_expression = (TORAParserLambdaExpression *)expression;
+            TORAParserLambdaExpression *function = optimiser->function;
+            optimiser->function = function_expression;
+            function_expression->body = optimiser_eliminate(optimiser, function_expression->body, true);
+            optimiser->function = function;
+        }
+            break;
+        case TORAExpressionTypeWhile:
+        {
+            // A loop that never runs evaluates to false, just as its condition does
+            TORAParserWhileExpression *while_expression = (TORAParserWhileExpression *)expression;
+            while_expression->condition = optimiser_eliminate(optimiser, while_expression->condition, false);
+            TORAParserBoolExpression *condition = while_expression->condition;
+            if(condition->type == TORAExpressionTypeBoolean && !condition->val)
+            {
+                return condition;
+            }
+            while_expression->body = optimiser_eliminate(optimiser, while_expression->body, true);
+        }
+            break;
+        case TORAExpressionTypeIfThenElse:
+        {
+            TORAParserIfThenElseExpression *if_expression = (TORAParserIfThenElseExpression *)expression;
+            if_expression->condition = optimiser_eliminate(optimiser, if_expression->condition, false);
+            if_expression->then = optimiser_eliminate(optimiser, if_expression->then, true);
+            if_expression->el = optimiser_eliminate(optimiser, if_expression->el, true);
+            
+            // An if always evaluates its branches as statements, so one that's certain to be
+            // taken can only replace it where it's a statement too, unless it can't return.
+            // An if without an else whose condition is false evaluates to false, like the condition
+            TORAParserBoolExpression *condition = if_expression->condition;
+            if(condition->type == TORAExpressionTypeBoolean)
+            {
+                void *branch = condition->val ? if_expression->then : if_expression->el;
+                if(!branch)
+                {
+                    return condition;
+                }
+                if(statement || !optimiser_can_return(branch))
+                {
+                    return branch;
+                }
+            }
+        }
+            break;
+        case TORAExpressionTypeProg:
+            optimiser_eliminate_statements(optimiser, expression, statement);
+            break;
+        default:
+            break;
+    }
+    
+    return expression;
+}
+void optimiser_eliminate_list(TORAOptimiser *optimiser, TORAParserExpressionList *list)
+{
+    for(uint32_t i = 0; i < list->length; i++)
+    {
+        list->items[i] = optimiser_eliminate(optimiser, list->items[i], false);
+    }
+}
+// A prog evaluates to whatever its last statement does, so that's always kept. Any
+// other statement that can't fail or do anything is removed, so long as nothing before
+// it could have returned: a prog that's returned something carries on until it reaches
+// a statement that evaluates to something, and returns that. Anything after a statement
+// certain to return something is never reached
+void optimiser_eliminate_statements(TORAOptimiser *optimiser, TORAParserProgExpression *prog, bool statement)
+{
+    TORAParserExpressionList *statements = prog->val;
+    for(uint32_t i = 0; i < statements->length; i++)
+    {
+        statements->items[i] = optimiser_eliminate(optimiser, statements->items[i], true);
+    }
+    
+    uint32_t length = 0;
+    bool returned = false;
+    for(uint32_t i = 0; i < statements->length; i++)
+    {
+        void *item = statements->items[i];
+        if(optimiser_is_dead_store(optimiser, prog, i))
+        {
+            item = ((TORAParserAssignOrBinaryExpression *)item)->right;
+        }
+        
+        bool last = i == statements->length - 1;
+        if(!last && (!statement || !returned) && optimiser_is_unused(optimiser, item, statements, length))
+        {
+            continue;
+        }
+        
+        statements->items[length++] = item;
+        returned = returned || optimiser_can_return(item);
+        if(statement && optimiser_always_returns(optimiser, item, statements, length - 1))
+        {
+            break;
+        }
+    }
+    statements->length = length;
+}
+// A store to one of a function's own variables is dead when nothing reads it before it's
+// next stored to, or before the function ends. Functions defined within the function
+// could read its variables whenever they're called, so one they use is never dead. The
+// value stored is still evaluated, and has to be something, as storing nothing would fail
+bool optimiser_is_dead_store(TORAOptimiser *optimiser, TORAParserProgExpression *prog, uint32_t i)
+{
+    TORAParserAssignOrBinaryExpression *assign_expression = prog->val->items[i];
+    if(!optimiser->function ||
+       assign_expression->type != TORAExpressionTypeAssign ||
+       ((TORAParserUnknownExpression *)assign_expression->left)->type != TORAExpressionTypeVariable ||
+       !optimiser_has_value(assign_expression->right))
+    {
+        return false;
+    }
+    
+    const char *name = ((TORAParserVariableExpression *)assign_expression->left)->val;
+    for(uint32_t j = i + 1; j < prog->val->length; j++)
+    {
+        TORAParserAssignOrBinaryExpression *statement = prog->val->items[j];
+        if(statement->type == TORAExpressionTypeAssign &&
+           ((TORAParserUnknownExpression *)statement->left)->type == TORAExpressionTypeVariable &&
+           strcmp(((TORAParserVariableExpression *)statement->left)->val, name) == 0 &&
+           !optimiser_uses_name(statement->right, name))
+        {
+            return !optimiser_is_captured(optimiser->function->body, name);
+        }
+        if(optimiser_uses_name(statement, name))
+        {
+            return false;
+        }
+    }
+    
+    return prog == optimiser->function->body && i < prog->val->length - 1 && !optimiser_is_captured(optimiser->function->body, name);
+}
+// Whether a statement can be removed without changing anything, given the statements kept before it
+bool optimiser_is_unused(TORAOptimiser *optimiser, void *expression, TORAParserExpressionList *statements, uint32_t num_statements)
+{
+    // Looking a variable up never fails, even when it's yet to be assigned
+    return ((TORAParserUnknownExpression *)expression)->type == TORAExpressionTypeVariable ||
+           optimiser_is_safe(optimiser, expression, statements, num_statements);
+}
+// Whether an expression is certain to evaluate to something without failing. Operators
+// other than + never fail on anything, and variables are known to hold something once
+// they've been assigned to (see optimiser_is_assigned)
+bool optimiser_is_safe(TORAOptimiser *optimiser, void *expression, TORAParserExpressionList *statements, uint32_t num_statements)
+{
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeNumeric:
+        case TORAExpressionTypeString:
+        case TORAExpressionTypeBoolean:
+            return true;
+            break;
+        case TORAExpressionTypeVariable:
+            return optimiser_is_assigned(optimiser, ((TORAParserVariableExpression *)expression)->val, statements, num_statements);
+            break;
+        case TORAExpressionTypeBinary:
+        {
+            TORAParserAssignOrBinaryExpression *binary_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            return operator_kind(binary_expression->op, strlen(binary_expression->op)) != TORATokenKindAdd &&
+                   optimiser_is_safe(optimiser, binary_expression->left, statements, num_statements) &&
+                   optimiser_is_safe(optimiser, binary_expression->right, statements, num_statements);
+        }
+            break;
+        default:
+            break;
+    }
+    
+    return false;
+}
+// A variable's known to hold something if it's one of the function's parameters, as
+// binding a parameter to nothing fails, or was assigned by an earlier statement of the
+// same prog, as nothing can unbind it or assign it nothing afterwards
+bool optimiser_is_assigned(TORAOptimiser *optimiser, const char *name, TORAParserExpressionList *statements, uint32_t num_statements)
+{
+    if(optimiser->function && optimiser_parameter(optimiser->function->arguments, name) >= 0)
+    {
+        return true;
+    }
+    
+    for(uint32_t i = 0; i < num_statements; i++)
+    {
+        TORAParserAssignOrBinaryExpression *statement = statements->items[i];
+        if(statement->type == TORAExpressionTypeAssign &&
+           ((TORAParserUnknownExpression *)statement->left)->type == TORAExpressionTypeVariable &&
+           strcmp(((TORAParserVariableExpression *)statement->left)->val, name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+// Whether evaluating a statement could end the prog it's in. Calls can too, as a function
+// returning from a call made as a statement returns from its caller as well. Only the
+// statements of progs and the bodies of loops and ifs are evaluated as statements in turn
+bool optimiser_can_return(void *expression)
+{
+    if(!expression) return false;
+    
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeReturn:
+        case TORAExpressionTypeCall:
+            return true;
+            break;
+        case TORAExpressionTypeWhile:
+            return optimiser_can_return(((TORAParserWhileExpression *)expression)->body);
+            break;
+        case TORAExpressionTypeIfThenElse:
+        {
+            TORAParserIfThenElseExpression *if_expression = (TORAParserIfThenElseExpression *)expression;
+            return optimiser_can_return(if_expression->then) || optimiser_can_return(if_expression->el);
+        }
+            break;
+        case TORAExpressionTypeProg:
+        {
+            TORAParserExpressionList *statements = ((TORAParserProgExpression *)expression)->val;
+            for(uint32_t i = 0; i < statements->length; i++)
+            {
+                if(optimiser_can_return(statements->items[i]))
+                {
+                    return true;
+                }
+            }
+        }
+            break;
+        default:
+            break;
+    }
+    
+    return false;
+}
+// Whether a statement is certain to end the prog it's in, by returning something
+bool optimiser_always_returns(TORAOptimiser *optimiser, void *expression, TORAParserExpressionList *statements, uint32_t num_statements)
+{
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeReturn:
+        {
+            void *result = ((TORAParserReturnExpression *)expression)->expression;
+            return result && (optimiser_has_value(result) || optimiser_is_safe(optimiser, result, statements, num_statements));
+        }
+            break;
+        case TORAExpressionTypeIfThenElse:
+        {
+            TORAParserIfThenElseExpression *if_expression = (TORAParserIfThenElseExpression *)expression;
+            return if_expression->el &&
+                   optimiser_always_returns(optimiser, if_expression->then, statements, num_statements) &&
+                   optimiser_always_returns(optimiser, if_expression->el, statements, num_statements);
+        }
+            break;
+        case TORAExpressionTypeProg:
+        {
+            TORAParserExpressionList *prog_statements = ((TORAParserProgExpression *)expression)->val;
+            for(uint32_t i = 0; i < prog_statements->length; i++)
+            {
+                if(optimiser_always_returns(optimiser, prog_statements->items[i], prog_statements, i))
+                {
+                    return true;
+                }
+            }
+        }
+            break;
+        default:
+            break;
+    }
+    
+    return false;
+}
+// Whether a name's used anywhere in an expression, including within any functions it defines
+bool optimiser_uses_name(void *expression, const char *name)
+{
+    if(!expression) return false;
+    
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    if(unknown_expression->type == TORAExpressionTypeVariable)
+    {
+        return strcmp(((TORAParserVariableExpression *)expression)->val, name) == 0;
+    }
+    if(unknown_expression->type == TORAExpressionTypeLambda)
+    {
+        TORAParserLambdaExpression *function_expression = (TORAParserLambdaExpression *)expression;
+        if(function_expression->name && strcmp(function_expression->name, name) == 0)
+        {
+            return true;
+        }
+        for(uint32_t i = 0; i < function_expression->arguments->length; i++)
+        {
+            if(optimiser_uses_name(function_expression->arguments->items[i], name))
+            {
+                return true;
+            }
+        }
+        
+        // A function whose body's still to be parsed could use anything
+        return !function_expression->body || optimiser_uses_name(function_expression->body, name);
+    }
+    
+    for(uint32_t i = 0; i < optimiser_num_children(expression); i++)
+    {
+        if(optimiser_uses_name(optimiser_child(expression, i), name))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+// Whether a name's used by any function defined within an expression
+bool optimiser_is_captured(void *expression, const char *name)
+{
+    if(!expression) return false;
+    
+    if(((TORAParserUnknownExpression *)expression)->type == TORAExpressionTypeLambda)
+    {
+        return optimiser_uses_name(expression, name);
+    }
+    
+    for(uint32_t i = 0; i < optimiser_num_children(expression); i++)
+    {
+        if(optimiser_is_captured(optimiser_child(expression, i), name))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+// Counts each use of a name in an expression, adding delta to its uses. A variable being
+// assigned to isn't a use of it, and neither is the name of a function being defined.
+// Notes whether any function's body is still to be parsed, as its uses are unknown
+void optimiser_count_uses(TORAOptimiser *optimiser, void *expression, int32_t delta)
+{
+    if(!expression) return;
+    
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeVariable:
+            optimiser_symbol(optimiser, ((TORAParserVariableExpression *)expression)->val)->uses += delta;
+            break;
+        case TORAExpressionTypeAssign:
+        {
+            TORAParserAssignOrBinaryExpression *assign_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            if(((TORAParserUnknownExpression *)assign_expression->left)->type != TORAExpressionTypeVariable)
+            {
+                optimiser_count_uses(optimiser, assign_expression->left, delta);
+            }
+            optimiser_count_uses(optimiser, assign_expression->right, delta);
+        }
+            break;
+        case TORAExpressionTypeLambda:
+        {
+            TORAParserLambdaExpression *function_expression = (TORAParserLambdaExpression *)expression;
+            if(!function_expression->body)
+            {
+                optimiser->lazy = true;
+            }
+            optimiser_count_uses(optimiser, function_expression->body, delta);
+        }
+            break;
+        default:
+        {
+            for(uint32_t i = 0; i < optimiser_num_children(expression); i++)
+            {
+                optimiser_count_uses(optimiser, optimiser_child(expression, i), delta);
+            }
+        }
+            break;
+    }
+}
+// Removes the functions defined at the top level that nothing uses, other than themselves.
+// Removing one may leave others it used unused in turn. Like any other statement, a
+// definition's only removed if nothing before it could have returned (see
+// optimiser_eliminate_statements)
+void optimiser_remove_unused_functions(TORAOptimiser *optimiser, TORAParserProgExpression *prog)
+{
+    TORAParserExpressionList *statements = prog->val;
+    bool removed = true;
+    while(removed)
+    {
+        removed = false;
+        
+        uint32_t length = 0;
+        bool returned = false;
+        for(uint32_t i = 0; i < statements->length; i++)
+        {
+            TORAParserLambdaExpression *function_expression = statements->items[i];
+            returned = returned || optimiser_can_return(function_expression);
+            if(!returned && function_expression->type == TORAExpressionTypeLambda && function_expression->name)
+            {
+                TORAOptimiserSymbol *symbol = optimiser_symbol(optimiser, function_expression->name);
+                if(symbol->bindings == 1 && (int32_t)symbol->uses == optimiser_count_name(function_expression->body, function_expression->name))
+                {
+                    optimiser_count_uses(optimiser, function_expression->body, -1);
+                    removed = true;
+                    continue;
+                }
+            }
+            statements->items[length++] = function_expression;
+        }
+        statements->length = length;
+    }
+}
+int32_t optimiser_count_name(void *expression, const char *name)
+{
+    if(!expression) return 0;
+    
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    if(unknown_expression->type == TORAExpressionTypeVariable)
+    {
+        return strcmp(((TORAParserVariableExpression *)expression)->val, name) == 0 ? 1 : 0;
+    }
+    
+    TORAParserAssignOrBinaryExpression *assign_expression = (TORAParserAssignOrBinaryExpression *)expression;
+    if(unknown_expression->type == TORAExpressionTypeAssign &&
+       ((TORAParserUnknownExpression *)assign_expression->left)->type == TORAExpressionTypeVariable)
+    {
+        return optimiser_count_name(assign_expression->right, name);
+    }
+    
+    int32_t count = 0;
+    for(uint32_t i = 0; i < optimiser_num_children(expression); i++)
+    {
+        count += optimiser_count_name(optimiser_child(expression, i), name);
+    }
+    if(unknown_expression->type == TORAExpressionTypeLambda)
+    {
+        count += optimiser_count_name(((TORAParserLambdaExpression *)expression)->body, name);
+    }
+    return count;
+}
+
+// Sharing
+// Within a run of statements that flow straight from one to the next, a pure expression
+// that's worked out more than once with nothing it reads changing in between is only
+// worked out the first time. Its value's kept in the variable it's assigned to, if it's
+// the whole of an assignment, or otherwise in a temporary assigned to where it was
+void optimiser_share(TORAOptimiser *optimiser, void *expression)
+{
+    if(!expression) return;
+    
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    if(unknown_expression->type == TORAExpressionTypeProg)
+    {
+        optimiser_share_statements(optimiser, ((TORAParserProgExpression *)expression)->val);
+    }
+    else if(unknown_expression->type == TORAExpressionTypeLambda)
+    {
+        optimiser_share(optimiser, ((TORAParserLambdaExpression *)expression)->body);
+        return;
+    }
+    
+    for(uint32_t i = 0; i < optimiser_num_children(expression); i++)
+    {
+        optimiser_share(optimiser, optimiser_child(expression, i));
+    }
+}
+// Splits a prog's statements into runs at anything that could call a function or
+// branch, and shares what's worked out more than once within each run
+void optimiser_share_statements(TORAOptimiser *optimiser, TORAParserExpressionList *statements)
+{
+    uint32_t first = 0;
+    for(uint32_t i = 0; i <= statements->length; i++)
+    {
+        if(i < statements->length && optimiser_is_straight(statements->items[i]) && i - first < TORA_OPTIMISER_SHARE_STATEMENTS)
+        {
+            continue;
+        }
+        
+        if(i > first)
+        {
+            while(optimiser_share_run(optimiser, statements, first, i));
+        }
+        first = i < statements->length && optimiser_is_straight(statements->items[i]) ? i : i + 1;
+    }
+}
+// Shares the largest expression that's worked out more than once in the statements
+// from first up to last, returning whether there was one
+bool optimiser_share_run(TORAOptimiser *optimiser, TORAParserExpressionList *statements, uint32_t first, uint32_t last)
+{
+    optimiser->num_occurrences = 0;
+    for(uint32_t i = first; i < last; i++)
+    {
+        optimiser_gather(optimiser, &statements->items[i], NULL);
+    }
+    
+    TORAOptimiserOccurrence *occurrences = optimiser->occurrences;
+    uint32_t best = 0;
+    uint32_t best_match = 0;
+    uint32_t best_size = 0;
+    for(uint32_t i = 0; i < optimiser->num_occurrences; i++)
+    {
+        if(occurrences[i].store)
+        {
+            continue;
+        }
+        
+        void *expression = *occurrences[i].slot;
+        uint32_t size = optimiser_size(expression);
+        if(size <= best_size || !optimiser_can_hold(&occurrences[i]))
+        {
+            continue;
+        }
+        
+        for(uint32_t j = i + 1; j < optimiser->num_occurrences; j++)
+        {
+            if(occurrences[j].store)
+            {
+                if(optimiser_is_killed(&occurrences[j], expression))
+                {
+                    break;
+                }
+            }
+            else if(optimiser_equal(expression, *occurrences[j].slot))
+            {
+                best = i;
+                best_match = j;
+                best_size = size;
+                break;
+            }
+        }
+    }
+    if(best_size == 0)
+    {
+        return false;
+    }
+    
+    // A value that's the whole of an assignment to a variable is already held by it,
+    // until the variable's next assigned to. The value of that assignment is evaluated
+    // before it's made, so can still use it
+    TORAOptimiserOccurrence *occurrence = &occurrences[best];
+    void *expression = *occurrence->slot;
+    TORAParserAssignOrBinaryExpression *parent = occurrence->parent;
+    bool reuse = parent && parent->type == TORAExpressionTypeAssign && occurrence->slot == &parent->right &&
+                 ((TORAParserUnknownExpression *)parent->left)->type == TORAExpressionTypeVariable;
+    uint32_t holder_last = optimiser->num_occurrences;
+    if(reuse)
+    {
+        for(uint32_t i = best + 1; i < optimiser->num_occurrences; i++)
+        {
+            if(occurrences[i].store && *occurrences[i].slot != parent && optimiser_is_killed(&occurrences[i], parent->left))
+            {
+                holder_last = i;
+                break;
+            }
+        }
+        reuse = best_match < holder_last;
+    }
+    
+    char temporary[16];
+    char *name = temporary;
+    if(reuse)
+    {
+        name = ((TORAParserVariableExpression *)parent->left)->val;
+    }
+    else
+    {
+        snprintf(temporary, sizeof(temporary), "#%u", ++optimiser->num_temporaries);
+        *occurrence->slot = new_assign_expression("=", new_variable_expression(name), expression);
+        holder_last = optimiser->num_occurrences;
+    }
+    
+    for(uint32_t j = best + 1; j < holder_last; j++)
+    {
+        if(occurrences[j].store)
+        {
+            if(optimiser_is_killed(&occurrences[j], expression))
+            {
+                break;
+            }
+        }
+        else if(optimiser_equal(expression, *occurrences[j].slot))
+        {
+            *occurrences[j].slot = new_variable_expression(name);
+        }
+    }
+    return true;
+}
+// Notes each expression within a statement that could be shared, and each assignment
+// made, in the order they're evaluated in, along with the slot holding it and the
+// expression that slot's in. An assignment's made once its value and index have been
+// evaluated, wherever it appears
+void optimiser_gather(TORAOptimiser *optimiser, void **slot, void *parent)
+{
+    void *expression = *slot;
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeAssign:
+        {
+            TORAParserAssignOrBinaryExpression *assign_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            optimiser_gather(optimiser, &assign_expression->right, expression);
+            if(((TORAParserUnknownExpression *)assign_expression->left)->type == TORAExpressionTypeArrayIndex)
+            {
+                TORAParserArrayIndexExpression *index_expression = assign_expression->left;
+                optimiser_gather(optimiser, &index_expression->index, index_expression);
+            }
+            optimiser_add_occurrence(optimiser, slot, parent, true);
+            return;
+        }
+            break;
+        case TORAExpressionTypeArrayIndex:
+        {
+            TORAParserArrayIndexExpression *index_expression = (TORAParserArrayIndexExpression *)expression;
+            if(((TORAParserUnknownExpression *)index_expression->array)->type == TORAExpressionTypeVariable &&
+               optimiser_is_pure(optimiser, expression, NULL))
+            {
+                optimiser_add_occurrence(optimiser, slot, parent, false);
+            }
+        }
+            break;
+        case TORAExpressionTypeBinary:
+        case TORAExpressionTypeNegativeUnary:
+        case TORAExpressionTypeBuiltinCall:
+        case TORAExpressionTypeConcat:
+            if(optimiser_is_pure(optimiser, expression, NULL))
+            {
+                optimiser_add_occurrence(optimiser, slot, parent, false);
+            }
+            break;
+        default:
+            break;
+    }
+    
+    // Binary operators evaluate their left operand first, and lists are evaluated in order
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeBinary:
+        {
+            TORAParserAssignOrBinaryExpression *binary_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            optimiser_gather(optimiser, &binary_expression->left, expression);
+            optimiser_gather(optimiser, &binary_expression->right, expression);
+        }
+            break;
+        case TORAExpressionTypeArrayIndex:
+        {
+            TORAParserArrayIndexExpression *index_expression = (TORAParserArrayIndexExpression *)expression;
+            optimiser_gather(optimiser, &index_expression->array, expression);
+            optimiser_gather(optimiser, &index_expression->index, expression);
+        }
+            break;
+        case TORAExpressionTypeNegativeUnary:
+        case TORAExpressionTypeReturn:
+            optimiser_gather(optimiser, &((TORAParserReturnExpression *)expression)->expression, expression);
+            break;
+        case TORAExpressionTypeBuiltinCall:
+        case TORAExpressionTypeConcat:
+        case TORAExpressionTypeArray:
+        {
+            TORAParserExpressionList *list = ((TORAParserBuiltinCallExpression *)expression)->arguments;
+            if(unknown_expression->type == TORAExpressionTypeConcat)
+            {
+                list = ((TORAParserConcatExpression *)expression)->pieces;
+            }
+            else if(unknown_expression->type == TORAExpressionTypeArray)
+            {
+                list = ((TORAParserArrayExpression *)expression)->items;
+            }
+            
+            for(uint32_t i = 0; list && i < list->length; i++)
+            {
+                optimiser_gather(optimiser, &list->items[i], expression);
+            }
+        }
+            break;
+        default:
+            break;
+    }
+}
+// Once a run's full nothing more is noted, so no expression's shared past an
+// assignment that wasn't
+void optimiser_add_occurrence(TORAOptimiser *optimiser, void **slot, void *parent, bool store)
+{
+    if(optimiser->num_occurrences == TORA_OPTIMISER_SHARE_OCCURRENCES)
+    {
+        return;
+    }
+    
+    if(optimiser->num_occurrences == optimiser->occurrences_capacity)
+    {
+        uint32_t capacity = optimiser->occurrences_capacity ? optimiser->occurrences_capacity * 2 : 32;
+        TORAOptimiserOccurrence *occurrences = optimiser->occurrences ? realloc(optimiser->occurrences, capacity * sizeof(TORAOptimiserOccurrence)) : tora_malloc(capacity * sizeof(TORAOptimiserOccurrence));
+        if(!occurrences)
+        {
+            TORA_RUNTIME_EXCEPTION("Failed to malloc space for optimiser occurrences");
+        }
+        optimiser->occurrences = occurrences;
+        optimiser->occurrences_capacity = capacity;
+    }
+    
+    TORAOptimiserOccurrence *occurrence = &optimiser->occurrences[optimiser->num_occurrences++];
+    occurrence->slot = slot;
+    occurrence->parent = parent;
+    occurrence->store = store;
+}
+// Whether a statement's evaluated without calling any function of the program's own or
+// branching, so every expression within it is evaluated exactly once, in order
+bool optimiser_is_straight(void *expression)
+{
+    if(!expression) return true;
+    
+    switch(((TORAParserUnknownExpression *)expression)->type)
+    {
+        case TORAExpressionTypeCall:
+        case TORAExpressionTypeIfThenElse:
+        case TORAExpressionTypeWhile:
+        case TORAExpressionTypeLambda:
+        case TORAExpressionTypeProg:
+            return false;
+            break;
+        default:
+            break;
+    }
+    
+    for(uint32_t i = 0; i < optimiser_num_children(expression); i++)
+    {
+        if(!optimiser_is_straight(optimiser_child(expression, i)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+// Assigning an expression's value to a temporary fails if it evaluates to nothing, so it
+// has to be certain to be something, or be used by something that would fail anyway
+bool optimiser_can_hold(TORAOptimiserOccurrence *occurrence)
+{
+    TORAParserUnknownExpression *expression = *occurrence->slot;
+    TORAParserAssignOrBinaryExpression *parent = occurrence->parent;
+    return optimiser_has_value(expression) ||
+           expression->type == TORAExpressionTypeBuiltinCall ||
+           (parent && (parent->type == TORAExpressionTypeBinary || parent->type == TORAExpressionTypeNegativeUnary)) ||
+           (parent && parent->type == TORAExpressionTypeAssign && occurrence->slot == &parent->right);
+}
+// Whether an assignment could change what an expression evaluates to. Storing to any
+// array's elements could change every other array's too, as more than one variable
+// can hold the same array
+bool optimiser_is_killed(TORAOptimiserOccurrence *store, void *expression)
+{
+    TORAParserAssignOrBinaryExpression *assign_expression = *store->slot;
+    TORAParserVariableExpression *variable = assign_expression->left;
+    bool indexed = variable->type == TORAExpressionTypeArrayIndex;
+    if(indexed)
+    {
+        variable = ((TORAParserArrayIndexExpression *)variable)->array;
+    }
+    return optimiser_uses_name(expression, variable->val) || (indexed && optimiser_reads_array(expression));
+}
+bool optimiser_reads_array(void *expression)
+{
+    if(((TORAParserUnknownExpression *)expression)->type == TORAExpressionTypeArrayIndex)
+    {
+        return true;
+    }
+    
+    for(uint32_t i = 0; i < optimiser_num_children(expression); i++)
+    {
+        if(optimiser_reads_array(optimiser_child(expression, i)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+// Whether two pure expressions are certain to evaluate to the same value, given nothing
+// they read has changed
+bool optimiser_equal(void *a, void *b)
+{
+    TORAParserUnknownExpression *unknown_a = (TORAParserUnknownExpression *)a;
+    TORAParserUnknownExpression *unknown_b = (TORAParserUnknownExpression *)b;
+    if(unknown_a->type != unknown_b->type)
+    {
+        return false;
+    }
+    
+    switch(unknown_a->type)
+    {
+        case TORAExpressionTypeNumeric:
+            return optimiser_is_number(b, ((TORAParserNumericExpression *)a)->val);
+            break;
+        case TORAExpressionTypeBoolean:
+            return ((TORAParserBoolExpression *)a)->val == ((TORAParserBoolExpression *)b)->val;
+            break;
+        case TORAExpressionTypeString:
+        case TORAExpressionTypeVariable:
+            return strcmp(((TORAParserStringExpression *)a)->val, ((TORAParserStringExpression *)b)->val) == 0;
+            break;
+        case TORAExpressionTypeBinary:
+            if(strcmp(((TORAParserAssignOrBinaryExpression *)a)->op, ((TORAParserAssignOrBinaryExpression *)b)->op) != 0)
+            {
+                return false;
+            }
+            break;
+        case TORAExpressionTypeBuiltinCall:
+            if(((TORAParserBuiltinCallExpression *)a)->builtin != ((TORAParserBuiltinCallExpression *)b)->builtin)
+            {
+                return false;
+            }
+            break;
+        case TORAExpressionTypeNegativeUnary:
+        case TORAExpressionTypeArrayIndex:
+        case TORAExpressionTypeConcat:
+            break;
+        default:
+            return false;
+            break;
+    }
+    
+    uint32_t num_children = optimiser_num_children(a);
+    if(num_children != optimiser_num_children(b))
+    {
+        return false;
+    }
+    for(uint32_t i = 0; i < num_children; i++)
+    {
+        if(!optimiser_equal(optimiser_child(a, i), optimiser_child(b, i)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Helpers
+// A call by name is certain to reach a builtin when nothing in the program binds that
+// name, as a function (or anything else) of the program's own would be found first
+const TORABuiltin *optimiser_builtin(TORAOptimiser *optimiser, void *func)
+{
+    if(((TORAParserUnknownExpression *)func)->type != TORAExpressionTypeVariable)
+    {
+        return NULL;
+    }
+    
+    const char *name = ((TORAParserVariableExpression *)func)->val;
+    const TORABuiltin *builtin = builtin_lookup(name, strlen(name));
+    if(builtin && optimiser_symbol(optimiser, name)->bindings == 0)
+    {
+        return builtin;
+    }
+    return NULL;
+}
+bool optimiser_is_literal(void *expression)
+{
+    TORAExpressionType type = ((TORAParserUnknownExpression *)expression)->type;
+    return type == TORAExpressionTypeNumeric || type == TORAExpressionTypeString || type == TORAExpressionTypeBoolean;
+}
+// Whether an expression is known to evaluate to a number (or fail before it could evaluate to anything else)
+bool optimiser_is_numeric(TORAOptimiser *optimiser, void *expression)
+{
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeNumeric:
+        case TORAExpressionTypeNegativeUnary:
+            return true;
+            break;
+        case TORAExpressionTypeBinary:
+        {
+            TORAParserAssignOrBinaryExpression *binary_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            switch(operator_kind(binary_expression->op, strlen(binary_expression->op)))
+            {
+                case TORATokenKindSubtract:
+                case TORATokenKindMultiply:
+                case TORATokenKindDivide:
+                case TORATokenKindModulo:
+                    return true;
+                    break;
+                case TORATokenKindAdd:
+                    return optimiser_is_numeric(optimiser, binary_expression->left);
+                    break;
+                default:
+                    break;
+            }
+        }
+            break;
+        case TORAExpressionTypeBuiltinCall:
+            return ((TORAParserBuiltinCallExpression *)expression)->builtin->pure;
+            break;
+        default:
+            break;
+    }
+    
+    return false;
+}
+// Compares sign as well as value, so -0 is never taken for 0
+bool optimiser_is_number(void *expression, double val)
+{
+    TORAParserNumericExpression *numeric_expression = (TORAParserNumericExpression *)expression;
+    return numeric_expression->type == TORAExpressionTypeNumeric &&
+           numeric_expression->val == val &&
+           signbit(numeric_expression->val) == signbit(val);
+}
+// Whether evaluating an expression does nothing but work out its value (or fail). Given
+// a function's parameters, any other name it uses must also be one no function binds,
+// so it's found at the top level wherever the expression's evaluated
+bool optimiser_is_pure(TORAOptimiser *optimiser, void *expression, TORAParserExpressionList *parameters)
+{
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeNumeric:
+        case TORAExpressionTypeString:
+        case TORAExpressionTypeBoolean:
+            return true;
+            break;
+        case TORAExpressionTypeVariable:
+        {
+            const char *name = ((TORAParserVariableExpression *)expression)->val;
+            return !parameters || optimiser_parameter(parameters, name) >= 0 || optimiser_symbol(optimiser, name)->local_bindings == 0;
+        }
+            break;
+        case TORAExpressionTypeBinary:
+        {
+            TORAParserAssignOrBinaryExpression *binary_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            return optimiser_is_pure(optimiser, binary_expression->left, parameters) && optimiser_is_pure(optimiser, binary_expression->right, parameters);
+        }
+            break;
+        case TORAExpressionTypeNegativeUnary:
+            return optimiser_is_pure(optimiser, ((TORAParserNegativeUnaryExpression *)expression)->expression, parameters);
+            break;
+        case TORAExpressionTypeArrayIndex:
+        {
+            TORAParserArrayIndexExpression *index_expression = (TORAParserArrayIndexExpression *)expression;
+            return optimiser_is_pure(optimiser, index_expression->array, parameters) && optimiser_is_pure(optimiser, index_expression->index, parameters);
+        }
+            break;
+        case TORAExpressionTypeBuiltinCall:
+        case TORAExpressionTypeConcat:
+        {
+            TORAParserExpressionList *list = ((TORAParserConcatExpression *)expression)->pieces;
+            if(unknown_expression->type == TORAExpressionTypeBuiltinCall)
+            {
+                TORAParserBuiltinCallExpression *call_expression = (TORAParserBuiltinCallExpression *)expression;
+                if(!call_expression->builtin->pure)
+                {
+                    return false;
+                }
+                list = call_expression->arguments;
+            }
+            
+            for(uint32_t i = 0; i < list->length; i++)
+            {
+                if(!optimiser_is_pure(optimiser, list->items[i], parameters))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+            break;
+        default:
+            break;
+    }
+    
+    return false;
+}
+// Whether an expression is certain to evaluate to something, if it doesn't fail
+bool optimiser_has_value(void *expression)
+{
+    TORAExpressionType type = ((TORAParserUnknownExpression *)expression)->type;
+    return optimiser_is_literal(expression) ||
+           type == TORAExpressionTypeBinary ||
+           type == TORAExpressionTypeNegativeUnary ||
+           type == TORAExpressionTypeConcat;
+}
+// The expressions an expression's made from, other than the body of a function
+uint32_t optimiser_num_children(void *expression)
+{
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeAssign:
+        case TORAExpressionTypeBinary:
+        case TORAExpressionTypeArrayIndex:
+        case TORAExpressionTypeWhile:
+            return 2;
+            break;
+        case TORAExpressionTypeIfThenElse:
+            return 3;
+            break;
+        case TORAExpressionTypeNegativeUnary:
+        case TORAExpressionTypeReturn:
+            return 1;
+            break;
+        case TORAExpressionTypeCall:
+            return 1 + ((TORAParserCallExpression *)expression)->arguments->length;
+            break;
+        case TORAExpressionTypeBuiltinCall:
+            return ((TORAParserBuiltinCallExpression *)expression)->arguments->length;
+            break;
+        case TORAExpressionTypeConcat:
+            return ((TORAParserConcatExpression *)expression)->pieces->length;
+            break;
+        case TORAExpressionTypeProg:
+            return ((TORAParserProgExpression *)expression)->val->length;
+            break;
+        case TORAExpressionTypeArray:
+        {
+            TORAParserArrayExpression *array_expression = (TORAParserArrayExpression *)expression;
+            return array_expression->items ? array_expression->items->length : 0;
+        }
+            break;
+        default:
+            break;
+    }
+    
+    return 0;
+}
+void *optimiser_child(void *expression, uint32_t i)
+{
+    TORAParserUnknownExpression *unknown_expression = (TORAParserUnknownExpression *)expression;
+    switch(unknown_expression->type)
+    {
+        case TORAExpressionTypeAssign:
+        case TORAExpressionTypeBinary:
+        {
+            TORAParserAssignOrBinaryExpression *binary_expression = (TORAParserAssignOrBinaryExpression *)expression;
+            return i == 0 ? binary_expression->left : binary_expression->right;
+        }
+            break;
+        case TORAExpressionTypeArrayIndex:
+        {
+            TORAParserArrayIndexExpression *index_expression = (TORAParserArrayIndexExpression *)expression;
+            return i == 0 ? index_expression->array : index_expression->index;
+        }
+            break;
+        case TORAExpressionTypeWhile:
+        {
+            TORAParserWhileExpression *while_expression = (TORAParserWhileExpression *)expression;
+            return i == 0 ? while_expression->condition : while_expression->body;
+        }
+            break;
+        case TORAExpressionTypeIfThenElse:
+        {
+            TORAParserIfThenElseExpression *if_expression = (TORAParserIfThenElseExpression *)expression;
+            return i == 0 ? if_expression->condition : (i == 1 ? if_expression->then : if_expression->el);
+        }
+            break;
+        case TORAExpressionTypeNegativeUnary:
+        case TORAExpressionTypeReturn:
+            return ((TORAParserReturnExpression *)expression)->expression;
+            break;
+        case TORAExpressionTypeCall:
+        {
+            TORAParserCallExpression *call_expression = (TORAParserCallExpression *)expression;
+            return i == 0 ? call_expression->func : call_expression->arguments->items[i - 1];
+        }
+            break;
+        case TORAExpressionTypeBuiltinCall:
+            return ((TORAParserBuiltinCallExpression *)expression)->arguments->items[i];
+            break;
+        case TORAExpressionTypeConcat:
+            return ((TORAParserConcatExpression *)expression)->pieces->items[i];
+            break;
+        case TORAExpressionTypeProg:
+            return ((TORAParserProgExpression *)expression)->val->items[i];
+            break;
+        case TORAExpressionTypeArray:
+            return ((TORAParserArrayExpression *)expression)->items->items[i];
+            break;
+        default:
+            break;
+    }
+    
+    return NULL;
+}
@@ -0,0 +1,28 @@
+//
+//  optimiser.h
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#ifndef optimiser_h
+#define optimiser_h
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "parser.h"
+
+// The optimiser rewrites a program's tree after it's been parsed and before it's
+// flattened. Any nodes it creates are allocated from the arena the tree was parsed into.
+// optimise_program returns the top-level assignments it found to be constants, in the
+// order they're made, for any function bodies that are optimised later on
+TORAParserExpressionList *optimise_program(TORAParserProgExpression *prog, TORAArena *arena);
+
+// Optimises the body of a function defined at the top level of its program, given
+// the names bound there (as variables) and the constants assigned before it
+void optimise_function(TORAParserLambdaExpression *function, TORAParserExpressionList *globals, TORAParserExpressionList *constants, TORAArena *arena);
+
+#endif /* optimiser_h */
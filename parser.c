@@ -13,14 +13,16 @@
 
 typedef void* (*TORAParserCallback) (TORATokenStream*);
 
-bool parser_is_punctuation(TORATokenStream *token_stream, char *cmp);
-void parser_skip_punctuation(TORATokenStream *token_stream, char *cmp);
-bool parser_is_keyword(TORATokenStream *token_stream, char *cmp);
-void parser_skip_keyword(TORATokenStream *token_stream, char *cmp);
-bool parser_is_operator(TORATokenStream *token_stream, char *cmp);
-void parser_skip_operator(TORATokenStream *token_stream, char *cmp);
+bool parser_is_punctuation(TORATokenStream *token_stream, TORATokenKind kind);
+void parser_skip_punctuation(TORATokenStream *token_stream, TORATokenKind kind);
+bool parser_is_keyword(TORATokenStream *token_stream, TORATokenKind kind);
+void parser_skip_keyword(TORATokenStream *token_stream, TORATokenKind kind);
+bool parser_is_operator(TORATokenStream *token_stream, TORATokenKind kind);
+void parser_skip_operator(TORATokenStream *token_stream, TORATokenKind kind);
 
 void* parse_prog(TORATokenStream *token_stream);
+void parser_skip_block(TORATokenStream *token_stream);
+void *parser_literal_expression(TORAFlatProgram *program, TORAFlatIndex node);
 void* parse_array(TORATokenStream *token_stream);
 void* parse_array_lookup(TORATokenStream *token_stream, void *array);
 void* parse_while(TORATokenStream *token_stream);
@@ -36,52 +38,178 @@ void* parser_maybe_binary(TORATokenStream *token_stream, void* left_expression,
 void* parser_maybe_call(TORATokenStream *token_stream, TORAParserCallback);
 void* parser_maybe_array_lookup(TORATokenStream *token_stream, TORAParserCallback parse_function);
 
-TORALinkedList* delimited(TORATokenStream *token_stream, char *start, char *stop, char *separator, TORAParserCallback parser_callback);;
+// Children are gathered into a builder while they're being parsed, and copied into
+// an exactly sized TORAParserExpressionList once we know how many there are. Most
+// lists are short enough to never need more than the builder's inline storage
+#define TORA_PARSER_LIST_INLINE_CAPACITY 16
 
-TORAParserProgExpression *parse_top_level(TORATokenStream *token_stream)
+typedef struct {
+    void **items;
+    uint32_t length;
+    uint32_t capacity;
+    void *inline_items[TORA_PARSER_LIST_INLINE_CAPACITY];
+} TORAParserListBuilder;
+
+TORAParserExpressionList* delimited(TORATokenStream *token_stream, TORATokenKind start, TORATokenKind stop, TORATokenKind separator, TORAParserCallback parser_callback);
+void parser_list_init(TORAParserListBuilder *builder);
+void parser_list_append(TORAParserListBuilder *builder, void *item);
+TORAParserExpressionList* parser_list_finish(TORAParserListBuilder *builder);
+void* parser_new_instance(size_t size, TORAExpressionType type);
+char* parser_strncpy(const char *str, size_t length);
+
+// While parse_top_level is running, every node and list it creates comes from
+// this arena rather than being individually malloc'd
+TORAArena *parser_arena = NULL;
+
+// Whether the bodies of functions defined at the top level are being skipped, and
+// how many function bodies deep the parser currently is
+bool parser_lazy_functions = false;
+uint32_t parser_function_depth = 0;
+
+// Parses an entire program. When an arena is given the resulting AST is allocated
+// from it: its nodes are immortal (retain/release are no-ops) and are all freed
+// together by free_arena, rather than with free_expression.
+//
+// With lazy_functions set the bodies of functions defined at the top level are only
+// brace matched, and left to be parsed by parse_function_body when they're first
+// called. Skipped bodies are revisited through the token stream, so this only
+// applies to buffered streams
+TORAParserProgExpression *parse_top_level(TORATokenStream *token_stream, TORAArena *arena, bool lazy_functions)
 {
-    TORALinkedList *expression_list_head = NULL;
-    TORALinkedList *expression_list_cur = NULL;
+    TORAParserListBuilder expressions;
+    parser_list_init(&expressions);
     
+    parser_arena = arena;
+    parser_lazy_functions = lazy_functions && token_stream->buffered;
+    parser_function_depth = 0;
     while(!token_stream_eof(token_stream))
     {
-        void* expression = parse_expression(token_stream);
-
-        TORALinkedList *expression_item = tora_malloc(sizeof(TORALinkedList));
-        if(!expression_item)
+        parser_list_append(&expressions, parse_expression(token_stream));
+        
+        if(!token_stream_eof(token_stream)) parser_skip_punctuation(token_stream, TORATokenKindSemicolon);
+    }
+    
+    // Once we've generated our expression list we wrap it in a prog expression
+    // and then send it along for interpretation
+    TORAParserProgExpression *prog = NULL;
+    bool empty = expressions.length == 0;
+    TORAParserExpressionList *expression_list = parser_list_finish(&expressions);
+    if(!empty)
+    {
+        prog = new_prog_expression(expression_list);
+    }
+    else if(!arena)
+    {
+        free_expression_list(expression_list);
+    }
+    parser_arena = NULL;
+    parser_lazy_functions = false;
+    
+    return prog;
+}
+// Parses an entire program into the flat form the interpreter evaluates. The tree
+// built along the way is allocated from a temporary arena, freed once it's flattened.
+// A program whose functions are parsed lazily keeps hold of the token stream, which
+// has to outlive it
+TORAFlatProgram *parse_program(TORATokenStream *token_stream, bool lazy_functions)
+{
+    TORAArena *arena = arena_create();
+    TORAParserProgExpression *prog = parse_top_level(token_stream, arena, lazy_functions);
+    
+    TORAFlatProgram *program = NULL;
+    if(prog)
+    {
+        TORAParserExpressionList *constants = optimise_program(prog, arena);
+        program = flat_program_from_expression(prog, constants);
+        program->source = token_stream;
+    }
+    free_arena(arena);
+    
+    return program;
+}
+// Parses the body of a function that parse_top_level skipped, and adds it to the
+// program. The function was defined at the top level, so all it can see of its
+// surroundings is the names bound there and the constants assigned before it
+void parse_function_body(TORAFlatProgram *program, uint32_t function)
+{
+    TORATokenStream *token_stream = program->source;
+    assert(token_stream && token_stream->buffered);
+    assert(program->functions[function].body == TORA_FLAT_NONE);
+    
+    TORAArena *arena = arena_create();
+    parser_arena = arena;
+    
+    uint64_t token_index = token_stream->token_index;
+    uint32_t first_token = program->functions[function].first_token;
+    token_stream->token_index = first_token;
+    void *body = parse_expression(token_stream);
+    if(token_stream->token_index != (uint64_t)first_token + program->functions[function].num_tokens)
+    {
+        TORAToken *token = &token_stream->tokens[first_token];
+        TORA_PARSER_EXCEPTION(token->line, token->col, "Unexpected tokens in function body");
+    }
+    token_stream->token_index = token_index;
+    
+    // Rebuild as much of the function and its surroundings as the optimiser needs
+    uint32_t num_parameters = program->children[program->functions[function].parameters];
+    TORAParserListBuilder items;
+    parser_list_init(&items);
+    for(uint32_t i = 0; i < num_parameters; i++)
+    {
+        const char *parameter = flat_program_string(program, program->children[program->functions[function].parameters + 1 + i]);
+        parser_list_append(&items, new_variable_expression_with_length(parameter, strlen(parameter)));
+    }
+    TORAParserLambdaExpression *lambda = new_function_expression(NULL, body, parser_list_finish(&items));
+    
+    uint32_t num_globals = program->children[program->globals];
+    parser_list_init(&items);
+    for(uint32_t i = 0; i < num_globals; i++)
+    {
+        const char *name = flat_program_string(program, program->children[program->globals + 1 + i]);
+        parser_list_append(&items, new_variable_expression_with_length(name, strlen(name)));
+    }
+    TORAParserExpressionList *globals = parser_list_finish(&items);
+    
+    parser_list_init(&items);
+    for(uint32_t i = 0; i < program->functions[function].num_constants; i++)
+    {
+        uint32_t *constant = program->children + program->constants + 1 + i * 2;
+        const char *name = flat_program_string(program, constant[0]);
+        void *variable = new_variable_expression_with_length(name, strlen(name));
+        parser_list_append(&items, new_assign_expression("=", variable, parser_literal_expression(program, constant[1])));
+    }
+    TORAParserExpressionList *constants = parser_list_finish(&items);
+    parser_arena = NULL;
+    
+    optimise_function(lambda, globals, constants, arena);
+    flat_program_add_function_body(program, function, lambda->body);
+    free_arena(arena);
+}
+// Parses the body of every function that's yet to be called, so the program can be
+// saved as a whole. Returns false, leaving the rest unparsed, if one turns out to be
+// invalid; as it was never called, that's only reported by running with --eager
+bool parse_function_bodies(TORAFlatProgram *program)
+{
+    bool parsed = true;
+    for(uint32_t i = 0; i < program->num_functions && parsed; i++)
+    {
+        if(program->functions[i].body != TORA_FLAT_NONE)
         {
-            TORA_RUNTIME_EXCEPTION("Failed to malloc prog expression list item");
+            continue;
         }
-        expression_item->instance_type = TORAInstanceTypeLinkedList;
-        expression_item->ref_count = 0;
         
-        expression_item->name = NULL;
-        expression_item->value = tora_retain(expression);
-        expression_item->next = NULL;
-        
-        if(expression_list_head == NULL)
+        try
         {
-            expression_list_head = expression_item;
-            expression_list_cur = expression_list_head;
+            parse_function_body(program, i);
         }
-        else
+        catch(ParserException)
         {
-            expression_list_cur->next = expression_item;
-            expression_list_cur = expression_item;
-            
-            tora_retain(expression_item);
+            free_arena(parser_arena);
+            parser_arena = NULL;
+            parsed = false;
         }
-        
-        if(!token_stream_eof(token_stream)) parser_skip_punctuation(token_stream, ";");
-    }
-    
-    // Once we've generated our expression list we wrap it in a prog expression
-    // and then send it along for interpretation
-    if(expression_list_head)
-    {
-        return new_prog_expression(expression_list_head);
     }
-    return NULL;
+    return parsed;
 }
 void* parse_expression(TORATokenStream *token_stream)
 {
@@ -96,18 +224,8 @@ void* parse_bool(TORATokenStream *token_stream)
 {
     TORAToken *next_token = token_stream_next(token_stream);
     assert(next_token);
-    assert(next_token->val);
     
-    TORAParserBoolExpression *expression = tora_malloc(sizeof(TORAParserBoolExpression));
-    if(!expression)
-    {
-        TORA_RUNTIME_EXCEPTION("Failed to malloc boolean expression");
-    }
-    
-    expression->type = TORAExpressionTypeBoolean;
-    expression->val = strcmp((char *)next_token->val, "true") == 0;
-    
-    return expression;
+    return new_boolean_expression(next_token->kind == TORATokenKindTrue);
 }
 void* parse_varname(TORATokenStream *token_stream)
 {
@@ -116,10 +234,10 @@ void* parse_varname(TORATokenStream *token_stream)
     
     if(token->type != TORATokenTypeVariable)
     {
-        TORA_PARSER_EXCEPTION(token_stream->input_stream->line, token_stream->input_stream->col, "Expected a variable token, received token of type: %d", token->type);
+        TORA_PARSER_EXCEPTION(token->line, token->col, "Expected a variable token, received token of type: %d", token->type);
     }
     
-    return new_variable_expression(token->val);
+    return new_variable_expression_with_length(token_chars(token_stream, token), token->length);
 }
 void* parse_function(TORATokenStream *token_stream)
 {
@@ -131,13 +249,29 @@ void* parse_function(TORATokenStream *token_stream)
         next_token = token_stream_next(token_stream);
         if(next_token)
         {
-            name = tora_strcpy(next_token->val);
+            name = token_copy_value(token_stream, next_token);
         }
     }
     
-    TORALinkedList *arguments = delimited(token_stream, "(", ")", ",", parse_varname);
-    void *body = parse_expression(token_stream);
-    void *function = new_function_expression(name, body, arguments);
+    TORAParserExpressionList *arguments = delimited(token_stream, TORATokenKindOpenParen, TORATokenKindCloseParen, TORATokenKindComma, parse_varname);
+    TORAParserLambdaExpression *function = NULL;
+    if(parser_lazy_functions && parser_function_depth == 0 && parser_is_punctuation(token_stream, TORATokenKindOpenBrace))
+    {
+        uint64_t first_token = token_stream->token_index;
+        parser_skip_block(token_stream);
+        
+        function = new_function_expression(name, NULL, arguments);
+        function->first_token = (uint32_t)first_token;
+        function->num_tokens = (uint32_t)(token_stream->token_index - first_token);
+    }
+    else
+    {
+        parser_function_depth++;
+        void *body = parse_expression(token_stream);
+        parser_function_depth--;
+        
+        function = new_function_expression(name, body, arguments);
+    }
     if(name)
     {
         tora_free(name);
@@ -147,20 +281,41 @@ void* parse_function(TORATokenStream *token_stream)
 }
 void* parse_prog(TORATokenStream *token_stream)
 {
-    TORALinkedList *expression_list = delimited(token_stream, "{", "}", ";", parse_expression);
+    TORAParserExpressionList *expression_list = delimited(token_stream, TORATokenKindOpenBrace, TORATokenKindCloseBrace, TORATokenKindSemicolon, parse_expression);
     return new_prog_expression(expression_list);
 }
+// Moves past a brace delimited block without parsing what's inside, other than to
+// match up its braces
+void parser_skip_block(TORATokenStream *token_stream)
+{
+    TORAToken *open_token = token_stream_next(token_stream);
+    uint64_t depth = 1;
+    while(depth > 0)
+    {
+        TORAToken *token = token_stream_next(token_stream);
+        if(!token)
+        {
+            TORA_PARSER_EXCEPTION(open_token->line, open_token->col, "Unterminated function body");
+        }
+        
+        if(token->type == TORATokenTypePunctuation)
+        {
+            if(token->kind == TORATokenKindOpenBrace) depth++;
+            else if(token->kind == TORATokenKindCloseBrace) depth--;
+        }
+    }
+}
 void* parse_array(TORATokenStream *token_stream)
 {
-    TORALinkedList *expression_list_head = NULL;
-    TORALinkedList *expression_list_cur = NULL;
+    TORAParserListBuilder items;
+    parser_list_init(&items);
     
     bool first = true;
-    parser_skip_punctuation(token_stream, "[");
+    parser_skip_punctuation(token_stream, TORATokenKindOpenBracket);
     while(!token_stream_eof(token_stream))
     {
         // If we've reached our stop token bail out
-        if(parser_is_punctuation(token_stream, "]")) break;
+        if(parser_is_punctuation(token_stream, TORATokenKindCloseBracket)) break;
         
         // If this is our first iteration we need to skip over our start token
         if(first)
@@ -169,19 +324,19 @@ void* parse_array(TORATokenStream *token_stream)
         }
         else
         {
-            parser_skip_punctuation(token_stream, ",");
+            parser_skip_punctuation(token_stream, TORATokenKindComma);
         }
         
         // Make sure we haven't hit our stop token after skipping over our start token
-        if(parser_is_punctuation(token_stream, "]")) break;
+        if(parser_is_punctuation(token_stream, TORATokenKindCloseBracket)) break;
         
         void *key_expression = NULL;
         void *value_expression = parse_expression(token_stream);
         // Look for the existence of a : punctuation token to denote an
         // associative value assignment
-        if(parser_is_punctuation(token_stream, ":"))
+        if(parser_is_punctuation(token_stream, TORATokenKindColon))
         {
-            parser_skip_punctuation(token_stream, ":");
+            parser_skip_punctuation(token_stream, TORATokenKindColon);
             
             // If this is an associative assignment, the first expression
             // (value_expression) actually represents our key
@@ -192,38 +347,15 @@ void* parse_array(TORATokenStream *token_stream)
         // index for the new item
         else
         {
-            key_expression = new_numeric_expression(linked_list_length(expression_list_head));
+            key_expression = new_numeric_expression(items.length / 2);
         }
         
-        // Create a basic linked-list to store all of our expressions
-        TORALinkedList *expression_list_item = tora_malloc(sizeof(TORALinkedList));
-        if(!expression_list_item)
-        {
-            TORA_RUNTIME_EXCEPTION("delimited failed to malloc linked list item");
-        }
-        expression_list_item->instance_type = TORAInstanceTypeLinkedList;
-        expression_list_item->ref_count = 0;
-        
-        expression_list_item->name = tora_retain(key_expression);
-        expression_list_item->value = tora_retain(value_expression);
-        expression_list_item->next = NULL;
-        
-        if(expression_list_head == NULL)
-        {
-            expression_list_head = expression_list_item;
-            expression_list_cur = expression_list_head;
-        }
-        else
-        {
-            expression_list_cur->next = expression_list_item;
-            expression_list_cur = expression_list_item;
-            
-            tora_retain(expression_list_item);
-        }
+        parser_list_append(&items, key_expression);
+        parser_list_append(&items, value_expression);
     }
     
-    parser_skip_punctuation(token_stream, "]");
-    return new_array_expression(expression_list_head);
+    parser_skip_punctuation(token_stream, TORATokenKindCloseBracket);
+    return new_array_literal_expression(parser_list_finish(&items));
 }
 void* parse_array_lookup(TORATokenStream *token_stream, void *array)
 {
@@ -231,11 +363,11 @@ void* parse_array_lookup(TORATokenStream *token_stream, void *array)
     // array[0][1], we iterate through and adjust the left_expression
     // accordingly
     void *left_expression = array;
-    while(parser_is_punctuation(token_stream, "["))
+    while(parser_is_punctuation(token_stream, TORATokenKindOpenBracket))
     {
-        parser_skip_punctuation(token_stream, "[");
+        parser_skip_punctuation(token_stream, TORATokenKindOpenBracket);
         void *index = parse_expression(token_stream);
-        parser_skip_punctuation(token_stream, "]");
+        parser_skip_punctuation(token_stream, TORATokenKindCloseBracket);
         
         left_expression = new_array_index_expression(index, left_expression);
     }
@@ -244,7 +376,7 @@ void* parse_array_lookup(TORATokenStream *token_stream, void *array)
 }
 void* parse_while(TORATokenStream *token_stream)
 {
-    parser_skip_keyword(token_stream, "while");
+    parser_skip_keyword(token_stream, TORATokenKindWhile);
     void *condition = parse_expression(token_stream);
     void *body = parse_expression(token_stream);
     
@@ -252,12 +384,12 @@ void* parse_while(TORATokenStream *token_stream)
 }
 void* parse_if(TORATokenStream *token_stream)
 {
-    parser_skip_keyword(token_stream, "if");
+    parser_skip_keyword(token_stream, TORATokenKindIf);
     void *condition = parse_expression(token_stream);
     void *then = parse_expression(token_stream);
     void *el = NULL;
     
-    if(parser_is_keyword(token_stream, "else"))
+    if(parser_is_keyword(token_stream, TORATokenKindElse))
     {
         token_stream_next(token_stream);
         el = parse_expression(token_stream);
@@ -267,10 +399,10 @@ void* parse_if(TORATokenStream *token_stream)
 }
 void* parse_return(TORATokenStream *token_stream)
 {
-    parser_skip_keyword(token_stream, "return");
+    parser_skip_keyword(token_stream, TORATokenKindReturn);
     
     void *expression = NULL;
-    if(!parser_is_punctuation(token_stream, ";"))
+    if(!parser_is_punctuation(token_stream, TORATokenKindSemicolon))
     {
         expression = parse_expression(token_stream);
     }
@@ -284,7 +416,7 @@ void* parse_return(TORATokenStream *token_stream)
 }
 void* parse_call(TORATokenStream *token_stream, void *func)
 {
-    return new_call_expression(func, delimited(token_stream, "(", ")", ",", parse_expression));
+    return new_call_expression(func, delimited(token_stream, TORATokenKindOpenParen, TORATokenKindCloseParen, TORATokenKindComma, parse_expression));
 }
 void* parse_atom(TORATokenStream *token_stream)
 {
@@ -292,43 +424,43 @@ void* parse_atom(TORATokenStream *token_stream)
 }
 void* parse_atom_callback(TORATokenStream *token_stream)
 {
-    if(parser_is_punctuation(token_stream, "("))
+    if(parser_is_punctuation(token_stream, TORATokenKindOpenParen))
     {
         token_stream_next(token_stream);
         void *expression = parse_expression(token_stream);
-        parser_skip_punctuation(token_stream, ")");
+        parser_skip_punctuation(token_stream, TORATokenKindCloseParen);
         return expression;
     }
-    if(parser_is_punctuation(token_stream, "{"))
+    if(parser_is_punctuation(token_stream, TORATokenKindOpenBrace))
     {
         return parse_prog(token_stream);
     }
-    if(parser_is_punctuation(token_stream, "["))
+    if(parser_is_punctuation(token_stream, TORATokenKindOpenBracket))
     {
         return parse_array(token_stream);
     }
-    if(parser_is_keyword(token_stream, "if"))
+    if(parser_is_keyword(token_stream, TORATokenKindIf))
     {
         return parse_if(token_stream);
     }
-    if(parser_is_keyword(token_stream, "while"))
+    if(parser_is_keyword(token_stream, TORATokenKindWhile))
     {
         return parse_while(token_stream);
     }
-    if(parser_is_keyword(token_stream, "true") || parser_is_keyword(token_stream, "false"))
+    if(parser_is_keyword(token_stream, TORATokenKindTrue) || parser_is_keyword(token_stream, TORATokenKindFalse))
     {
         return parse_bool(token_stream);
     }
-    if(parser_is_keyword(token_stream, "func"))
+    if(parser_is_keyword(token_stream, TORATokenKindFunc))
     {
         token_stream_next(token_stream);
         return parse_function(token_stream);
     }
-    if(parser_is_keyword(token_stream, "return"))
+    if(parser_is_keyword(token_stream, TORATokenKindReturn))
     {
         return parse_return(token_stream);
     }
-    if(parser_is_operator(token_stream, "-"))
+    if(parser_is_operator(token_stream, TORATokenKindSubtract))
     {
         token_stream_next(token_stream);
         
@@ -358,18 +490,18 @@ void* parse_atom_callback(TORATokenStream *token_stream)
     switch(token->type)
     {
         case TORATokenTypeVariable:
-            return new_variable_expression(token->val);
+            return new_variable_expression_with_length(token_chars(token_stream, token), token->length);
             break;
         case TORATokenTypeNumeric:
             return new_numeric_expression(token->numeric_val);
             break;
         case TORATokenTypeStr:
-            return new_string_expression(token->val);
+            return new_string_expression_with_length(token_chars(token_stream, token), token->length);
             break;
         default:
-            TORA_PARSER_EXCEPTION(token_stream->input_stream->line,
-                                  token_stream->input_stream->col,
-                                  "Unexpected token encountered: %s", token->val);
+            TORA_PARSER_EXCEPTION(token->line,
+                                  token->col,
+                                  "Unexpected token encountered: %.*s", (int)token->length, token_chars(token_stream, token));
             break;
     }
     
@@ -380,11 +512,11 @@ void* parse_atom_callback(TORATokenStream *token_stream)
 void *parser_maybe_call(TORATokenStream *token_stream, TORAParserCallback parse_function)
 {
     void *result_expression = parse_function(token_stream);
-    if(parser_is_punctuation(token_stream, "("))
+    if(parser_is_punctuation(token_stream, TORATokenKindOpenParen))
     {
         return parse_call(token_stream, result_expression);
     }
-    else if(parser_is_punctuation(token_stream, "["))
+    else if(parser_is_punctuation(token_stream, TORATokenKindOpenBracket))
     {
         return parse_array_lookup(token_stream, result_expression);
     }
@@ -393,20 +525,23 @@ void *parser_maybe_call(TORATokenStream *token_stream, TORAParserCallback parse_
 }
 void* parser_maybe_binary(TORATokenStream *token_stream, void *left_expression, int precedence)
 {
-    if(parser_is_operator(token_stream, NULL))
+    if(parser_is_operator(token_stream, TORATokenKindNone))
     {
         TORAToken *token = token_stream_peek(token_stream);
-        int his_precedence = get_operator_precendence((char *)token->val);
+        TORATokenKind kind = (TORATokenKind)token->kind;
+        int his_precedence = get_operator_precendence(kind);
         if(his_precedence > precedence)
         {
-            char *val = tora_strcpy((char *)token->val);
+            // Any operator with a precedence is one we know, so its text comes from our
+            // kind table. It'll be copied when assigning to the expression
+            char *val = (char *)tora_token_kind_text[kind];
             token_stream_next(token_stream);
-        
+            
             void *right_expression = parser_maybe_binary(token_stream, parse_atom(token_stream), his_precedence);
             void *result = NULL;
             
             // If this is a = operator, treat it as an assignment
-            if(strcmp(val, "=") == 0)
+            if(kind == TORATokenKindAssign)
             {
                 TORAParserAssignOrBinaryExpression *expression = new_assign_expression(val, left_expression, right_expression);
                 result = parser_maybe_binary(token_stream, expression, precedence);
@@ -418,9 +553,6 @@ void* parser_maybe_binary(TORATokenStream *token_stream, void *left_expression,
                 result = parser_maybe_binary(token_stream, expression, precedence);
             }
             
-            // The op will be copied when assigning to the expression, so free our copy here
-            tora_free(val);
-            
             return result;
         }
     }
@@ -429,10 +561,10 @@ void* parser_maybe_binary(TORATokenStream *token_stream, void *left_expression,
 }
 
 // Helpers
-TORALinkedList* delimited(TORATokenStream *token_stream, char *start, char *stop, char *separator, TORAParserCallback parser_callback)
+TORAParserExpressionList* delimited(TORATokenStream *token_stream, TORATokenKind start, TORATokenKind stop, TORATokenKind separator, TORAParserCallback parser_callback)
 {
-    TORALinkedList *expression_list_head = NULL;
-    TORALinkedList *expression_list_cur = NULL;
+    TORAParserListBuilder expressions;
+    parser_list_init(&expressions);
     
     bool first = true;
     parser_skip_punctuation(token_stream, start);
@@ -455,122 +587,213 @@ TORALinkedList* delimited(TORATokenStream *token_stream, char *start, char *stop
         if(parser_is_punctuation(token_stream, stop)) break;
         
         // If not, this must be our first valid token, so try to parse it
-        void *expression = parser_callback(token_stream);
-        
-        // Create a basic linked-list to store all of our expressions
-        TORALinkedList *expression_list_item = tora_malloc(sizeof(TORALinkedList));
-        if(!expression_list_item)
+        parser_list_append(&expressions, parser_callback(token_stream));
+    }
+    
+    parser_skip_punctuation(token_stream, stop);
+    return parser_list_finish(&expressions);
+}
+void parser_list_init(TORAParserListBuilder *builder)
+{
+    builder->items = builder->inline_items;
+    builder->length = 0;
+    builder->capacity = TORA_PARSER_LIST_INLINE_CAPACITY;
+}
+void parser_list_append(TORAParserListBuilder *builder, void *item)
+{
+    if(builder->length == builder->capacity)
+    {
+        uint32_t capacity = builder->capacity * 2;
+        void **items = NULL;
+        if(builder->items == builder->inline_items)
         {
-            TORA_RUNTIME_EXCEPTION("delimited failed to malloc linked list item");
+            items = tora_malloc(capacity * sizeof(void *));
+            if(items)
+            {
+                memcpy(items, builder->inline_items, builder->length * sizeof(void *));
+            }
+        }
+        else
+        {
+            items = realloc(builder->items, capacity * sizeof(void *));
         }
-        expression_list_item->instance_type = TORAInstanceTypeLinkedList;
-        expression_list_item->ref_count = 0;
-        
-        expression_list_item->name = NULL;
-        expression_list_item->value = tora_retain(expression);
-        expression_list_item->next = NULL;
         
-        if(expression_list_head == NULL)
+        if(!items)
         {
-            expression_list_head = expression_list_item;
-            expression_list_cur = expression_list_head;
+            TORA_RUNTIME_EXCEPTION("Failed to malloc space for expression list");
         }
-        else
+        builder->items = items;
+        builder->capacity = capacity;
+    }
+    
+    builder->items[builder->length++] = tora_retain(item);
+}
+TORAParserExpressionList* parser_list_finish(TORAParserListBuilder *builder)
+{
+    size_t size = sizeof(TORAParserExpressionList) + builder->length * sizeof(void *);
+    TORAParserExpressionList *list = parser_arena ? arena_alloc(parser_arena, size) : tora_malloc(size);
+    if(!list)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for expression list");
+    }
+    list->length = builder->length;
+    memcpy(list->items, builder->items, builder->length * sizeof(void *));
+    
+    if(builder->items != builder->inline_items)
+    {
+        tora_free(builder->items);
+    }
+    builder->items = builder->inline_items;
+    builder->length = 0;
+    
+    return list;
+}
+void free_expression_list(TORAParserExpressionList *list)
+{
+    for(uint32_t i = 0; i < list->length; i++)
+    {
+        tora_release(list->items[i]);
+    }
+    tora_free(list);
+}
+// Expressions created during parsing are allocated from the parser's arena, and any
+// created afterwards (the interpreter's values, for instance) are malloc'd and counted
+void* parser_new_instance(size_t size, TORAExpressionType type)
+{
+    TORAParserUnknownExpression *expression = NULL;
+    if(parser_arena)
+    {
+        expression = arena_alloc(parser_arena, size);
+        expression->ref_count = TORA_REF_COUNT_IMMORTAL;
+    }
+    else
+    {
+        expression = tora_malloc(size);
+        if(!expression)
         {
-            expression_list_cur->next = expression_list_item;
-            expression_list_cur = expression_list_item;
-            
-            tora_retain(expression_list_item);
+            return NULL;
         }
+        expression->ref_count = 0;
     }
+    expression->instance_type = TORAInstanceTypeExpression;
+    expression->type = type;
     
-    parser_skip_punctuation(token_stream, stop);
-    return expression_list_head;
+    return expression;
+}
+char* parser_strncpy(const char *str, size_t length)
+{
+    if(parser_arena)
+    {
+        return arena_strncpy(parser_arena, str, length);
+    }
+    return tora_strncpy(str, length);
+}
+// Rebuilds a literal from the flat node holding it
+void *parser_literal_expression(TORAFlatProgram *program, TORAFlatIndex node)
+{
+    TORAFlatNode *flat_node = &program->nodes[node];
+    switch(flat_node->type)
+    {
+        case TORAExpressionTypeNumeric:
+            return new_numeric_expression(program->numbers[flat_node->val]);
+            break;
+        case TORAExpressionTypeString:
+        {
+            const char *string = flat_program_string(program, flat_node->val);
+            return new_string_expression_with_length(string, strlen(string));
+        }
+            break;
+        case TORAExpressionTypeBoolean:
+            return new_boolean_expression(flat_node->val != 0);
+            break;
+        default:
+            break;
+    }
+    
+    TORA_RUNTIME_EXCEPTION("Unable to rebuild literal of type: %i", flat_node->type);
+    return NULL;
 }
-bool parser_is_punctuation(TORATokenStream *token_stream, char *cmp)
+// Each of these checks the next token's type and, unless TORATokenKindNone is
+// passed to accept anything of that type, its kind
+bool parser_is_punctuation(TORATokenStream *token_stream, TORATokenKind kind)
 {
     assert(token_stream);
     
     TORAToken *token = token_stream_peek(token_stream);
-    return (token && token->type == TORATokenTypePunctuation && (!cmp || strcmp((char *)token->val, cmp) == 0));
+    return (token && token->type == TORATokenTypePunctuation && (kind == TORATokenKindNone || token->kind == kind));
 }
-void parser_skip_punctuation(TORATokenStream *token_stream, char *cmp)
+void parser_skip_punctuation(TORATokenStream *token_stream, TORATokenKind kind)
 {
-    if(parser_is_punctuation(token_stream, cmp))
+    if(parser_is_punctuation(token_stream, kind))
     {
         token_stream_next(token_stream);
     }
     else
     {
         //TORAToken *token = token_stream_peek(token_stream);
-        //TORA_PARSER_EXCEPTION("runtime", (int)token_stream->input_stream->line, "Expecting punctuation: %s, found: %s", cmp, token->val);
+        //TORA_PARSER_EXCEPTION("runtime", (int)token_stream->input_stream->line, "Expecting punctuation: %s, found: %s", tora_token_kind_text[kind], token->val);
     }
 }
-bool parser_is_keyword(TORATokenStream *token_stream, char *cmp)
+bool parser_is_keyword(TORATokenStream *token_stream, TORATokenKind kind)
 {
     TORAToken *token = token_stream_peek(token_stream);
-    return (token && token->type == TORATokenTypeKeyword && (!cmp || strcmp((char *)token->val, cmp) == 0));
+    return (token && token->type == TORATokenTypeKeyword && (kind == TORATokenKindNone || token->kind == kind));
 }
-void parser_skip_keyword(TORATokenStream *token_stream, char *cmp)
+void parser_skip_keyword(TORATokenStream *token_stream, TORATokenKind kind)
 {
-    if(parser_is_keyword(token_stream, cmp))
+    if(parser_is_keyword(token_stream, kind))
     {
         token_stream_next(token_stream);
     }
     else
     {
         TORAToken *token = token_stream_peek(token_stream);
-        TORA_PARSER_EXCEPTION(token_stream->input_stream->line,
-                              token_stream->input_stream->col,
-                              "Expecting keyword: %s, found: %s", cmp, token->val);
+        TORA_PARSER_EXCEPTION(token->line,
+                              token->col,
+                              "Expecting keyword: %s, found: %.*s", tora_token_kind_text[kind], (int)token->length, token_chars(token_stream, token));
     }
 }
-bool parser_is_operator(TORATokenStream *token_stream, char *cmp)
+bool parser_is_operator(TORATokenStream *token_stream, TORATokenKind kind)
 {
     TORAToken *token = token_stream_peek(token_stream);
-    return (token && token->type == TORATokenTypeOperation && (!cmp || strcmp((char *)token->val, cmp) == 0));
+    return (token && token->type == TORATokenTypeOperation && (kind == TORATokenKindNone || token->kind == kind));
 }
-void parser_skip_operator(TORATokenStream *token_stream, char *cmp)
+void parser_skip_operator(TORATokenStream *token_stream, TORATokenKind kind)
 {
-    if(parser_is_operator(token_stream, cmp))
+    if(parser_is_operator(token_stream, kind))
     {
         token_stream_next(token_stream);
     }
     else
     {
         TORAToken *token = token_stream_peek(token_stream);
-        TORA_PARSER_EXCEPTION(token_stream->input_stream->line,
-                              token_stream->input_stream->col,
-                              "Expecting operator: %s, found: %s", cmp, token->val);
+        TORA_PARSER_EXCEPTION(token->line,
+                              token->col,
+                              "Expecting operator: %s, found: %.*s", tora_token_kind_text[kind], (int)token->length, token_chars(token_stream, token));
     }
 }
 
 // Helpers
-TORAParserProgExpression *new_prog_expression(TORALinkedList *list)
+TORAParserProgExpression *new_prog_expression(TORAParserExpressionList *list)
 {
-    TORAParserProgExpression *expression = tora_malloc(sizeof(TORAParserProgExpression));
+    TORAParserProgExpression *expression = parser_new_instance(sizeof(TORAParserProgExpression), TORAExpressionTypeProg);
     if(!expression)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for prog expression");
     }
-    expression->instance_type = TORAInstanceTypeExpression;
-    expression->ref_count = 0;
-    expression->type = TORAExpressionTypeProg;
-    expression->val = tora_retain(list);
+    expression->val = list;
     
     return expression;
 }
 TORAParserArrayExpression *new_array_expression(TORALinkedList *list)
 {
-    TORAParserArrayExpression *expression = tora_malloc(sizeof(TORAParserArrayExpression));
+    TORAParserArrayExpression *expression = parser_new_instance(sizeof(TORAParserArrayExpression), TORAExpressionTypeArray);
     if(!expression)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for array expression");
     }
-    expression->instance_type = TORAInstanceTypeExpression;
-    expression->ref_count = 0;
-    expression->type = TORAExpressionTypeArray;
     expression->val = NULL;
+    expression->items = NULL;
     if(list)
     {
         expression->val = tora_retain(list);
@@ -578,70 +801,103 @@ TORAParserArrayExpression *new_array_expression(TORALinkedList *list)
     
     return expression;
 }
+TORAParserArrayExpression *new_array_literal_expression(TORAParserExpressionList *items)
+{
+    assert(items);
+    
+    TORAParserArrayExpression *expression = parser_new_instance(sizeof(TORAParserArrayExpression), TORAExpressionTypeArray);
+    if(!expression)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for array expression");
+    }
+    expression->val = NULL;
+    expression->items = items;
+    
+    return expression;
+}
 TORAParserArrayIndexExpression *new_array_index_expression(void *index, void *array)
 {
-    TORAParserArrayIndexExpression *expression = tora_malloc(sizeof(TORAParserArrayIndexExpression));
+    TORAParserArrayIndexExpression *expression = parser_new_instance(sizeof(TORAParserArrayIndexExpression), TORAExpressionTypeArrayIndex);
     if(!expression)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for array index expression");
     }
-    expression->instance_type = TORAInstanceTypeExpression;
-    expression->ref_count = 0;
     
-    expression->type = TORAExpressionTypeArrayIndex;
     expression->index = tora_retain(index);
     expression->array = tora_retain(array);
     
     return expression;
 }
-TORAParserLambdaExpression *new_function_expression(char *name, void *body, TORALinkedList *arguments)
+// body is NULL for a function whose body was skipped, in which case the caller records
+// where to find it
+TORAParserLambdaExpression *new_function_expression(char *name, void *body, TORAParserExpressionList *arguments)
 {
-    assert(body);
-    
-    TORAParserLambdaExpression *expression = tora_malloc(sizeof(TORAParserLambdaExpression));
+    TORAParserLambdaExpression *expression = parser_new_instance(sizeof(TORAParserLambdaExpression), TORAExpressionTypeLambda);
     if(!expression)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for function expression");
     }
-    expression->instance_type = TORAInstanceTypeExpression;
-    expression->type = TORAExpressionTypeLambda;
-    expression->ref_count = 0;
-    expression->arguments = tora_retain(arguments);
+    expression->arguments = arguments;
     expression->body = tora_retain(body);
-    expression->name = tora_strcpy(name);
+    expression->name = name ? parser_strncpy(name, strlen(name)) : NULL;
+    expression->first_token = 0;
+    expression->num_tokens = 0;
+    expression->num_constants = 0;
     
     return expression;
 }
-TORAParserCallExpression *new_call_expression(void *func, TORALinkedList *arguments)
+TORAParserCallExpression *new_call_expression(void *func, TORAParserExpressionList *arguments)
 {
     assert(func);
     
-    TORAParserCallExpression *expression = tora_malloc(sizeof(TORAParserCallExpression));
+    TORAParserCallExpression *expression = parser_new_instance(sizeof(TORAParserCallExpression), TORAExpressionTypeCall);
     if(!expression)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for call expression");
     }
-    expression->instance_type = TORAInstanceTypeExpression;
-    expression->type = TORAExpressionTypeCall;
-    expression->ref_count = 0;
-    expression->arguments = tora_retain(arguments);
+    expression->arguments = arguments;
     expression->func = tora_retain(func);
     
     return expression;
 }
+TORAParserBuiltinCallExpression *new_builtin_call_expression(const TORABuiltin *builtin, TORAParserExpressionList *arguments)
+{
+    assert(builtin);
+    assert(arguments);
+    
+    TORAParserBuiltinCallExpression *expression = parser_new_instance(sizeof(TORAParserBuiltinCallExpression), TORAExpressionTypeBuiltinCall);
+    if(!expression)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for builtin call expression");
+    }
+    expression->builtin = builtin;
+    expression->arguments = arguments;
+    
+    return expression;
+}
+TORAParserConcatExpression *new_concat_expression(TORAParserExpressionList *pieces)
+{
+    assert(pieces);
+    
+    TORAParserConcatExpression *expression = parser_new_instance(sizeof(TORAParserConcatExpression), TORAExpressionTypeConcat);
+    if(!expression)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for concat expression");
+    }
+    expression->pieces = pieces;
+    
+    return expression;
+}
 TORAParserWhileExpression *new_while_expression(void *condition, void *body)
 {
     assert(condition);
     assert(body);
     
-    TORAParserWhileExpression *expression = tora_malloc(sizeof(TORAParserWhileExpression));
+    TORAParserWhileExpression *expression = parser_new_instance(sizeof(TORAParserWhileExpression), TORAExpressionTypeWhile);
     if(!expression)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for while expression");
     }
-    expression->instance_type = TORAInstanceTypeExpression;
-    expression->type = TORAExpressionTypeWhile;
-    expression->ref_count = 0;
     expression->condition = tora_retain(condition);
     expression->body = tora_retain(body);
     
@@ -652,14 +908,11 @@ TORAParserIfThenElseExpression *new_if_expression(void *condition, void *then, v
     assert(condition);
     assert(then);
     
-    TORAParserIfThenElseExpression *expression = tora_malloc(sizeof(TORAParserIfThenElseExpression));
+    TORAParserIfThenElseExpression *expression = parser_new_instance(sizeof(TORAParserIfThenElseExpression), TORAExpressionTypeIfThenElse);
     if(!expression)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for if/then/else expression");
     }
-    expression->instance_type = TORAInstanceTypeExpression;
-    expression->type = TORAExpressionTypeIfThenElse;
-    expression->ref_count = 0;
     expression->condition = tora_retain(condition);
     expression->el = tora_retain(el);
     expression->then = tora_retain(then);
@@ -672,15 +925,12 @@ TORAParserAssignOrBinaryExpression *new_assign_expression(char *op, void *left,
     assert(left);
     assert(right);
     
-    TORAParserAssignOrBinaryExpression *expression = tora_malloc(sizeof(TORAParserAssignOrBinaryExpression));
+    TORAParserAssignOrBinaryExpression *expression = parser_new_instance(sizeof(TORAParserAssignOrBinaryExpression), TORAExpressionTypeAssign);
     if(!expression)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for assignment expression");
     }
-    expression->instance_type = TORAInstanceTypeExpression;
-    expression->type = TORAExpressionTypeAssign;
-    expression->ref_count = 0;
-    expression->op = tora_strcpy(op);
+    expression->op = parser_strncpy(op, strlen(op));
     expression->left = tora_retain(left);
     expression->right = tora_retain(right);
     
@@ -692,15 +942,12 @@ TORAParserAssignOrBinaryExpression *new_binary_expression(char *op, void *left,
     assert(left);
     assert(right);
     
-    TORAParserAssignOrBinaryExpression *expression = tora_malloc(sizeof(TORAParserAssignOrBinaryExpression));
+    TORAParserAssignOrBinaryExpression *expression = parser_new_instance(sizeof(TORAParserAssignOrBinaryExpression), TORAExpressionTypeBinary);
     if(!expression)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for binary expression");
     }
-    expression->instance_type = TORAInstanceTypeExpression;
-    expression->type = TORAExpressionTypeBinary;
-    expression->ref_count = 0;
-    expression->op = tora_strcpy(op);
+    expression->op = parser_strncpy(op, strlen(op));
     expression->left = tora_retain(left);
     expression->right = tora_retain(right);
     
@@ -708,80 +955,87 @@ TORAParserAssignOrBinaryExpression *new_binary_expression(char *op, void *left,
 }
 TORAParserNegativeUnaryExpression *new_negative_unary_expression(void *expression_to_negate)
 {
-    TORAParserNegativeUnaryExpression *expression = tora_malloc(sizeof(TORAParserNegativeUnaryExpression));
+    TORAParserNegativeUnaryExpression *expression = parser_new_instance(sizeof(TORAParserNegativeUnaryExpression), TORAExpressionTypeNegativeUnary);
     if(!expression)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for negative unary expression");
     }
-    expression->instance_type = TORAInstanceTypeExpression;
-    expression->type = TORAExpressionTypeNegativeUnary;
-    expression->ref_count = 0;
     expression->expression = tora_retain(expression_to_negate);
     
     return expression;
 }
 TORAParserStringExpression *new_string_expression(char *val)
 {
-    TORAParserStringExpression *expression = tora_malloc(sizeof(TORAParserStringExpression));
+    return new_string_expression_with_length(val, strlen(val));
+}
+TORAParserStringExpression *new_string_expression_with_length(const char *val, size_t length)
+{
+    TORAParserStringExpression *expression = parser_new_instance(sizeof(TORAParserStringExpression), TORAExpressionTypeString);
     if(!expression)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for string expression");
     }
-    expression->instance_type = TORAInstanceTypeExpression;
-    expression->type = TORAExpressionTypeString;
-    expression->ref_count = 0;
-    expression->val = tora_strcpy(val);
+    expression->val = parser_strncpy(val, length);
+    expression->hash = 0;
+    return expression;
+}
+// Takes ownership of val, which must have been allocated with tora_malloc, rather
+// than copying it
+TORAParserStringExpression *new_string_expression_with_buffer(char *val)
+{
+    assert(val);
+    assert(!parser_arena);
+    
+    TORAParserStringExpression *expression = parser_new_instance(sizeof(TORAParserStringExpression), TORAExpressionTypeString);
+    if(!expression)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for string expression");
+    }
+    expression->val = val;
+    expression->hash = 0;
     return expression;
 }
 TORAParserVariableExpression *new_variable_expression(char *val)
 {
-    TORAParserVariableExpression *expression = tora_malloc(sizeof(TORAParserVariableExpression));
+    return new_variable_expression_with_length(val, strlen(val));
+}
+TORAParserVariableExpression *new_variable_expression_with_length(const char *val, size_t length)
+{
+    TORAParserVariableExpression *expression = parser_new_instance(sizeof(TORAParserVariableExpression), TORAExpressionTypeVariable);
     if(!expression)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for variable expression");
     }
-    expression->instance_type = TORAInstanceTypeExpression;
-    expression->type = TORAExpressionTypeVariable;
-    expression->ref_count = 0;
-    expression->val = tora_strcpy(val);
+    expression->val = parser_strncpy(val, length);
     return expression;
 }
 TORAParserNumericExpression *new_numeric_expression(double val)
 {
-    TORAParserNumericExpression *expression = tora_malloc(sizeof(TORAParserNumericExpression));
+    TORAParserNumericExpression *expression = parser_new_instance(sizeof(TORAParserNumericExpression), TORAExpressionTypeNumeric);
     if(!expression)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for numeric expression");
     }
-    expression->instance_type = TORAInstanceTypeExpression;
-    expression->type = TORAExpressionTypeNumeric;
-    expression->ref_count = 0;
     expression->val = val;
     return expression;
 }
 TORAParserBoolExpression *new_boolean_expression(bool val)
 {
-    TORAParserBoolExpression *expression = tora_malloc(sizeof(TORAParserBoolExpression));
+    TORAParserBoolExpression *expression = parser_new_instance(sizeof(TORAParserBoolExpression), TORAExpressionTypeBoolean);
     if(!expression)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for boolean expression");
     }
-    expression->instance_type = TORAInstanceTypeExpression;
-    expression->type = TORAExpressionTypeBoolean;
-    expression->ref_count = 0;
     expression->val = val;
     return expression;
 }
 TORAParserReturnExpression *new_return_expression(void *val)
 {
-    TORAParserReturnExpression *expression = tora_malloc(sizeof(TORAParserReturnExpression));
+    TORAParserReturnExpression *expression = parser_new_instance(sizeof(TORAParserReturnExpression), TORAExpressionTypeReturn);
     if(!expression)
     {
         TORA_RUNTIME_EXCEPTION("Failed to malloc space for return expression");
     }
-    expression->instance_type = TORAInstanceTypeExpression;
-    expression->type = TORAExpressionTypeReturn;
-    expression->ref_count = 0;
     expression->expression = tora_retain(val);
     return expression;
 }
@@ -858,7 +1112,43 @@ void DEBUG_EXPRESSION(void *expression, int level)
             {
                 for(int i = 0; i < level+1; i++) printf("\t");
                 printf("args:\n");
-                DEBUG_LINKED_LIST(call_expression->arguments, level+1);
+                for(uint32_t i = 0; i < call_expression->arguments->length; i++)
+                {
+                    DEBUG_EXPRESSION(call_expression->arguments->items[i], level+1);
+                }
+            }
+        }
+            break;
+        case TORAExpressionTypeBuiltinCall:
+        {
+            TORAParserBuiltinCallExpression *call_expression = (TORAParserBuiltinCallExpression *)unknown_expression;
+            
+            for(int i = 0; i < level+1; i++) printf("\t");
+            printf("type: builtin call\n");
+            
+            for(int i = 0; i < level+1; i++) printf("\t");
+            printf("builtin: %s\n", call_expression->builtin->name);
+            
+            for(int i = 0; i < level+1; i++) printf("\t");
+            printf("args:\n");
+            for(uint32_t i = 0; i < call_expression->arguments->length; i++)
+            {
+                DEBUG_EXPRESSION(call_expression->arguments->items[i], level+1);
+            }
+        }
+            break;
+        case TORAExpressionTypeConcat:
+        {
+            TORAParserConcatExpression *concat_expression = (TORAParserConcatExpression *)unknown_expression;
+            
+            for(int i = 0; i < level+1; i++) printf("\t");
+            printf("type: concat\n");
+            
+            for(int i = 0; i < level+1; i++) printf("\t");
+            printf("pieces:\n");
+            for(uint32_t i = 0; i < concat_expression->pieces->length; i++)
+            {
+                DEBUG_EXPRESSION(concat_expression->pieces->items[i], level+1);
             }
         }
             break;
@@ -924,12 +1214,9 @@ void DEBUG_EXPRESSION(void *expression, int level)
             
             for(int i = 0; i < level+1; i++) printf("\t");
             printf("arguments: \n");
-            TORALinkedList *prog_expression_list = function_expression->arguments;
-            while(prog_expression_list)
+            for(uint32_t i = 0; i < function_expression->arguments->length; i++)
             {
-                printf("%s", prog_expression_list->value);
-                DEBUG_EXPRESSION(prog_expression_list->value, level+1);
-                prog_expression_list = prog_expression_list->next;
+                DEBUG_EXPRESSION(function_expression->arguments->items[i], level+1);
             }
         }
             break;
@@ -939,11 +1226,9 @@ void DEBUG_EXPRESSION(void *expression, int level)
             printf("type: prog\n");
             
             TORAParserProgExpression *prog_expression = (TORAParserProgExpression *)expression;
-            TORALinkedList *prog_expression_list = prog_expression->val;
-            while(prog_expression_list)
+            for(uint32_t i = 0; i < prog_expression->val->length; i++)
             {
-                DEBUG_EXPRESSION(prog_expression_list->value, level+1);
-                prog_expression_list = prog_expression_list->next;
+                DEBUG_EXPRESSION(prog_expression->val->items[i], level+1);
             }
             printf("\n}");
         }
@@ -977,6 +1262,14 @@ void DEBUG_EXPRESSION(void *expression, int level)
                 }
                 printf("\n}");
             }
+            else if(prog_expression->items)
+            {
+                for(uint32_t i = 0; i < prog_expression->items->length; i++)
+                {
+                    DEBUG_EXPRESSION(prog_expression->items->items[i], level+1);
+                }
+                printf("\n}");
+            }
         }
             break;
         case TORAExpressionTypeArrayIndex:
@@ -992,7 +1285,7 @@ void DEBUG_EXPRESSION(void *expression, int level)
             for(int i = 0; i < level+1; i++) printf("\t");
             printf("key:\n");
             DEBUG_EXPRESSION(index_expression->index, level+1);
-            
+        
         }
             break;
         case TORAExpressionTypeNegativeUnary:
@@ -1035,6 +1328,12 @@ void DEBUG_EXPRESSION(void *expression, int level)
             printf("val: %f\n", numeric_expression->val);
         }
             break;
+        case TORAExpressionTypeFunction:
+        {
+            for(int i = 0; i < level+1; i++) printf("\t");
+            printf("type: function\n");
+        }
+            break;
     }
     
     for(int i = 0; i < level; i++) printf("\t");
@@ -27,7 +27,12 @@ typedef enum {
     TORAExpressionTypeArray,
     TORAExpressionTypeArrayIndex,
     TORAExpressionTypeNegativeUnary,
-    TORAExpressionTypeReturn
+    TORAExpressionTypeReturn,
+    TORAExpressionTypeBuiltinCall,
+    TORAExpressionTypeConcat,
+    
+    // Functions as values, produced by evaluating a lambda
+    TORAExpressionTypeFunction
 } TORAExpressionType;
 
 typedef struct {
@@ -37,6 +42,15 @@ typedef struct {
     TORAExpressionType type;
 } TORAParserUnknownExpression;
 
+// Progs, calls, lambdas and array literals keep their children in one of these,
+// built once the parser knows how many there are. Array literals store each of
+// their keys followed by its value, so hold two items for every entry
+typedef struct
+{
+    uint32_t length;
+    void *items[];
+} TORAParserExpressionList;
+
 typedef struct
 {
     TORAInstanceType instance_type;
@@ -44,6 +58,11 @@ typedef struct
     
     TORAExpressionType type;
     char *val;
+    
+    // Worked out the first time the string's compared as an array key (see
+    // string_expression_hash), and 0 until then. The values a program hands out
+    // for its literals have theirs worked out up front
+    uint32_t hash;
 } TORAParserStringExpression;
 
 typedef struct
@@ -79,9 +98,11 @@ typedef struct
     int ref_count;
     
     TORAExpressionType type;
-    TORALinkedList *val;
+    TORAParserExpressionList *val;
 } TORAParserProgExpression;
 
+// Array literals hold their keys and values in items, while arrays created
+// during evaluation can grow, so keep theirs in a linked list in val
 typedef struct
 {
     TORAInstanceType instance_type;
@@ -89,6 +110,7 @@ typedef struct
     
     TORAExpressionType type;
     TORALinkedList *val;
+    TORAParserExpressionList *items;
 } TORAParserArrayExpression;
 
 typedef struct
@@ -140,7 +162,7 @@ typedef struct
     
     TORAExpressionType type;
     void *func;
-    TORALinkedList *arguments;
+    TORAParserExpressionList *arguments;
 } TORAParserCallExpression;
 
 typedef struct
@@ -149,11 +171,43 @@ typedef struct
     int ref_count;
     
     TORAExpressionType type;
-    TORALinkedList *arguments;
+    TORAParserExpressionList *arguments;
     char *name;
     void *body;
+    
+    // A function whose body was skipped over rather than parsed has no body, and
+    // instead records the range of tokens holding it. num_constants is how many of
+    // the program's constants had been assigned by the time it was defined
+    uint32_t first_token;
+    uint32_t num_tokens;
+    uint32_t num_constants;
 } TORAParserLambdaExpression;
 
+// Defined in builtins.h
+typedef struct TORABuiltin TORABuiltin;
+
+// A call the optimiser has resolved to one of the standard library's builtins
+typedef struct
+{
+    TORAInstanceType instance_type;
+    int ref_count;
+    
+    TORAExpressionType type;
+    const TORABuiltin *builtin;
+    TORAParserExpressionList *arguments;
+} TORAParserBuiltinCallExpression;
+
+// A run of + the optimiser has found can only build a string, with each of its
+// pieces in order. Every piece is converted to a string as + would have
+typedef struct
+{
+    TORAInstanceType instance_type;
+    int ref_count;
+    
+    TORAExpressionType type;
+    TORAParserExpressionList *pieces;
+} TORAParserConcatExpression;
+
 typedef struct
 {
     TORAInstanceType instance_type;
@@ -172,23 +226,40 @@ typedef struct
     void *expression;
 } TORAParserReturnExpression;
 
-TORAParserProgExpression *parse_top_level(TORATokenStream *token_stream);
+// Defined in flat.h
+typedef struct TORAFlatProgram TORAFlatProgram;
+
+// When set, new nodes are allocated from this arena rather than malloc'd
+extern TORAArena *parser_arena;
+
+TORAParserProgExpression *parse_top_level(TORATokenStream *token_stream, TORAArena *arena, bool lazy_functions);
+TORAFlatProgram *parse_program(TORATokenStream *token_stream, bool lazy_functions);
+void parse_function_body(TORAFlatProgram *program, uint32_t function);
+bool parse_function_bodies(TORAFlatProgram *program);
 void DEBUG_EXPRESSION(void *expression, int level);
 
 TORAParserNumericExpression *new_numeric_expression(double val);
 TORAParserBoolExpression *new_boolean_expression(bool val);
-TORAParserProgExpression *new_prog_expression(TORALinkedList *list);
+TORAParserProgExpression *new_prog_expression(TORAParserExpressionList *list);
 TORAParserArrayExpression *new_array_expression(TORALinkedList *list);
+TORAParserArrayExpression *new_array_literal_expression(TORAParserExpressionList *items);
 TORAParserArrayIndexExpression *new_array_index_expression(void *index, void *val);
-TORAParserLambdaExpression *new_function_expression(char *name, void *body, TORALinkedList *arguments);
-TORAParserCallExpression *new_call_expression(void *func, TORALinkedList *arguments);
+TORAParserLambdaExpression *new_function_expression(char *name, void *body, TORAParserExpressionList *arguments);
+TORAParserCallExpression *new_call_expression(void *func, TORAParserExpressionList *arguments);
+TORAParserBuiltinCallExpression *new_builtin_call_expression(const TORABuiltin *builtin, TORAParserExpressionList *arguments);
+TORAParserConcatExpression *new_concat_expression(TORAParserExpressionList *pieces);
 TORAParserWhileExpression *new_while_expression(void *condition, void *body);
 TORAParserIfThenElseExpression *new_if_expression(void *condition, void *then, void *el);
 TORAParserAssignOrBinaryExpression *new_assign_expression(char *op, void *left, void *right);
 TORAParserAssignOrBinaryExpression *new_binary_expression(char *op, void *left, void *right);
 TORAParserNegativeUnaryExpression *new_negative_unary_expression(void *expression_to_negate);
 TORAParserStringExpression *new_string_expression(char *val);
+TORAParserStringExpression *new_string_expression_with_length(const char *val, size_t length);
+TORAParserStringExpression *new_string_expression_with_buffer(char *val);
 TORAParserVariableExpression *new_variable_expression(char *val);
+TORAParserVariableExpression *new_variable_expression_with_length(const char *val, size_t length);
 TORAParserReturnExpression *new_return_expression(void *val);
 
+void free_expression_list(TORAParserExpressionList *list);
+
 #endif /* defined(__tora__parser__) */
@@ -0,0 +1,352 @@
+//
+//  resolver.c
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "tora.h"
+
+typedef struct {
+    uint32_t name;
+    uint32_t level;
+    uint32_t slot;
+} TORAResolverBinding;
+
+// Scopes nest the same way their environments do at runtime: a function's
+// environment has the one it was defined in as its parent, so a variable's found
+// by walking out from its own scope until reaching one that binds its name
+struct TORAResolver {
+    TORAFlatProgram *program;
+    
+    // The innermost scope binding each name, and its slot there. The program's
+    // strings are interned, so names are compared (and these indexed) by string
+    // index. The top level is level 1, and each function one deeper than the scope
+    // it's defined in
+    uint32_t num_strings;
+    uint32_t *name_levels;
+    uint32_t *name_slots;
+    uint32_t level;
+    
+    // Names bound by the scopes currently being resolved, innermost last, along
+    // with the binding each of them shadows
+    TORAResolverBinding *bindings;
+    uint32_t num_bindings;
+    uint32_t bindings_capacity;
+    uint32_t scope_start;
+    
+    // Each scope's run of names is gathered here until the walk's done, as adding
+    // children part way through would move the nodes' child ranges from under us
+    uint32_t *names;
+    uint32_t num_names;
+    uint32_t names_capacity;
+    
+    // Set when a function's body has yet to be parsed
+    bool deferred;
+};
+
+// Names
+void resolver_add_strings(TORAResolver *resolver);
+uint32_t resolver_move_names(TORAResolver *resolver);
+void *resolver_grow(void *buffer, uint32_t *capacity, uint32_t needed, size_t item_size);
+
+// Scopes
+uint32_t resolver_resolve_scope(TORAResolver *resolver, uint32_t parameters, TORAFlatIndex body);
+uint32_t resolver_add_scope_names(TORAResolver *resolver);
+uint32_t resolver_bind(TORAResolver *resolver, uint32_t name);
+void resolver_bind_scope(TORAResolver *resolver, TORAFlatIndex node);
+void resolver_resolve_node(TORAResolver *resolver, TORAFlatIndex node);
+
+void resolve_program(TORAFlatProgram *program)
+{
+    assert(program);
+    
+    TORAResolver *resolver = tora_malloc(sizeof(TORAResolver));
+    if(!resolver)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for resolver");
+    }
+    memset(resolver, 0, sizeof(TORAResolver));
+    resolver->program = program;
+    resolver_add_strings(resolver);
+    
+    // The top level's scope is left open once it's been resolved, for any function
+    // that's parsed later on. Resolving it reaches every other function through
+    // its definition
+    resolver->level = 1;
+    resolver_bind_scope(resolver, program->root);
+    resolver_resolve_node(resolver, program->root);
+    uint32_t globals = resolver_add_scope_names(resolver);
+    
+    uint32_t base = resolver_move_names(resolver);
+    program->globals = base + globals;
+    for(uint32_t i = 0; i < program->num_functions; i++)
+    {
+        if(program->functions[i].names != TORA_FLAT_NONE)
+        {
+            program->functions[i].names += base;
+        }
+    }
+    
+    if(resolver->deferred)
+    {
+        program->resolver = resolver;
+    }
+    else
+    {
+        free_resolver(resolver);
+    }
+}
+void resolve_function(TORAFlatProgram *program, uint32_t function, uint32_t first_function)
+{
+    TORAResolver *resolver = program->resolver;
+    assert(resolver && resolver->level == 1);
+    
+    resolver_add_strings(resolver);
+    uint32_t names = resolver_resolve_scope(resolver, program->functions[function].parameters, program->functions[function].body);
+    
+    uint32_t base = resolver_move_names(resolver);
+    program->functions[function].names = base + names;
+    for(uint32_t i = first_function; i < program->num_functions; i++)
+    {
+        if(program->functions[i].names != TORA_FLAT_NONE)
+        {
+            program->functions[i].names += base;
+        }
+    }
+}
+void free_resolver(TORAResolver *resolver)
+{
+    if(resolver->name_levels) tora_free(resolver->name_levels);
+    if(resolver->name_slots) tora_free(resolver->name_slots);
+    if(resolver->bindings) tora_free(resolver->bindings);
+    if(resolver->names) tora_free(resolver->names);
+    tora_free(resolver);
+}
+
+// Names
+// Makes room for any strings added to the program since we last looked
+void resolver_add_strings(TORAResolver *resolver)
+{
+    uint32_t num_strings = resolver->program->num_strings;
+    resolver->name_levels = resolver_grow(resolver->name_levels, NULL, num_strings, sizeof(uint32_t));
+    resolver->name_slots = resolver_grow(resolver->name_slots, NULL, num_strings, sizeof(uint32_t));
+    for(uint32_t i = resolver->num_strings; i < num_strings; i++)
+    {
+        resolver->name_levels[i] = TORA_FLAT_NONE;
+        resolver->name_slots[i] = TORA_FLAT_NONE;
+    }
+    resolver->num_strings = num_strings;
+}
+// Moves the runs of names gathered by the last walk into the program, returning
+// the offset their own offsets are relative to
+uint32_t resolver_move_names(TORAResolver *resolver)
+{
+    TORAFlatProgram *program = resolver->program;
+    uint32_t base = flat_program_add_children(program, resolver->num_names);
+    memcpy(program->children + base, resolver->names, resolver->num_names * sizeof(uint32_t));
+    resolver->num_names = 0;
+    
+    return base;
+}
+// Grows a buffer to hold at least needed items. Buffers that don't keep their
+// capacity (passing NULL) are sized exactly
+void *resolver_grow(void *buffer, uint32_t *capacity, uint32_t needed, size_t item_size)
+{
+    uint32_t new_capacity = needed > 0 ? needed : 1;
+    if(capacity)
+    {
+        if(needed <= *capacity) return buffer;
+        
+        new_capacity = *capacity ? *capacity : 64;
+        while(new_capacity < needed)
+        {
+            new_capacity *= 2;
+        }
+        *capacity = new_capacity;
+    }
+    
+    void *new_buffer = buffer ? realloc(buffer, new_capacity * item_size) : tora_malloc(new_capacity * item_size);
+    if(!new_buffer)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for resolver");
+    }
+    return new_buffer;
+}
+
+// Scopes
+// Resolves a scope, which binds its parameters (if it has any) and everything its
+// body assigns to, and returns the offset of its run of names
+uint32_t resolver_resolve_scope(TORAResolver *resolver, uint32_t parameters, TORAFlatIndex body)
+{
+    TORAFlatProgram *program = resolver->program;
+    uint32_t outer_scope_start = resolver->scope_start;
+    resolver->scope_start = resolver->num_bindings;
+    resolver->level++;
+    
+    // Parameters take a function's first slots, and are replaced by those slots
+    if(parameters != TORA_FLAT_NONE)
+    {
+        uint32_t num_parameters = program->children[parameters];
+        for(uint32_t i = 0; i < num_parameters; i++)
+        {
+            uint32_t slot = resolver_bind(resolver, program->children[parameters + 1 + i]);
+            program->children[parameters + 1 + i] = slot;
+        }
+    }
+    resolver_bind_scope(resolver, body);
+    resolver_resolve_node(resolver, body);
+    uint32_t names = resolver_add_scope_names(resolver);
+    
+    // Restore whatever our names shadowed
+    for(uint32_t i = resolver->num_bindings; i-- > resolver->scope_start;)
+    {
+        TORAResolverBinding *binding = &resolver->bindings[i];
+        resolver->name_levels[binding->name] = binding->level;
+        resolver->name_slots[binding->name] = binding->slot;
+    }
+    resolver->num_bindings = resolver->scope_start;
+    resolver->scope_start = outer_scope_start;
+    resolver->level--;
+    
+    return names;
+}
+// Gathers the current scope's run of names, and returns its offset. Nested scopes
+// have popped their bindings by now, leaving only our own
+uint32_t resolver_add_scope_names(TORAResolver *resolver)
+{
+    uint32_t num_scope_names = resolver->num_bindings - resolver->scope_start;
+    resolver->names = resolver_grow(resolver->names, &resolver->names_capacity, resolver->num_names + num_scope_names + 1, sizeof(uint32_t));
+    
+    uint32_t names = resolver->num_names;
+    resolver->names[resolver->num_names++] = num_scope_names;
+    for(uint32_t i = 0; i < num_scope_names; i++)
+    {
+        resolver->names[resolver->num_names++] = resolver->bindings[resolver->scope_start + i].name;
+    }
+    
+    return names;
+}
+// Binds a name in the current scope, and returns its slot
+uint32_t resolver_bind(TORAResolver *resolver, uint32_t name)
+{
+    if(resolver->name_levels[name] == resolver->level)
+    {
+        return resolver->name_slots[name];
+    }
+    
+    resolver->bindings = resolver_grow(resolver->bindings, &resolver->bindings_capacity, resolver->num_bindings + 1, sizeof(TORAResolverBinding));
+    
+    TORAResolverBinding *binding = &resolver->bindings[resolver->num_bindings++];
+    binding->name = name;
+    binding->level = resolver->name_levels[name];
+    binding->slot = resolver->name_slots[name];
+    
+    uint32_t slot = resolver->num_bindings - 1 - resolver->scope_start;
+    resolver->name_levels[name] = resolver->level;
+    resolver->name_slots[name] = slot;
+    return slot;
+}
+// Binds everything a scope assigns to, or defines a function as, without entering the
+// bodies of any functions within it
+void resolver_bind_scope(TORAResolver *resolver, TORAFlatIndex node)
+{
+    TORAFlatProgram *program = resolver->program;
+    TORAFlatNode *flat_node = &program->nodes[node];
+    if(flat_node->type == TORAExpressionTypeLambda)
+    {
+        TORAFlatFunction *function = &program->functions[flat_node->val];
+        if(function->name != TORA_FLAT_NONE)
+        {
+            resolver_bind(resolver, function->name);
+        }
+        return;
+    }
+    else if(flat_node->type == TORAExpressionTypeAssign)
+    {
+        // Assigning to an array's index rebinds the array's name too
+        TORAFlatIndex left = program->children[flat_node->val];
+        if(program->nodes[left].type == TORAExpressionTypeArrayIndex)
+        {
+            left = program->children[program->nodes[left].val];
+        }
+        if(program->nodes[left].type == TORAExpressionTypeVariable)
+        {
+            resolver_bind(resolver, program->nodes[left].val);
+        }
+    }
+    
+    uint32_t num_children = 0;
+    uint32_t *children = flat_program_node_children(program, node, &num_children);
+    for(uint32_t i = 0; i < num_children; i++)
+    {
+        resolver_bind_scope(resolver, children[i]);
+    }
+}
+void resolver_resolve_node(TORAResolver *resolver, TORAFlatIndex node)
+{
+    TORAFlatProgram *program = resolver->program;
+    TORAFlatNode *flat_node = &program->nodes[node];
+    if(flat_node->type == TORAExpressionTypeVariable)
+    {
+        uint32_t name = flat_node->val;
+        uint32_t level = resolver->name_levels[name];
+        if(level == TORA_FLAT_NONE)
+        {
+            flat_node->op = TORA_FLAT_SCOPE_UNRESOLVED;
+            flat_node->val = name;
+            return;
+        }
+        
+        if(level == resolver->level)
+        {
+            flat_node->op = 0;
+        }
+        else if(level == 1)
+        {
+            flat_node->op = TORA_FLAT_SCOPE_GLOBAL;
+        }
+        else if(resolver->level - level < TORA_FLAT_SCOPE_MAX_DEPTH)
+        {
+            flat_node->op = (uint8_t)(resolver->level - level);
+        }
+        else
+        {
+            TORA_RUNTIME_EXCEPTION("Functions are nested too deeply to resolve '%s'", flat_program_string(program, name));
+        }
+        flat_node->val = resolver->name_slots[name];
+        return;
+    }
+    else if(flat_node->type == TORAExpressionTypeLambda)
+    {
+        // A named function was bound in the scope it's defined in, before the
+        // function's own scope is resolved within it
+        uint32_t function = flat_node->val;
+        if(program->functions[function].name != TORA_FLAT_NONE)
+        {
+            program->functions[function].slot = resolver->name_slots[program->functions[function].name];
+        }
+        
+        // Bodies that haven't been parsed yet are resolved once they are
+        if(program->functions[function].body == TORA_FLAT_NONE)
+        {
+            resolver->deferred = true;
+            return;
+        }
+        
+        uint32_t names = resolver_resolve_scope(resolver, program->functions[function].parameters, program->functions[function].body);
+        program->functions[function].names = names;
+        return;
+    }
+    
+    uint32_t num_children = 0;
+    uint32_t *children = flat_program_node_children(program, node, &num_children);
+    for(uint32_t i = 0; i < num_children; i++)
+    {
+        resolver_resolve_node(resolver, children[i]);
+    }
+}
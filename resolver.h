@@ -0,0 +1,28 @@
+//
+//  resolver.h
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#ifndef resolver_h
+#define resolver_h
+
+#include <stdio.h>
+
+#include "flat.h"
+
+typedef struct TORAResolver TORAResolver;
+
+// Gives every scope in a flattened program its slots, and resolves each of its
+// variables to the slot holding it (see flat.h)
+void resolve_program(TORAFlatProgram *program);
+
+// Resolves a function whose body was parsed after the rest of its program, along
+// with any functions defined within it (from first_function on). The program's
+// top level stays open for these, so its resolver's kept until the program's freed
+void resolve_function(TORAFlatProgram *program, uint32_t function, uint32_t first_function);
+void free_resolver(TORAResolver *resolver);
+
+#endif /* resolver_h */
@@ -0,0 +1,291 @@
+//
+//  scanner.c
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#include <string.h>
+
+#include "tora.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define TORA_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+// Scalar kernels
+const char *scan_scalar_skip_whitespace(const char *start, const char *end);
+const char *scan_scalar_skip_ident(const char *start, const char *end);
+const char *scan_scalar_skip_digits(const char *start, const char *end);
+const char *scan_scalar_find_newline(const char *start, const char *end);
+const char *scan_scalar_find_quote_or_escape(const char *start, const char *end, char quote);
+uint64_t scan_scalar_count_newlines(const char *start, const char *end, const char **last_newline);
+
+TORAScanKernels tora_scan = {
+    "scalar",
+    scan_scalar_skip_whitespace,
+    scan_scalar_skip_ident,
+    scan_scalar_skip_digits,
+    scan_scalar_find_newline,
+    scan_scalar_find_quote_or_escape,
+    scan_scalar_count_newlines
+};
+
+const char *scan_scalar_skip_whitespace(const char *start, const char *end)
+{
+    while(start < end && TORA_CHAR_IS(*start, TORA_CHAR_WHITESPACE)) start++;
+    return start;
+}
+const char *scan_scalar_skip_ident(const char *start, const char *end)
+{
+    while(start < end && TORA_CHAR_IS(*start, TORA_CHAR_ID)) start++;
+    return start;
+}
+const char *scan_scalar_skip_digits(const char *start, const char *end)
+{
+    while(start < end && TORA_CHAR_IS(*start, TORA_CHAR_DIGIT)) start++;
+    return start;
+}
+const char *scan_scalar_find_newline(const char *start, const char *end)
+{
+    const char *newline = memchr(start, '\n', (size_t)(end - start));
+    return newline ? newline : end;
+}
+const char *scan_scalar_find_quote_or_escape(const char *start, const char *end, char quote)
+{
+    while(start < end && *start != quote && *start != '\\') start++;
+    return start;
+}
+uint64_t scan_scalar_count_newlines(const char *start, const char *end, const char **last_newline)
+{
+    uint64_t count = 0;
+    for(const char *cur = start; cur < end; cur++)
+    {
+        if(*cur == '\n')
+        {
+            count++;
+            *last_newline = cur;
+        }
+    }
+    return count;
+}
+
+#ifdef TORA_SCAN_X86
+
+// SSE2 kernels, 16 bytes at a time. Each kernel builds a mask of the bytes
+// that belong to the run, and stops at the first byte that doesn't
+#define TORA_SSE2 __attribute__((target("sse2")))
+
+TORA_SSE2 static inline __m128i sse2_in_range(__m128i chunk, char lo, char hi)
+{
+    // Signed compares are fine here as every bound is plain ASCII, and
+    // bytes >= 0x80 compare as negative so they never fall inside a range
+    return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8((char)(lo - 1))),
+                         _mm_cmpgt_epi8(_mm_set1_epi8((char)(hi + 1)), chunk));
+}
+TORA_SSE2 const char *scan_sse2_skip_whitespace(const char *start, const char *end)
+{
+    while(end - start >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)start);
+        __m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                                                  _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+                                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+        unsigned int stop = ~(unsigned int)_mm_movemask_epi8(match) & 0xFFFF;
+        if(stop) return start + __builtin_ctz(stop);
+        start += 16;
+    }
+    return scan_scalar_skip_whitespace(start, end);
+}
+TORA_SSE2 const char *scan_sse2_skip_ident(const char *start, const char *end)
+{
+    while(end - start >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)start);
+        __m128i alpha = sse2_in_range(_mm_or_si128(chunk, _mm_set1_epi8(0x20)), 'a', 'z');
+        __m128i match = _mm_or_si128(_mm_or_si128(alpha, sse2_in_range(chunk, '0', '9')),
+                                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_')));
+        unsigned int stop = ~(unsigned int)_mm_movemask_epi8(match) & 0xFFFF;
+        if(stop) return start + __builtin_ctz(stop);
+        start += 16;
+    }
+    return scan_scalar_skip_ident(start, end);
+}
+TORA_SSE2 const char *scan_sse2_skip_digits(const char *start, const char *end)
+{
+    while(end - start >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)start);
+        unsigned int stop = ~(unsigned int)_mm_movemask_epi8(sse2_in_range(chunk, '0', '9')) & 0xFFFF;
+        if(stop) return start + __builtin_ctz(stop);
+        start += 16;
+    }
+    return scan_scalar_skip_digits(start, end);
+}
+TORA_SSE2 const char *scan_sse2_find_newline(const char *start, const char *end)
+{
+    while(end - start >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)start);
+        unsigned int found = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+        if(found) return start + __builtin_ctz(found);
+        start += 16;
+    }
+    return scan_scalar_find_newline(start, end);
+}
+TORA_SSE2 const char *scan_sse2_find_quote_or_escape(const char *start, const char *end, char quote)
+{
+    while(end - start >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)start);
+        __m128i match = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(quote)),
+                                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')));
+        unsigned int found = (unsigned int)_mm_movemask_epi8(match);
+        if(found) return start + __builtin_ctz(found);
+        start += 16;
+    }
+    return scan_scalar_find_quote_or_escape(start, end, quote);
+}
+TORA_SSE2 uint64_t scan_sse2_count_newlines(const char *start, const char *end, const char **last_newline)
+{
+    uint64_t count = 0;
+    while(end - start >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)start);
+        unsigned int found = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+        if(found)
+        {
+            count += (uint64_t)__builtin_popcount(found);
+            *last_newline = start + (31 - __builtin_clz(found));
+        }
+        start += 16;
+    }
+    return count + scan_scalar_count_newlines(start, end, last_newline);
+}
+
+// AVX2 kernels, 32 bytes at a time. These mirror the SSE2 kernels above and
+// are compiled for AVX2 regardless of the global compiler flags, since they're
+// only ever selected after checking the CPU supports them
+#define TORA_AVX2 __attribute__((target("avx2")))
+
+TORA_AVX2 static inline __m256i avx2_in_range(__m256i chunk, char lo, char hi)
+{
+    return _mm256_and_si256(_mm256_cmpgt_epi8(chunk, _mm256_set1_epi8((char)(lo - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(hi + 1)), chunk));
+}
+TORA_AVX2 const char *scan_avx2_skip_whitespace(const char *start, const char *end)
+{
+    while(end - start >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)start);
+        __m256i match = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')),
+                                                        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))),
+                                        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')));
+        unsigned int stop = ~(unsigned int)_mm256_movemask_epi8(match);
+        if(stop) return start + __builtin_ctz(stop);
+        start += 32;
+    }
+    return scan_sse2_skip_whitespace(start, end);
+}
+TORA_AVX2 const char *scan_avx2_skip_ident(const char *start, const char *end)
+{
+    while(end - start >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)start);
+        __m256i alpha = avx2_in_range(_mm256_or_si256(chunk, _mm256_set1_epi8(0x20)), 'a', 'z');
+        __m256i match = _mm256_or_si256(_mm256_or_si256(alpha, avx2_in_range(chunk, '0', '9')),
+                                        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('_')));
+        unsigned int stop = ~(unsigned int)_mm256_movemask_epi8(match);
+        if(stop) return start + __builtin_ctz(stop);
+        start += 32;
+    }
+    return scan_sse2_skip_ident(start, end);
+}
+TORA_AVX2 const char *scan_avx2_skip_digits(const char *start, const char *end)
+{
+    while(end - start >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)start);
+        unsigned int stop = ~(unsigned int)_mm256_movemask_epi8(avx2_in_range(chunk, '0', '9'));
+        if(stop) return start + __builtin_ctz(stop);
+        start += 32;
+    }
+    return scan_sse2_skip_digits(start, end);
+}
+TORA_AVX2 const char *scan_avx2_find_newline(const char *start, const char *end)
+{
+    while(end - start >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)start);
+        unsigned int found = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')));
+        if(found) return start + __builtin_ctz(found);
+        start += 32;
+    }
+    return scan_sse2_find_newline(start, end);
+}
+TORA_AVX2 const char *scan_avx2_find_quote_or_escape(const char *start, const char *end, char quote)
+{
+    while(end - start >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)start);
+        __m256i match = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(quote)),
+                                        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\')));
+        unsigned int found = (unsigned int)_mm256_movemask_epi8(match);
+        if(found) return start + __builtin_ctz(found);
+        start += 32;
+    }
+    return scan_sse2_find_quote_or_escape(start, end, quote);
+}
+TORA_AVX2 uint64_t scan_avx2_count_newlines(const char *start, const char *end, const char **last_newline)
+{
+    uint64_t count = 0;
+    while(end - start >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)start);
+        unsigned int found = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')));
+        if(found)
+        {
+            count += (uint64_t)__builtin_popcount(found);
+            *last_newline = start + (31 - __builtin_clz(found));
+        }
+        start += 32;
+    }
+    return count + scan_sse2_count_newlines(start, end, last_newline);
+}
+
+#endif /* TORA_SCAN_X86 */
+
+void tora_scan_init(void)
+{
+#ifdef TORA_SCAN_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+    {
+        tora_scan = (TORAScanKernels) {
+            "avx2",
+            scan_avx2_skip_whitespace,
+            scan_avx2_skip_ident,
+            scan_avx2_skip_digits,
+            scan_avx2_find_newline,
+            scan_avx2_find_quote_or_escape,
+            scan_avx2_count_newlines
+        };
+        return;
+    }
+    if(__builtin_cpu_supports("sse2"))
+    {
+        tora_scan = (TORAScanKernels) {
+            "sse2",
+            scan_sse2_skip_whitespace,
+            scan_sse2_skip_ident,
+            scan_sse2_skip_digits,
+            scan_sse2_find_newline,
+            scan_sse2_find_quote_or_escape,
+            scan_sse2_count_newlines
+        };
+        return;
+    }
+#endif
+}
@@ -0,0 +1,33 @@
+//
+//  scanner.h
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#ifndef scanner_h
+#define scanner_h
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Scanning kernels used by the lexer to skip over runs of bytes. Each kernel
+// examines [start, end) and returns a pointer to the first byte that ends the
+// run, or end if the run reaches the end of the buffer. tora_scan_init picks
+// the widest implementation supported by the running CPU
+typedef struct {
+    const char *name;
+    const char *(*skip_whitespace)(const char *start, const char *end);
+    const char *(*skip_ident)(const char *start, const char *end);
+    const char *(*skip_digits)(const char *start, const char *end);
+    const char *(*find_newline)(const char *start, const char *end);
+    const char *(*find_quote_or_escape)(const char *start, const char *end, char quote);
+    uint64_t (*count_newlines)(const char *start, const char *end, const char **last_newline);
+} TORAScanKernels;
+
+extern TORAScanKernels tora_scan;
+
+void tora_scan_init(void);
+
+#endif /* scanner_h */
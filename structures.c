@@ -8,10 +8,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "structures.h"
-#include "token_stream.h"
 #include "interpretter.h"
 
 void tora_release_instance(TORAUnknownType *ptr);
@@ -37,7 +37,11 @@ void *tora_retain(void *ptr)
 {
     if(!ptr) return NULL;
     
-    ((TORAUnknownType *)ptr)->ref_count++;
+    TORAUnknownType *ref_ptr = (TORAUnknownType *)ptr;
+    if(ref_ptr->ref_count != TORA_REF_COUNT_IMMORTAL)
+    {
+        ref_ptr->ref_count++;
+    }
     return ptr;
 }
 void tora_release(void *ptr)
@@ -45,6 +49,7 @@ void tora_release(void *ptr)
     if(!ptr) return;
     
     TORAUnknownType *ref_ptr = (TORAUnknownType *)ptr;
+    if(ref_ptr->ref_count == TORA_REF_COUNT_IMMORTAL) return;
     //assert(ref_ptr->ref_count > 0);
     
     ref_ptr->ref_count--;
@@ -63,9 +68,6 @@ void tora_release_instance(TORAUnknownType *ptr)
         case TORAInstanceTypeExpression:
             free_expression(ptr);
             break;
-        case TORAInstanceTypeToken:
-            free_token((TORAToken *)ptr);
-            break;
         case TORAInstanceTypeGeneric:
             tora_free(ptr);
             break;
@@ -75,6 +77,84 @@ void tora_release_instance(TORAUnknownType *ptr)
     }
 }
 
+// Arenas
+TORAArena *arena_create(void)
+{
+    TORAArena *arena = tora_malloc(sizeof(TORAArena));
+    if(!arena)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for arena");
+    }
+    arena->blocks = NULL;
+    arena->bytes_allocated = 0;
+    
+    return arena;
+}
+void *arena_alloc(TORAArena *arena, size_t size)
+{
+    assert(arena);
+    
+    // Keep every allocation suitably aligned for the structures we store
+    size = (size + 15) & ~(size_t)15;
+    
+    TORAArenaBlock *block = arena->blocks;
+    if(!block || block->capacity - block->used < size)
+    {
+        // Oversized requests get a block to themselves, but are linked in behind
+        // the current block so that it can continue to be filled
+        size_t header = (sizeof(TORAArenaBlock) + 15) & ~(size_t)15;
+        bool oversized = size > TORA_ARENA_BLOCK_SIZE - header;
+        size_t capacity = oversized ? size : TORA_ARENA_BLOCK_SIZE - header;
+        
+        TORAArenaBlock *new_block = tora_malloc(header + capacity);
+        if(!new_block)
+        {
+            TORA_RUNTIME_EXCEPTION("Failed to malloc space for arena block");
+        }
+        new_block->used = header;
+        new_block->capacity = header + capacity;
+        
+        if(block && oversized)
+        {
+            new_block->next = block->next;
+            block->next = new_block;
+        }
+        else
+        {
+            new_block->next = block;
+            arena->blocks = new_block;
+        }
+        block = new_block;
+    }
+    
+    void *ptr = (char *)block + block->used;
+    block->used += size;
+    arena->bytes_allocated += size;
+    
+    return ptr;
+}
+char *arena_strncpy(TORAArena *arena, const char *str, size_t length)
+{
+    char *ret = arena_alloc(arena, length+1);
+    memcpy(ret, str, length);
+    ret[length] = '\0';
+    
+    return ret;
+}
+void free_arena(TORAArena *arena)
+{
+    if(!arena) return;
+    
+    TORAArenaBlock *block = arena->blocks;
+    while(block)
+    {
+        TORAArenaBlock *next = block->next;
+        tora_free(block);
+        block = next;
+    }
+    tora_free(arena);
+}
+
 // Linked list
 void free_linked_list(TORALinkedList *list)
 {
@@ -118,21 +198,11 @@ void queue_item(TORALinkedList **queue, TORALinkedList *list_item)
 {
     assert(list_item);
     
-    // If our queue is empty, assign this item as it's first occupant
-    if(*queue == NULL)
-    {
-        *queue = list_item;
-    }
-    // Otherwise iterate to the end of the queue and add it there
-    else
-    {
-        TORALinkedList *queue_item = *queue;
-        while(queue_item->next != NULL)
-        {
-            queue_item = queue_item->next;
-        }
-        queue_item->next = list_item;
-    }
+    // Queues are only ever drained as a whole, so rather than walking to the end of
+    // the queue (which made queueing each temporary value cost O(n)) items are
+    // pushed onto its front
+    list_item->next = *queue;
+    *queue = list_item;
     
     tora_retain(list_item);
 }
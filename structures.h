@@ -11,9 +11,9 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef enum {
-    TORAInstanceTypeToken,
     TORAInstanceTypeExpression,
     TORAInstanceTypeEnvironment,
     TORAInstanceTypeLinkedList,
@@ -35,6 +35,27 @@ struct TORALinkedList {
     TORALinkedList *next;
 };
 
+// Instances whose ref_count is TORA_REF_COUNT_IMMORTAL are owned by something
+// else (an arena, for instance), so retaining and releasing them has no effect
+#define TORA_REF_COUNT_IMMORTAL -1
+
+// Arenas hand out memory from large blocks with a bump pointer, and free every
+// allocation they've made in one go. Anything allocated from one must not be
+// passed to tora_free or released
+#define TORA_ARENA_BLOCK_SIZE (64 * 1024)
+
+typedef struct TORAArenaBlock TORAArenaBlock;
+struct TORAArenaBlock {
+    TORAArenaBlock *next;
+    size_t used;
+    size_t capacity;
+};
+
+typedef struct {
+    TORAArenaBlock *blocks;
+    uint64_t bytes_allocated;
+} TORAArena;
+
 extern int num_malloc;
 extern int num_free;
 
@@ -42,9 +63,18 @@ extern int num_free;
 void* tora_malloc(size_t size);
 void tora_free(void *p);
 char* tora_strcpy(char *str);
+char* tora_strncpy(const char *str, size_t length);
+uint32_t tora_strhash(const char *str);
+uint64_t tora_hash(const void *data, size_t length);
 void* tora_retain(void *ptr);
 void tora_release(void *ptr);
 
+// Arenas
+TORAArena *arena_create(void);
+void *arena_alloc(TORAArena *arena, size_t size);
+char *arena_strncpy(TORAArena *arena, const char *str, size_t length);
+void free_arena(TORAArena *arena);
+
 // Linked list
 void free_linked_list(TORALinkedList *list);
 uint64_t linked_list_length(TORALinkedList *list);
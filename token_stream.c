@@ -13,185 +13,364 @@
 #include "tora.h"
 
 // Token
-TORAToken *token_create(TORATokenType type, void* val, double numeric_val);
+void token_set_span(TORATokenStream *token_stream, TORAToken *token, TORATokenType type, uint64_t length);
+void token_clear(TORAToken *token);
 
-// Helpers
-char *char_as_string(char ch);
+// Buffered token streams
+void token_stream_lex_all(TORATokenStream *token_stream);
 
 // Token stream
-char *token_stream_read_while(TORATokenStream *token_stream, bool (*predicate)(char, char*));
 char *token_stream_read_escaped(TORATokenStream *token_stream, char end);
-TORAToken *token_stream_read_string(TORATokenStream *token_stream);
-TORAToken *token_stream_read_number(TORATokenStream *token_stream);
-TORAToken *token_stream_read_ident(TORATokenStream *token_stream);
+void token_stream_skip_whitespace(TORATokenStream *token_stream);
+void token_stream_read_string(TORATokenStream *token_stream, TORAToken *token);
+void token_stream_read_number(TORATokenStream *token_stream, TORAToken *token);
+void token_stream_read_ident(TORATokenStream *token_stream, TORAToken *token);
 void token_stream_skip_comment(TORATokenStream *token_stream);
-
-int num_tok;
+uint64_t token_stream_scan_run(TORATokenStream *token_stream, uint64_t from, const char *(*kernel)(const char *start, const char *end));
+const char *token_stream_skip_op(const char *start, const char *end);
+const char *token_stream_skip_hex_digits(const char *start, const char *end);
+void token_stream_retain_current(TORATokenStream *token_stream);
 
 TORATokenStream *token_stream_from_input(TORAInputStream *input_stream)
 {
-    num_tok = 0;
     TORATokenStream *token_stream = tora_malloc(sizeof(TORATokenStream));
     if(token_stream)
     {
-        token_stream->input_stream = input_stream;
-        token_stream->current_token = NULL;
+        token_stream_init(token_stream, input_stream);
     }
     
     return token_stream;
 }
-TORAToken *token_stream_read_next(TORATokenStream *token_stream)
+void token_stream_init(TORATokenStream *token_stream, TORAInputStream *input_stream)
+{
+    token_stream->input_stream = input_stream;
+    token_stream->has_current_token = false;
+    token_stream->has_peeked_token = false;
+    memset(&token_stream->current_token, 0, sizeof(TORAToken));
+    memset(&token_stream->peeked_token, 0, sizeof(TORAToken));
+    
+    token_stream->buffered = false;
+    token_stream->tokens = NULL;
+    token_stream->num_tokens = 0;
+    token_stream->token_index = 0;
+    
+    token_stream->speculative = false;
+    token_stream->failed = false;
+}
+TORATokenStream *token_stream_buffered_from_input(TORAInputStream *input_stream)
+{
+    TORATokenStream *token_stream = token_stream_from_input(input_stream);
+    if(token_stream)
+    {
+        token_stream->buffered = true;
+        token_stream_lex_all(token_stream);
+    }
+    
+    return token_stream;
+}
+// Lexes the entirety of our input into one contiguous token array
+void token_stream_lex_all(TORATokenStream *token_stream)
+{
+    TORAInputStream *input_stream = token_stream->input_stream;
+    
+    // Start off with a rough guess at the number of tokens we'll need based on
+    // the size of our input, and double it whenever we run out of space
+    uint64_t capacity = input_stream->length / 4 + 16;
+    TORAToken *tokens = tora_malloc(capacity * sizeof(TORAToken));
+    if(!tokens)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for token buffer");
+    }
+    
+    uint64_t num_tokens = 0;
+    while(true)
+    {
+        if(num_tokens == capacity)
+        {
+            capacity *= 2;
+            TORAToken *resized_tokens = realloc(tokens, capacity * sizeof(TORAToken));
+            if(!resized_tokens)
+            {
+                TORA_RUNTIME_EXCEPTION("Failed to realloc space for token buffer");
+            }
+            tokens = resized_tokens;
+        }
+        
+        tokens[num_tokens].flags = 0;
+        if(!token_stream_read_next(token_stream, &tokens[num_tokens]))
+        {
+            break;
+        }
+        num_tokens++;
+    }
+    
+    token_stream->tokens = tokens;
+    token_stream->num_tokens = num_tokens;
+    token_stream->token_index = 0;
+}
+bool token_stream_read_next(TORATokenStream *token_stream, TORAToken *token)
 {
     assert(token_stream);
     assert(token_stream->input_stream);
     
-    // Free our previously read token
-    free_item_from_queue(&token_queue);
-    
     TORAInputStream *input_stream = token_stream->input_stream;
+    token_clear(token);
     
-    // Read until we hit a non-whitespace character
-    char *whitespace = token_stream_read_while(token_stream, is_whitespace);
-    tora_free(whitespace);
+    // Read until we hit a non-whitespace, non-comment character
+    token_stream_skip_whitespace(token_stream);
+    while(!input_stream_eof(input_stream) && input_stream_peek(input_stream) == '#')
+    {
+        token_stream_skip_comment(token_stream);
+        token_stream_skip_whitespace(token_stream);
+    }
     
     if(input_stream_eof(input_stream))
     {
-        return NULL;
+        return false;
     }
     
+    token->line = (uint32_t)input_stream->line;
+    token->col = (uint32_t)input_stream->col;
+    
     char ch = input_stream_peek(input_stream);
-    if(ch == '#')
+    if(ch == '"')
     {
-        token_stream_skip_comment(token_stream);
-        return token_stream_read_next(token_stream);
+        token_stream_read_string(token_stream, token);
+        return true;
     }
-    else if(ch == '"')
+    else if(TORA_CHAR_IS(ch, TORA_CHAR_DIGIT))
     {
-        return token_stream_read_string(token_stream);
+        token_stream_read_number(token_stream, token);
+        return true;
     }
-    else if(is_digit(ch, NULL))
+    else if(TORA_CHAR_IS(ch, TORA_CHAR_ID_START))
     {
-        return token_stream_read_number(token_stream);
+        token_stream_read_ident(token_stream, token);
+        return true;
     }
-    else if(is_id_start(ch, NULL))
+    else if(TORA_CHAR_IS(ch, TORA_CHAR_PUNCTUATION))
     {
-        return token_stream_read_ident(token_stream);
+        token_set_span(token_stream, token, TORATokenTypePunctuation, 1);
+        token->kind = (uint8_t)punctuation_kind(ch);
+        return true;
     }
-    else if(is_punctuation(ch, NULL))
+    else if(TORA_CHAR_IS(ch, TORA_CHAR_OP))
     {
-        char *str = char_as_string(input_stream_next_char(input_stream));
-        if(str)
-        {
-            return token_create(TORATokenTypePunctuation, str, 0);
-        }
-        else
-        {
-            // TODO: handle error
-            return NULL;
-        }
+        uint64_t length = token_stream_scan_run(token_stream, 0, token_stream_skip_op);
+        token->kind = (uint8_t)operator_kind(input_stream_cursor(input_stream), (size_t)length);
+        token_set_span(token_stream, token, TORATokenTypeOperation, length);
+        return true;
     }
-    else if(is_op_char(ch, NULL))
+    
+    if(token_stream->speculative)
     {
-        return token_create(TORATokenTypeOperation, token_stream_read_while(token_stream, is_op_char), 0);
+        token_stream->failed = true;
+        return false;
     }
-    
     TORA_PARSER_EXCEPTION(token_stream->input_stream->line, token_stream->input_stream->col, "Invalid character: %c", ch);
     
-    return NULL;
+    return false;
 }
-void token_stream_skip_comment(TORATokenStream *token_stream)
+// Re-reads a token from the start of its text, typically to resolve a string
+// that was lexed speculatively. The input stream is left just past the token
+bool token_stream_relex(TORATokenStream *token_stream, TORAToken *token)
 {
-    char *value = token_stream_read_while(token_stream, is_not_newline);
-    tora_free(value);
+    TORAInputStream *input_stream = token_stream->input_stream;
+    
+    // String tokens begin after their opening "
+    input_stream->pos = token->type == TORATokenTypeStr ? token->offset - 1 : token->offset;
+    input_stream->line = token->line;
+    input_stream->col = token->col;
+    
+    token->flags = 0;
+    return token_stream_read_next(token_stream, token);
 }
-TORAToken *token_stream_read_number(TORATokenStream *token_stream)
+// Finds the length of a run of bytes beginning from bytes past the head position, as
+// measured by one of our scanning kernels. Streamed input may have more of the run
+// waiting to be read, so we keep refilling for as long as the run reaches the limit
+// of what's buffered. Once this returns the whole run (and the byte after it, unless
+// we've hit the end of our input) is buffered and can be addressed from the cursor
+uint64_t token_stream_scan_run(TORATokenStream *token_stream, uint64_t from, const char *(*kernel)(const char *start, const char *end))
 {
-    char *value = token_stream_read_while(token_stream, is_numeric_value);
-    if(value)
+    TORAInputStream *input_stream = token_stream->input_stream;
+    while(true)
     {
-        // Convert our string to a double representation
-        double numeric_value = 0;
-        sscanf(value, "%lf", &numeric_value);
-        
-        // Ditch the memory allocated while reading our string
-        tora_free(value);
+        const char *start = input_stream_cursor(input_stream) + from;
+        const char *limit = input_stream_limit(input_stream);
+        const char *end = kernel(start, limit);
         
-        // And finally return the numeric token
-        return token_create(TORATokenTypeNumeric, NULL, numeric_value);
+        from += (uint64_t)(end - start);
+        if(end < limit || !input_stream_refill(input_stream))
+        {
+            return from;
+        }
     }
-    
-    return NULL;
 }
-TORAToken *token_stream_read_string(TORATokenStream *token_stream)
+const char *token_stream_skip_op(const char *start, const char *end)
 {
-    return token_create(TORATokenTypeStr, token_stream_read_escaped(token_stream, '"'), 0);
+    while(start < end && TORA_CHAR_IS(*start, TORA_CHAR_OP)) start++;
+    return start;
 }
-TORAToken *token_stream_read_ident(TORATokenStream *token_stream)
+const char *token_stream_skip_hex_digits(const char *start, const char *end)
 {
-    char *id = token_stream_read_while(token_stream, is_id);
-    if(!id)
-    {
-        return NULL;
-    }
-    
-    bool keyword = is_keyword(id);
-    return token_create(keyword ? TORATokenTypeKeyword : TORATokenTypeVariable, id, 0);
+    while(start < end && (TORA_CHAR_IS(*start, TORA_CHAR_DIGIT) || ((*start | 0x20) >= 'a' && (*start | 0x20) <= 'f'))) start++;
+    return start;
 }
-char *token_stream_read_escaped(TORATokenStream *token_stream, char end)
+void token_stream_skip_comment(TORATokenStream *token_stream)
 {
-    assert(token_stream);
-    assert(token_stream->input_stream);
-    
-    bool escaped = false;
+    uint64_t length = token_stream_scan_run(token_stream, 0, tora_scan.find_newline);
+    input_stream_advance(token_stream->input_stream, length);
+}
+void token_stream_skip_whitespace(TORATokenStream *token_stream)
+{
+    uint64_t length = token_stream_scan_run(token_stream, 0, tora_scan.skip_whitespace);
+    input_stream_advance(token_stream->input_stream, length);
+}
+void token_stream_read_number(TORATokenStream *token_stream, TORAToken *token)
+{
+    TORAInputStream *input_stream = token_stream->input_stream;
     
-    size_t pos = 0;
-    size_t str_size = 256;
-    char *str = tora_malloc(str_size*sizeof(char));
-    if(!str)
+    // Hex literals are 0x followed by at least one hex digit
+    const char *start = input_stream_cursor(input_stream);
+    if(start[0] == '0' && input_stream_ensure(input_stream, 3))
     {
-        TORA_RUNTIME_EXCEPTION("Failed to malloc space for escaped string read");
+        start = input_stream_cursor(input_stream);
+        if((start[1] | 0x20) == 'x' && token_stream_skip_hex_digits(start + 2, start + 3) == start + 3)
+        {
+            uint64_t length = token_stream_scan_run(token_stream, 2, token_stream_skip_hex_digits);
+            token_set_span(token_stream, token, TORATokenTypeNumeric, length);
+            token->numeric_val = tora_parse_number(token_chars(token_stream, token), token->length);
+            return;
+        }
     }
     
+    // Otherwise numeric values are a run of digits containing at most one dot, optionally
+    // followed by an exponent. An e which isn't followed by digits isn't part of the number
+    uint64_t length = token_stream_scan_run(token_stream, 0, tora_scan.skip_digits);
+    const char *end = input_stream_cursor(input_stream) + length;
+    if(end < input_stream_limit(input_stream) && *end == '.')
+    {
+        length = token_stream_scan_run(token_stream, length + 1, tora_scan.skip_digits);
+        end = input_stream_cursor(input_stream) + length;
+    }
+    if(end < input_stream_limit(input_stream) && (*end | 0x20) == 'e' && input_stream_ensure(input_stream, length + 2))
+    {
+        end = input_stream_cursor(input_stream) + length;
+        uint64_t exponent_start = length + 1;
+        if((end[1] == '+' || end[1] == '-') && input_stream_ensure(input_stream, length + 3))
+        {
+            end = input_stream_cursor(input_stream) + length;
+            exponent_start++;
+        }
+        if(TORA_CHAR_IS(end[exponent_start - length], TORA_CHAR_DIGIT))
+        {
+            length = token_stream_scan_run(token_stream, exponent_start, tora_scan.skip_digits);
+        }
+    }
+    token_set_span(token_stream, token, TORATokenTypeNumeric, length);
+    token->numeric_val = tora_parse_number(token_chars(token_stream, token), token->length);
+}
+void token_stream_read_string(TORATokenStream *token_stream, TORAToken *token)
+{
     TORAInputStream *input_stream = token_stream->input_stream;
     
     // We need to move the input stream head position along by one, so we don't
     // get caught up on the opening " for this string
     input_stream_next_char(input_stream);
     
-    while(!input_stream_eof(input_stream))
+    // Strings without any escape sequences can be referenced in place, so
+    // we only need to build a copy if we hit a backslash before the closing "
+    uint64_t length = 0;
+    const char *end = NULL;
+    const char *limit = NULL;
+    do
     {
-        char ch = input_stream_next_char(input_stream);
-        if(escaped)
+        const char *start = input_stream_cursor(input_stream) + length;
+        limit = input_stream_limit(input_stream);
+        end = tora_scan.find_quote_or_escape(start, limit, '"');
+        length += (uint64_t)(end - start);
+    }
+    while(end == limit && input_stream_refill(input_stream));
+    
+    end = input_stream_cursor(input_stream) + length;
+    if(end == input_stream_limit(input_stream) || *end == '"')
+    {
+        token_set_span(token_stream, token, TORATokenTypeStr, length);
+        if(!input_stream_eof(input_stream))
         {
-            str[pos] = ch;
-            escaped = false;
-            pos++;
+            input_stream_next_char(input_stream);
         }
-        else if(ch == '\\')
+        else
         {
-            escaped = true;
+            token->flags |= TORA_TOKEN_FLAG_UNTERMINATED;
         }
-        else if(ch == end)
+    }
+    else if(token_stream->speculative)
+    {
+        // We can't allocate somewhere to put the unescaped value, so just find where
+        // the string ends and leave it to be resolved with token_stream_relex
+        token->type = TORATokenTypeStr;
+        token->flags |= TORA_TOKEN_FLAG_ESCAPED;
+        token->offset = input_stream->pos;
+        if(!token_stream_skip_string(token_stream))
         {
-            break;
+            token->flags |= TORA_TOKEN_FLAG_UNTERMINATED;
+            token->length = (uint32_t)(input_stream->pos - token->offset);
         }
         else
         {
-            str[pos] = ch;
-            pos++;
+            token->length = (uint32_t)(input_stream->pos - token->offset - 1);
+        }
+    }
+    else
+    {
+        token->type = TORATokenTypeStr;
+        token->flags |= TORA_TOKEN_FLAG_OWNS_VALUE;
+        token->offset = input_stream->pos;
+        token->val = token_stream_read_escaped(token_stream, '"');
+        token->length = (uint32_t)strlen(token->val);
+    }
+}
+void token_stream_read_ident(TORATokenStream *token_stream, TORAToken *token)
+{
+    uint64_t length = token_stream_scan_run(token_stream, 0, tora_scan.skip_ident);
+    
+    TORATokenKind kind = keyword_kind(input_stream_cursor(token_stream->input_stream), (size_t)length);
+    token_set_span(token_stream, token, kind != TORATokenKindNone ? TORATokenTypeKeyword : TORATokenTypeVariable, length);
+    token->kind = (uint8_t)kind;
+}
+// Moves past the remainder of a string literal, stepping over any escape sequences
+// without building its value. Returns false if our input ends before the closing "
+bool token_stream_skip_string(TORATokenStream *token_stream)
+{
+    TORAInputStream *input_stream = token_stream->input_stream;
+    while(!input_stream_eof(input_stream))
+    {
+        const char *start = input_stream_cursor(input_stream);
+        const char *limit = input_stream_limit(input_stream);
+        const char *end = tora_scan.find_quote_or_escape(start, limit, '"');
+        input_stream_advance(input_stream, (uint64_t)(end - start));
+        
+        // Running into the limit only means we need to refill and carry on scanning
+        if(end == limit || input_stream_eof(input_stream))
+        {
+            continue;
         }
         
-        if(pos >= str_size)
+        if(input_stream_next_char(input_stream) == '"')
         {
-            str_size *= 2;
-            realloc(str, str_size);
+            return true;
+        }
+        else if(!input_stream_eof(input_stream))
+        {
+            input_stream_next_char(input_stream);
         }
     }
-    
-    str[pos] = '\0';
-    return str;
+    return false;
 }
-char *token_stream_read_while(TORATokenStream *token_stream, bool (*predicate)(char, char*))
+// Reads the remainder of a string literal up to its terminator, resolving any
+// escape sequences along the way. Expects the opening " to have been consumed
+char *token_stream_read_escaped(TORATokenStream *token_stream, char end)
 {
     assert(token_stream);
     assert(token_stream->input_stream);
@@ -201,83 +380,188 @@ char *token_stream_read_while(TORATokenStream *token_stream, bool (*predicate)(c
     char *str = tora_malloc(str_size*sizeof(char));
     if(!str)
     {
-        TORA_RUNTIME_EXCEPTION("Failed to malloc space for input stream read");
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for escaped string read");
     }
     
     TORAInputStream *input_stream = token_stream->input_stream;
-    while(!input_stream_eof(input_stream) && (*predicate)(input_stream_peek(input_stream), str))
+    while(!input_stream_eof(input_stream))
     {
-        str[pos] = input_stream_next_char(input_stream);
-        pos++;
+        // Copy across everything up to the next terminator or escape in one go
+        const char *run_start = input_stream_cursor(input_stream);
+        const char *limit = input_stream_limit(input_stream);
+        const char *run_end = tora_scan.find_quote_or_escape(run_start, limit, end);
+        size_t run_length = (size_t)(run_end - run_start);
+        
+        // Leave room for the run, one escaped character and our null terminator
+        if(pos + run_length + 2 > str_size)
+        {
+            while(pos + run_length + 2 > str_size) str_size *= 2;
+            
+            char *resized_str = realloc(str, str_size);
+            if(!resized_str)
+            {
+                tora_free(str);
+                TORA_RUNTIME_EXCEPTION("Failed to realloc space for escaped string read");
+            }
+            str = resized_str;
+        }
+        
+        memcpy(str + pos, run_start, run_length);
+        pos += run_length;
+        input_stream_advance(input_stream, run_length);
         
-        if(pos >= str_size)
+        // Running into the limit of a streamed input doesn't mean we've found anything,
+        // so refill and carry on copying from where we stopped
+        if(run_end == limit || input_stream_eof(input_stream))
         {
-            str_size *= 2;
-            str = realloc(str, str_size);
+            continue;
+        }
+        
+        // We're now sitting on either our terminator or an escape character
+        char ch = input_stream_next_char(input_stream);
+        if(ch == end)
+        {
+            break;
+        }
+        else if(!input_stream_eof(input_stream))
+        {
+            str[pos] = input_stream_next_char(input_stream);
+            pos++;
         }
     }
-    str[pos] = '\0'; // null terminate our string
     
+    str[pos] = '\0';
     return str;
 }
 TORAToken *token_stream_next(TORATokenStream *token_stream)
 {
-    TORAToken *token = token_stream->current_token;
-    token_stream->current_token = NULL;
-    if(!token)
+    assert(token_stream);
+    
+    if(token_stream->buffered)
     {
-        token = token_stream_read_next(token_stream);
+        if(token_stream->token_index >= token_stream->num_tokens)
+        {
+            return NULL;
+        }
+        return &token_stream->tokens[token_stream->token_index++];
     }
     
-    return token;
+    // Whatever we handed out last time is no longer needed
+    token_clear(&token_stream->current_token);
+    token_stream->has_current_token = false;
+    
+    if(token_stream->has_peeked_token)
+    {
+        token_stream->current_token = token_stream->peeked_token;
+        token_stream->has_current_token = true;
+        token_stream->has_peeked_token = false;
+        
+        // Ownership of any unescaped value has moved across with the token
+        token_stream->peeked_token.flags = 0;
+    }
+    else
+    {
+        token_stream_retain_current(token_stream);
+        token_stream->has_current_token = token_stream_read_next(token_stream, &token_stream->current_token);
+        if(token_stream->has_current_token)
+        {
+            token_stream->num_tokens++;
+        }
+    }
+    
+    return token_stream->has_current_token ? &token_stream->current_token : NULL;
 }
 TORAToken *token_stream_peek(TORATokenStream *token_stream)
+{
+    return token_stream_peek_ahead(token_stream, 0);
+}
+// Looks distance tokens past the next one without consuming anything. Unbuffered
+// streams only hold a single token of look-ahead, so only support a distance of 0
+TORAToken *token_stream_peek_ahead(TORATokenStream *token_stream, uint64_t distance)
 {
     assert(token_stream);
     
-    if(!token_stream->current_token)
+    if(token_stream->buffered)
     {
-        token_stream->current_token = token_stream_read_next(token_stream);
+        uint64_t index = token_stream->token_index + distance;
+        return index < token_stream->num_tokens ? &token_stream->tokens[index] : NULL;
     }
-    return token_stream->current_token;
+    
+    assert(distance == 0);
+    if(!token_stream->has_peeked_token)
+    {
+        token_stream_retain_current(token_stream);
+        if(!token_stream_read_next(token_stream, &token_stream->peeked_token))
+        {
+            return NULL;
+        }
+        token_stream->has_peeked_token = true;
+        token_stream->num_tokens++;
+    }
+    return &token_stream->peeked_token;
 }
 bool token_stream_eof(TORATokenStream *token_stream)
 {
     return token_stream_peek(token_stream) == NULL;
 }
-
-// Token
-TORAToken *token_create(TORATokenType type, void* val, double numeric_val)
+// Unbuffered streams only hand out the current token and our look-ahead, so streamed
+// input is free to discard anything which comes before the current token's text
+void token_stream_retain_current(TORATokenStream *token_stream)
 {
-    TORAToken *token = tora_malloc(sizeof(TORAToken));
-    if(!token)
+    TORAInputStream *input_stream = token_stream->input_stream;
+    
+    uint64_t pos = input_stream->pos;
+    if(token_stream->has_current_token && !(token_stream->current_token.flags & TORA_TOKEN_FLAG_OWNS_VALUE))
     {
-        TORA_RUNTIME_EXCEPTION("Failed to malloc space for token");
+        pos = token_stream->current_token.offset;
     }
-    token->instance_type = TORAInstanceTypeToken;
-    token->ref_count = 0;
+    input_stream_retain_from(input_stream, pos);
+}
+
+// Token
+void token_set_span(TORATokenStream *token_stream, TORAToken *token, TORATokenType type, uint64_t length)
+{
+    TORAInputStream *input_stream = token_stream->input_stream;
     
     token->type = type;
-    token->val = val;
-    token->numeric_val = numeric_val;
-    
-    // Add this item to our token queue
-    queue_raw_item(&token_queue, NULL, token);
-   
-    num_tok++;
-    return token;
+    token->offset = input_stream->pos;
+    token->length = (uint32_t)length;
+    
+    input_stream_advance(input_stream, length);
 }
-void free_token(TORAToken *token)
+void token_clear(TORAToken *token)
 {
-    if(token->val)
+    if(token->flags & TORA_TOKEN_FLAG_OWNS_VALUE)
     {
         tora_free(token->val);
-        token->val = NULL;
     }
-    tora_free(token);
-    num_tok--;
+    token->type = TORATokenTypeStr;
+    token->flags = 0;
+    token->kind = TORATokenKindNone;
+    token->offset = 0;
+    token->length = 0;
+    token->line = 0;
+    token->col = 0;
+    token->numeric_val = 0;
+}
+const char *token_chars(TORATokenStream *token_stream, TORAToken *token)
+{
+    if(token->flags & TORA_TOKEN_FLAG_OWNS_VALUE)
+    {
+        return token->val;
+    }
+    TORAInputStream *input_stream = token_stream->input_stream;
+    return input_stream->contents + (token->offset - input_stream->base);
+}
+bool token_equals(TORATokenStream *token_stream, TORAToken *token, const char *cmp)
+{
+    return strlen(cmp) == token->length && memcmp(token_chars(token_stream, token), cmp, token->length) == 0;
+}
+char *token_copy_value(TORATokenStream *token_stream, TORAToken *token)
+{
+    return tora_strncpy(token_chars(token_stream, token), token->length);
 }
-void DEBUG_TOKEN(TORAToken *token)
+void DEBUG_TOKEN(TORATokenStream *token_stream, TORAToken *token)
 {
     char type_str[256];
     switch(token->type)
@@ -314,25 +598,23 @@ void DEBUG_TOKEN(TORAToken *token)
     }
     else
     {
-        printf("{\n\ttype: %s,\n\tval: %s\n}\n", type_str, (char*)token->val);
+        printf("{\n\ttype: %s,\n\tval: %.*s\n}\n", type_str, (int)token->length, token_chars(token_stream, token));
     }
 }
 
 // Helpers
 void free_token_stream(TORATokenStream *stream)
 {
-    drain_queue(token_queue);
-    tora_free(stream);
-}
-char *char_as_string(char ch)
-{
-    char *str = tora_malloc(2*sizeof(char));
-    if(!str)
+    token_clear(&stream->current_token);
+    token_clear(&stream->peeked_token);
+    
+    if(stream->tokens)
     {
-        TORA_RUNTIME_EXCEPTION("Faled to malloc space for char_as_string conversion");
+        for(uint64_t i = 0; i < stream->num_tokens; i++)
+        {
+            token_clear(&stream->tokens[i]);
+        }
+        tora_free(stream->tokens);
     }
-    
-    str[0] = ch;
-    str[1] = '\0';
-    return str;
-}
\ No newline at end of file
+    tora_free(stream);
+}
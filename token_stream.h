@@ -14,8 +14,6 @@
 
 #include "input_stream.h"
 
-extern int num_tok;
-
 typedef enum {
     TORATokenTypeStr,
     TORATokenTypeNumeric,
@@ -26,29 +24,122 @@ typedef enum {
     TORATokenTypeBoolean
 } TORATokenType;
 
-typedef struct {
-    TORAInstanceType instance_type;
-    int ref_count;
+// Keywords, punctuation and operators are classified by the lexer into one of
+// these kinds, so the parser can compare integers rather than token text. Any
+// other token (and any run of operator characters we don't recognise) is
+// TORATokenKindNone or TORATokenKindUnknownOperator respectively
+typedef enum {
+    TORATokenKindNone,
+    
+    // Keywords
+    TORATokenKindIf,
+    TORATokenKindElse,
+    TORATokenKindFunc,
+    TORATokenKindTrue,
+    TORATokenKindFalse,
+    TORATokenKindWhile,
+    TORATokenKindReturn,
+    
+    // Punctuation
+    TORATokenKindComma,
+    TORATokenKindSemicolon,
+    TORATokenKindColon,
+    TORATokenKindOpenParen,
+    TORATokenKindCloseParen,
+    TORATokenKindOpenBrace,
+    TORATokenKindCloseBrace,
+    TORATokenKindOpenBracket,
+    TORATokenKindCloseBracket,
+    
+    // Operators
+    TORATokenKindAssign,
+    TORATokenKindOr,
+    TORATokenKindAnd,
+    TORATokenKindLess,
+    TORATokenKindGreater,
+    TORATokenKindLessEqual,
+    TORATokenKindGreaterEqual,
+    TORATokenKindEqual,
+    TORATokenKindNotEqual,
+    TORATokenKindAdd,
+    TORATokenKindSubtract,
+    TORATokenKindMultiply,
+    TORATokenKindDivide,
+    TORATokenKindModulo,
+    TORATokenKindUnknownOperator,
     
-    TORATokenType type;
-    void *val;
-    double numeric_val;
-    bool bool_val;
+    TORATokenKindCount
+} TORATokenKind;
+
+// Set on string tokens whose unescaped value was copied into val
+#define TORA_TOKEN_FLAG_OWNS_VALUE (1 << 0)
+// Set on string tokens containing escape sequences which were lexed speculatively,
+// and so still describe their raw text rather than owning an unescaped value
+#define TORA_TOKEN_FLAG_ESCAPED (1 << 1)
+// Set on string tokens which reached the end of their input before a closing "
+#define TORA_TOKEN_FLAG_UNTERMINATED (1 << 2)
+
+// Tokens don't own their text. Instead they describe a slice (offset/length)
+// of their input stream's contents, and only string literals which contain
+// escape sequences carry a copy of their unescaped value in val. Numeric
+// tokens are converted up front, so the value shares space with val. kind
+// holds the TORATokenKind of keywords, punctuation and operators
+typedef struct {
+    uint8_t type;
+    uint8_t flags;
+    uint8_t kind;
+    uint32_t length;
+    uint32_t line;
+    uint32_t col;
+    uint64_t offset;
+    union {
+        char *val;
+        double numeric_val;
+    };
 } TORAToken;
 
+// A token stream either pulls tokens from its input one at a time, holding the
+// most recently consumed token and a single token of look-ahead by value, or is
+// buffered, in which case the whole input is lexed up front into a contiguous
+// array that the parser indexes into. A pointer returned by token_stream_next or
+// token_stream_peek is valid until the stream moves past it (unbuffered) or the
+// stream is freed (buffered). num_tokens counts every token lexed so far.
+// Speculative streams are used by lexing worker threads, and never throw or
+// allocate: errors set failed instead, and escaped strings are left as raw spans
 typedef struct {
     TORAInputStream *input_stream;
-    TORAToken *current_token;
+    TORAToken current_token;
+    TORAToken peeked_token;
+    bool has_current_token;
+    bool has_peeked_token;
+    
+    bool buffered;
+    TORAToken *tokens;
+    uint64_t num_tokens;
+    uint64_t token_index;
+    
+    bool speculative;
+    bool failed;
 } TORATokenStream;
 
 TORATokenStream *token_stream_from_input(TORAInputStream *stream);
-TORAToken *token_stream_read_next(TORATokenStream *token_stream);
+TORATokenStream *token_stream_buffered_from_input(TORAInputStream *stream);
+TORATokenStream *token_stream_parallel_from_input(TORAInputStream *stream, unsigned int num_threads);
+void token_stream_init(TORATokenStream *token_stream, TORAInputStream *input_stream);
+bool token_stream_read_next(TORATokenStream *token_stream, TORAToken *token);
+bool token_stream_relex(TORATokenStream *token_stream, TORAToken *token);
+bool token_stream_skip_string(TORATokenStream *token_stream);
 TORAToken *token_stream_next(TORATokenStream *token_stream);
 TORAToken *token_stream_peek(TORATokenStream *token_stream);
+TORAToken *token_stream_peek_ahead(TORATokenStream *token_stream, uint64_t distance);
 bool token_stream_eof(TORATokenStream *token_stream);
 void free_token_stream(TORATokenStream *stream);
-void free_token(TORAToken *token);
 
-void DEBUG_TOKEN(TORAToken *token);
+// Token helpers
+const char *token_chars(TORATokenStream *token_stream, TORAToken *token);
+bool token_equals(TORATokenStream *token_stream, TORAToken *token, const char *cmp);
+char *token_copy_value(TORATokenStream *token_stream, TORAToken *token);
+
+void DEBUG_TOKEN(TORATokenStream *token_stream, TORAToken *token);
 
 #endif /* parser_h */
@@ -0,0 +1,369 @@
+//
+//  token_stream_parallel.c
+//  TORA
+//
+//  Created by Nial on 18/10/2026.
+//  Copyright © 2026 Nial. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "tora.h"
+
+// Sources smaller than this are lexed serially, as there isn't enough work to share around
+#define TORA_PARALLEL_LEX_THRESHOLD (1024 * 1024)
+#define TORA_PARALLEL_LEX_MAX_THREADS 64
+
+// The tokens lexed from one chunk under one assumed starting state. Workers can't
+// use tora_malloc, so these are plain malloc'd and copied out when stitching
+typedef struct {
+    TORAToken *tokens;
+    uint64_t num_tokens;
+    uint64_t capacity;
+    bool failed;
+} TORALexedRun;
+
+// Chunks always begin just after a newline, so the only way a chunk can begin
+// anywhere other than between tokens is partway through a string literal (a
+// comment can't run past the end of its line). Each chunk is lexed under both
+// assumptions, and the previous chunk decides which of the two we keep
+typedef struct {
+    TORAInputStream *input_stream;
+    uint64_t start;
+    uint64_t end;
+    uint64_t newlines;
+    
+    TORALexedRun normal;
+    
+    // Lexed assuming the chunk begins inside a string. string_closed is false if that
+    // string runs the length of the chunk. As soon as this run starts a token at the same
+    // place as the normal run the two are identical from there on, so we stop and note
+    // where to pick the normal run back up
+    TORALexedRun in_string;
+    bool string_closed;
+    bool resynced;
+    uint64_t resync_index;
+} TORALexChunk;
+
+void *lex_chunk(void *arg);
+void lex_chunk_run(TORALexChunk *chunk, TORALexedRun *run, bool in_string);
+bool lexed_run_append(TORAToken **tokens, uint64_t *num_tokens, uint64_t *capacity, const TORAToken *source, uint64_t count, uint64_t line_base);
+bool stitch_chunks(TORATokenStream *token_stream, TORALexChunk *chunks, unsigned int num_chunks);
+
+// Lexes our input across a pool of worker threads into one contiguous token array,
+// producing exactly the same tokens as token_stream_buffered_from_input. Anything too
+// small to be worth splitting, streamed input, or any chunk that hits a lexing error is
+// handled serially instead, which also takes care of reporting the error. Passing
+// 0 for num_threads uses one thread per online CPU
+TORATokenStream *token_stream_parallel_from_input(TORAInputStream *input_stream, unsigned int num_threads)
+{
+    if(num_threads == 0)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = online > 0 ? (unsigned int)online : 1;
+    }
+    if(num_threads > TORA_PARALLEL_LEX_MAX_THREADS)
+    {
+        num_threads = TORA_PARALLEL_LEX_MAX_THREADS;
+    }
+    
+    if(num_threads < 2 || input_stream_is_streamed(input_stream) || input_stream->length < TORA_PARALLEL_LEX_THRESHOLD)
+    {
+        return token_stream_buffered_from_input(input_stream);
+    }
+    
+    // Split our contents into roughly even chunks, each ending just after a newline
+    TORALexChunk chunks[TORA_PARALLEL_LEX_MAX_THREADS];
+    unsigned int num_chunks = 0;
+    uint64_t chunk_start = 0;
+    for(unsigned int i = 1; i <= num_threads && chunk_start < input_stream->length; i++)
+    {
+        uint64_t chunk_end = input_stream->length;
+        if(i < num_threads)
+        {
+            uint64_t target = input_stream->length / num_threads * i;
+            if(target < chunk_start) target = chunk_start;
+            
+            const char *newline = tora_scan.find_newline(input_stream->contents + target, input_stream->contents + input_stream->length);
+            chunk_end = (uint64_t)(newline - input_stream->contents);
+            if(chunk_end < input_stream->length) chunk_end++;
+        }
+        
+        TORALexChunk *chunk = &chunks[num_chunks++];
+        memset(chunk, 0, sizeof(TORALexChunk));
+        chunk->input_stream = input_stream;
+        chunk->start = chunk_start;
+        chunk->end = chunk_end;
+        
+        chunk_start = chunk_end;
+    }
+    
+    // Hand every chunk but the first to a worker thread, and lex the first ourselves.
+    // If we can't start a thread for some chunk, we just lex it here as well
+    pthread_t threads[TORA_PARALLEL_LEX_MAX_THREADS];
+    bool started[TORA_PARALLEL_LEX_MAX_THREADS];
+    for(unsigned int i = 1; i < num_chunks; i++)
+    {
+        started[i] = pthread_create(&threads[i], NULL, lex_chunk, &chunks[i]) == 0;
+    }
+    lex_chunk(&chunks[0]);
+    for(unsigned int i = 1; i < num_chunks; i++)
+    {
+        if(started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+        else
+        {
+            lex_chunk(&chunks[i]);
+        }
+    }
+    
+    TORATokenStream *token_stream = token_stream_from_input(input_stream);
+    bool stitched = token_stream && stitch_chunks(token_stream, chunks, num_chunks);
+    
+    for(unsigned int i = 0; i < num_chunks; i++)
+    {
+        free(chunks[i].normal.tokens);
+        free(chunks[i].in_string.tokens);
+    }
+    
+    if(!token_stream)
+    {
+        return NULL;
+    }
+    if(!stitched)
+    {
+        free_token_stream(token_stream);
+        
+        input_stream->pos = 0;
+        input_stream->line = 1;
+        input_stream->col = 0;
+        return token_stream_buffered_from_input(input_stream);
+    }
+    
+    return token_stream;
+}
+
+// Workers
+void *lex_chunk(void *arg)
+{
+    TORALexChunk *chunk = (TORALexChunk *)arg;
+    
+    const char *last_newline = NULL;
+    const char *contents = chunk->input_stream->contents;
+    chunk->newlines = tora_scan.count_newlines(contents + chunk->start, contents + chunk->end, &last_newline);
+    
+    // The in-string run needs the normal run's tokens to know when it's back in step.
+    // Our first chunk always begins between tokens, so only needs the normal run
+    lex_chunk_run(chunk, &chunk->normal, false);
+    if(chunk->start > 0)
+    {
+        lex_chunk_run(chunk, &chunk->in_string, true);
+    }
+    
+    return NULL;
+}
+void lex_chunk_run(TORALexChunk *chunk, TORALexedRun *run, bool in_string)
+{
+    // Each run reads through its own view of the shared contents, limited to our chunk.
+    // Lines are counted from zero at the start of the chunk and offset when stitching
+    TORAInputStream view = *chunk->input_stream;
+    view.pos = chunk->start;
+    view.length = chunk->end;
+    view.line = 0;
+    view.col = 0;
+    
+    TORATokenStream token_stream;
+    token_stream_init(&token_stream, &view);
+    token_stream.speculative = true;
+    
+    if(in_string)
+    {
+        chunk->string_closed = token_stream_skip_string(&token_stream);
+        if(!chunk->string_closed)
+        {
+            return;
+        }
+    }
+    
+    uint64_t normal_index = 0;
+    while(true)
+    {
+        if(run->num_tokens == run->capacity)
+        {
+            uint64_t capacity = run->capacity ? run->capacity * 2 : (chunk->end - chunk->start) / 4 + 16;
+            TORAToken *resized_tokens = realloc(run->tokens, capacity * sizeof(TORAToken));
+            if(!resized_tokens)
+            {
+                run->failed = true;
+                return;
+            }
+            run->tokens = resized_tokens;
+            run->capacity = capacity;
+        }
+        
+        TORAToken *token = &run->tokens[run->num_tokens];
+        token->flags = 0;
+        if(!token_stream_read_next(&token_stream, token))
+        {
+            run->failed = token_stream.failed;
+            return;
+        }
+        
+        if(in_string)
+        {
+            const TORALexedRun *normal = &chunk->normal;
+            while(normal_index < normal->num_tokens && normal->tokens[normal_index].offset < token->offset)
+            {
+                normal_index++;
+            }
+            if(normal_index < normal->num_tokens && normal->tokens[normal_index].offset == token->offset && normal->tokens[normal_index].type == token->type)
+            {
+                chunk->resynced = true;
+                chunk->resync_index = normal_index;
+                return;
+            }
+        }
+        run->num_tokens++;
+    }
+}
+
+// Stitching
+// Joins the runs picked out by each chunk's starting state into a single token array,
+// resolving strings which span chunks or contain escape sequences on the way
+bool stitch_chunks(TORATokenStream *token_stream, TORALexChunk *chunks, unsigned int num_chunks)
+{
+    TORAInputStream *input_stream = token_stream->input_stream;
+    
+    uint64_t capacity = 16;
+    for(unsigned int i = 0; i < num_chunks; i++)
+    {
+        capacity += chunks[i].normal.num_tokens;
+    }
+    
+    token_stream->buffered = true;
+    token_stream->tokens = tora_malloc(capacity * sizeof(TORAToken));
+    if(!token_stream->tokens)
+    {
+        TORA_RUNTIME_EXCEPTION("Failed to malloc space for token buffer");
+    }
+    
+    TORAToken **tokens = &token_stream->tokens;
+    uint64_t *num_tokens = &token_stream->num_tokens;
+    
+    bool in_string = false;
+    TORAToken pending_string;
+    uint64_t line_base = 1;
+    for(unsigned int i = 0; i < num_chunks; i++)
+    {
+        TORALexChunk *chunk = &chunks[i];
+        uint64_t chunk_first_token = *num_tokens;
+        
+        if(in_string)
+        {
+            if(!chunk->string_closed)
+            {
+                line_base += chunk->newlines;
+                continue;
+            }
+            
+            // The string we carried over ends in this chunk, so read it in full from the source
+            if(!token_stream_relex(token_stream, &pending_string) ||
+               !lexed_run_append(tokens, num_tokens, &capacity, &pending_string, 1, 0) ||
+               !lexed_run_append(tokens, num_tokens, &capacity, chunk->in_string.tokens, chunk->in_string.num_tokens, line_base))
+            {
+                return false;
+            }
+            
+            if(chunk->resynced)
+            {
+                if(chunk->normal.failed || !lexed_run_append(tokens, num_tokens, &capacity, chunk->normal.tokens + chunk->resync_index, chunk->normal.num_tokens - chunk->resync_index, line_base))
+                {
+                    return false;
+                }
+            }
+            else if(chunk->in_string.failed)
+            {
+                return false;
+            }
+        }
+        else if(chunk->normal.failed || !lexed_run_append(tokens, num_tokens, &capacity, chunk->normal.tokens, chunk->normal.num_tokens, line_base))
+        {
+            return false;
+        }
+        
+        // A string left open at the end of this chunk carries on into the next one
+        in_string = false;
+        if(*num_tokens > chunk_first_token && i + 1 < num_chunks)
+        {
+            TORAToken *last_token = &(*tokens)[*num_tokens - 1];
+            if(last_token->type == TORATokenTypeStr && (last_token->flags & TORA_TOKEN_FLAG_UNTERMINATED))
+            {
+                pending_string = *last_token;
+                (*num_tokens)--;
+                in_string = true;
+            }
+        }
+        line_base += chunk->newlines;
+    }
+    
+    if(in_string)
+    {
+        if(!token_stream_relex(token_stream, &pending_string) || !lexed_run_append(tokens, num_tokens, &capacity, &pending_string, 1, 0))
+        {
+            return false;
+        }
+    }
+    
+    // Strings containing escape sequences can now be unescaped
+    for(uint64_t i = 0; i < *num_tokens; i++)
+    {
+        TORAToken *token = &(*tokens)[i];
+        if(token->flags & TORA_TOKEN_FLAG_ESCAPED)
+        {
+            token_stream_relex(token_stream, token);
+        }
+    }
+    
+    // Leave our input where the serial lexer would have done
+    const char *start = input_stream->contents;
+    const char *end = start + input_stream->length;
+    const char *last_newline = end;
+    while(last_newline > start && last_newline[-1] != '\n') last_newline--;
+    
+    input_stream->pos = input_stream->length;
+    input_stream->line = line_base;
+    input_stream->col = (uint64_t)(end - last_newline);
+    
+    return true;
+}
+bool lexed_run_append(TORAToken **tokens, uint64_t *num_tokens, uint64_t *capacity, const TORAToken *source, uint64_t count, uint64_t line_base)
+{
+    if(*num_tokens + count > *capacity)
+    {
+        uint64_t resized_capacity = *capacity * 2;
+        while(*num_tokens + count > resized_capacity) resized_capacity *= 2;
+        
+        TORAToken *resized_tokens = realloc(*tokens, resized_capacity * sizeof(TORAToken));
+        if(!resized_tokens)
+        {
+            TORA_RUNTIME_EXCEPTION("Failed to realloc space for token buffer");
+        }
+        *tokens = resized_tokens;
+        *capacity = resized_capacity;
+    }
+    
+    TORAToken *destination = *tokens + *num_tokens;
+    memcpy(destination, source, count * sizeof(TORAToken));
+    for(uint64_t i = 0; i < count; i++)
+    {
+        destination[i].line += (uint32_t)line_base;
+    }
+    *num_tokens += count;
+    
+    return true;
+}
@@ -16,98 +16,98 @@
 E4C_DEFINE_EXCEPTION(ParserException, "Parser Exception.", RuntimeException);
 E4C_DEFINE_EXCEPTION(InterpretterException, "Interpretter Exception.", RuntimeException);
 
-regex_t digit_regex;
-regex_t op_regex;
-regex_t id_regex;
-regex_t id_start_regex;
-regex_t punctuation_regex;
-regex_t whitespace_regex;
-regex_t not_newline_regex;
-
-TORALinkedList *token_queue = NULL;
 TORALinkedList *environment_queue = NULL;
 TORALinkedList *interpretter_queue = NULL;
 
-const char *tora_keywords[] = {
-    "if",
-    "else",
-    "func",
-    "true",
-    "false",
-    "while",
-    "return"
+// Each keyword sits in the slot given by TORA_KEYWORD_HASH, and every other slot is empty
+const TORAKeyword tora_keywords[TORA_KEYWORD_TABLE_SIZE] = {
+    [1]  = { "if", 2, TORATokenKindIf },
+    [4]  = { "while", 5, TORATokenKindWhile },
+    [5]  = { "else", 4, TORATokenKindElse },
+    [10] = { "true", 4, TORATokenKindTrue },
+    [12] = { "false", 5, TORATokenKindFalse },
+    [13] = { "return", 6, TORATokenKindReturn },
+    [15] = { "func", 4, TORATokenKindFunc }
 };
 
-const TORAOperatorPrecendence tora_operator_precedence[] = {
-    { "=", 1 },
-    { "||", 2 },
-    { "&&", 3 },
-    { "<", 7 }, { ">", 7 }, { "<=", 7 }, { ">=", 7 }, { "==", 7 }, { "!=", 7 },
-    { "+", 10 }, { "-", 10 },
-    { "*", 20 }, { "/", 20 }, { "%", 20 }, { ":", 20 }
+// Binary operator precedence, indexed by token kind. Anything that isn't a
+// binary operator has a precedence of 0 and is ignored by the parser
+const int tora_operator_precedence[TORATokenKindCount] = {
+    [TORATokenKindAssign] = 1,
+    [TORATokenKindOr] = 2,
+    [TORATokenKindAnd] = 3,
+    [TORATokenKindLess] = 7, [TORATokenKindGreater] = 7, [TORATokenKindLessEqual] = 7,
+    [TORATokenKindGreaterEqual] = 7, [TORATokenKindEqual] = 7, [TORATokenKindNotEqual] = 7,
+    [TORATokenKindAdd] = 10, [TORATokenKindSubtract] = 10,
+    [TORATokenKindMultiply] = 20, [TORATokenKindDivide] = 20, [TORATokenKindModulo] = 20, [TORATokenKindColon] = 20
 };
 
-// General
-bool tora_init()
-{
-    num_malloc = 0;
-    num_free = 0;
+const char *tora_token_kind_text[TORATokenKindCount] = {
+    [TORATokenKindNone] = "",
+    [TORATokenKindIf] = "if", [TORATokenKindElse] = "else", [TORATokenKindFunc] = "func",
+    [TORATokenKindTrue] = "true", [TORATokenKindFalse] = "false", [TORATokenKindWhile] = "while",
+    [TORATokenKindReturn] = "return",
     
-    int r = 0;
-    r = regcomp(&digit_regex, "[[:digit:]]", REG_EXTENDED|REG_ICASE);
-    if (r)
-    {
-        return false;
-    }
+    [TORATokenKindComma] = ",", [TORATokenKindSemicolon] = ";", [TORATokenKindColon] = ":",
+    [TORATokenKindOpenParen] = "(", [TORATokenKindCloseParen] = ")",
+    [TORATokenKindOpenBrace] = "{", [TORATokenKindCloseBrace] = "}",
+    [TORATokenKindOpenBracket] = "[", [TORATokenKindCloseBracket] = "]",
     
-    r = regcomp(&op_regex, "\\+|-|\\*|/|%|=|&|\\||<|>|!", REG_EXTENDED|REG_ICASE);
-    if (r)
-    {
-        return false;
-    }
+    [TORATokenKindAssign] = "=", [TORATokenKindOr] = "||", [TORATokenKindAnd] = "&&",
+    [TORATokenKindLess] = "<", [TORATokenKindGreater] = ">", [TORATokenKindLessEqual] = "<=",
+    [TORATokenKindGreaterEqual] = ">=", [TORATokenKindEqual] = "==", [TORATokenKindNotEqual] = "!=",
+    [TORATokenKindAdd] = "+", [TORATokenKindSubtract] = "-", [TORATokenKindMultiply] = "*",
+    [TORATokenKindDivide] = "/", [TORATokenKindModulo] = "%", [TORATokenKindUnknownOperator] = "?"
+};
+
+// Character classification table used by the lexer. Anything not listed
+// here (including '\0' and all non-ASCII bytes) belongs to no class
+#define D (TORA_CHAR_DIGIT|TORA_CHAR_ID)
+#define L (TORA_CHAR_ID_START|TORA_CHAR_ID)
+#define O (TORA_CHAR_OP)
+#define P (TORA_CHAR_PUNCTUATION)
+#define W (TORA_CHAR_WHITESPACE)
+const unsigned char tora_char_class[256] = {
+    ['\t'] = W, ['\n'] = W|TORA_CHAR_NEWLINE, [' '] = W,
     
-    r = regcomp(&punctuation_regex, ",|;|:|\\(|\\)|{|}|\\[|\\]", REG_EXTENDED|REG_ICASE);
-    if (r)
-    {
-        return false;
-    }
+    ['0'] = D, ['1'] = D, ['2'] = D, ['3'] = D, ['4'] = D,
+    ['5'] = D, ['6'] = D, ['7'] = D, ['8'] = D, ['9'] = D,
     
-    r = regcomp(&whitespace_regex, "[ \n\t]", REG_EXTENDED|REG_NEWLINE|REG_ICASE);
-    if (r)
-    {
-        return false;
-    }
+    ['a'] = L, ['b'] = L, ['c'] = L, ['d'] = L, ['e'] = L, ['f'] = L, ['g'] = L,
+    ['h'] = L, ['i'] = L, ['j'] = L, ['k'] = L, ['l'] = L, ['m'] = L, ['n'] = L,
+    ['o'] = L, ['p'] = L, ['q'] = L, ['r'] = L, ['s'] = L, ['t'] = L, ['u'] = L,
+    ['v'] = L, ['w'] = L, ['x'] = L, ['y'] = L, ['z'] = L,
+    ['A'] = L, ['B'] = L, ['C'] = L, ['D'] = L, ['E'] = L, ['F'] = L, ['G'] = L,
+    ['H'] = L, ['I'] = L, ['J'] = L, ['K'] = L, ['L'] = L, ['M'] = L, ['N'] = L,
+    ['O'] = L, ['P'] = L, ['Q'] = L, ['R'] = L, ['S'] = L, ['T'] = L, ['U'] = L,
+    ['V'] = L, ['W'] = L, ['X'] = L, ['Y'] = L, ['Z'] = L, ['_'] = L,
     
-    r = regcomp(&not_newline_regex, "[^\n]", REG_EXTENDED|REG_NEWLINE|REG_ICASE);
-    if (r)
-    {
-        return false;
-    }
+    ['+'] = O, ['-'] = O, ['*'] = O, ['/'] = O, ['%'] = O, ['='] = O,
+    ['&'] = O, ['|'] = O, ['<'] = O, ['>'] = O, ['!'] = O,
     
-    // A regex to match the beginning of variable names
-    r = regcomp(&id_start_regex, "[a-z_]", REG_EXTENDED|REG_ICASE);
-    if (r)
-    {
-        return false;
-    }
+    [','] = P, [';'] = P, [':'] = P, ['('] = P, [')'] = P,
+    ['{'] = P, ['}'] = P, ['['] = P, [']'] = P
+};
+#undef D
+#undef L
+#undef O
+#undef P
+#undef W
+
+// General
+bool tora_init()
+{
+    num_malloc = 0;
+    num_free = 0;
     
-    // A regex to match the end of variable names
-    r = regcomp(&id_regex, "[0-9]", REG_EXTENDED|REG_ICASE);
-    if (r)
-    {
-        return false;
-    }
-    return true;
+    // Pick the widest scanning kernels the running CPU supports
+    tora_scan_init();
+    
+    return tora_number_init();
 }
 void tora_shutdown()
 {
-    regfree(&digit_regex);
-    regfree(&op_regex);
-    regfree(&punctuation_regex);
-    regfree(&whitespace_regex);
-    regfree(&not_newline_regex);
-    regfree(&id_start_regex);
-    regfree(&id_regex);
+    tora_number_shutdown();
 }
 
 // String helpers
@@ -123,6 +123,40 @@ char *tora_strcpy(char *str)
     
     return NULL;
 }
+char *tora_strncpy(const char *str, size_t length)
+{
+    char *ret = tora_malloc(length+1);
+    if(ret != NULL)
+    {
+        memcpy(ret, str, length);
+        ret[length] = '\0';
+    }
+    
+    return ret;
+}
+// FNV-1a
+uint32_t tora_strhash(const char *str)
+{
+    uint32_t hash = 2166136261u;
+    for(const char *c = str; *c; c++)
+    {
+        hash ^= (unsigned char)*c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+// 64-bit FNV-1a, for hashing whole sources
+uint64_t tora_hash(const void *data, size_t length)
+{
+    const unsigned char *bytes = data;
+    uint64_t hash = 14695981039346656037ull;
+    for(size_t i = 0; i < length; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
 
 // Error handling
 void tora_parser_exception(uint64_t line, uint64_t col, char *msg)
@@ -169,100 +203,76 @@ char *tora_variadic_string(const char *fmt, ...)
 }
 
 // Syntax helpers
-int get_operator_precendence(char *cmp)
+int get_operator_precendence(TORATokenKind kind)
 {
-    int i = 0;
-    for(i = 0; i < TORA_NUM_OPERATORS; i++)
-    {
-        const TORAOperatorPrecendence current_operator = tora_operator_precedence[i];
-        if(!strcmp(current_operator.op, cmp))
-        {
-            return current_operator.level;
-        }
-    }
-    
-    return -1;
+    int level = tora_operator_precedence[kind];
+    return level ? level : -1;
 }
-bool is_keyword(char *keyword)
+TORATokenKind keyword_kind(const char *str, size_t length)
 {
-    int i = 0;
-    for(i = 0; i < TORA_NUM_KEYWORDS; i++)
+    // Our keywords are all between 2 and 6 characters long, so anything else can
+    // be ruled out before hashing. Any candidate only ever needs one comparison
+    if(length < 2 || length > 6)
     {
-        if(strlen(keyword) == strlen(tora_keywords[i]) && strncmp(keyword, tora_keywords[i], strlen(keyword)) == 0)
-        {
-            return true;
-        }
+        return TORATokenKindNone;
     }
     
-    return false;
+    const TORAKeyword *keyword = &tora_keywords[TORA_KEYWORD_HASH(str, length)];
+    if(keyword->length == length && memcmp(keyword->text, str, length) == 0)
+    {
+        return keyword->kind;
+    }
+    return TORATokenKindNone;
 }
-bool is_digit(char ch, char *value)
+TORATokenKind punctuation_kind(char ch)
 {
-    TORA_UNUSED(value);
-    char test_value[2] = {ch, '\0'};
-    int r = regexec(&digit_regex, test_value, 0, NULL, 0);
-    return r == 0;
+    switch(ch)
+    {
+        case ',': return TORATokenKindComma;
+        case ';': return TORATokenKindSemicolon;
+        case ':': return TORATokenKindColon;
+        case '(': return TORATokenKindOpenParen;
+        case ')': return TORATokenKindCloseParen;
+        case '{': return TORATokenKindOpenBrace;
+        case '}': return TORATokenKindCloseBrace;
+        case '[': return TORATokenKindOpenBracket;
+        case ']': return TORATokenKindCloseBracket;
+        default: return TORATokenKindNone;
+    }
 }
-bool is_numeric_value(char ch, char *value)
+TORATokenKind operator_kind(const char *str, size_t length)
 {
-    assert(ch);
-    assert(value);
-    
-    char test_value[2] = {ch, '\0'};
-    
-    // dots are valid for numeric values, but only if we don't already have one
-    if(test_value[0] == '.')
+    if(length == 1)
     {
-        char *existing_dot = strchr(value, '.');
-        if(existing_dot)
+        switch(str[0])
         {
-            return false;
+            case '=': return TORATokenKindAssign;
+            case '<': return TORATokenKindLess;
+            case '>': return TORATokenKindGreater;
+            case '+': return TORATokenKindAdd;
+            case '-': return TORATokenKindSubtract;
+            case '*': return TORATokenKindMultiply;
+            case '/': return TORATokenKindDivide;
+            case '%': return TORATokenKindModulo;
         }
-        return true;
     }
-    else
+    else if(length == 2 && str[1] == '=')
     {
-        return is_digit(ch, value);
+        switch(str[0])
+        {
+            case '<': return TORATokenKindLessEqual;
+            case '>': return TORATokenKindGreaterEqual;
+            case '=': return TORATokenKindEqual;
+            case '!': return TORATokenKindNotEqual;
+        }
     }
-}
-bool is_op_char(char ch, char *value)
-{
-    TORA_UNUSED(value);
-    char test_value[2] = {ch, '\0'};
-    int r = regexec(&op_regex, test_value, 0, NULL, 0);
-    return r == 0;
-}
-bool is_id_start(char ch, char *value)
-{
-    TORA_UNUSED(value);
-    char test_value[2] = {ch, '\0'};
-    int r = regexec(&id_start_regex, test_value, 0, NULL, 0);
-    return r == 0;
-}
-bool is_id(char ch, char *value)
-{
-    TORA_UNUSED(value);
-    char test_value[2] = {ch, '\0'};
-    return is_id_start(ch, value) || regexec(&id_regex, test_value, 0, NULL, 0) == 0;
-}
-bool is_punctuation(char ch, char *value)
-{
-    TORA_UNUSED(value);
-    char test_value[2] = {ch, '\0'};
-    int r = regexec(&punctuation_regex, test_value, 0, NULL, 0);
-    return r == 0;
-}
-bool is_whitespace(char ch, char *value)
-{
-    TORA_UNUSED(value);
-    char test_value[2] = {ch, '\0'};
-    int r = regexec(&whitespace_regex, test_value, 0, NULL, 0);
-    return r == 0;
-}
-bool is_not_newline(char ch, char *value)
-{
-    TORA_UNUSED(value);
-    char test_value[2] = {ch, '\0'};
-    int r = regexec(&not_newline_regex, test_value, 0, NULL, 0);
-    return r == 0;
+    else if(length == 2 && str[0] == str[1])
+    {
+        switch(str[0])
+        {
+            case '|': return TORATokenKindOr;
+            case '&': return TORATokenKindAnd;
+        }
+    }
+    return TORATokenKindUnknownOperator;
 }
\ No newline at end of file
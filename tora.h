@@ -11,16 +11,27 @@
 #define tora_h
 
 #include <stdbool.h>
-#include <regex.h>
+#include <stdint.h>
 #include <assert.h>
 
 #include "lib/e4c_lite.h"
 #include "structures.h"
 #include "input_stream.h"
+#include "scanner.h"
+#include "number.h"
 #include "token_stream.h"
 #include "parser.h"
+#include "builtins.h"
+#include "flat.h"
+#include "resolver.h"
+#include "optimiser.h"
+#include "image.h"
 #include "interpretter.h"
 
+// Programs cached by one version of the interpreter are never loaded by another, so
+// this needs bumping whenever a change alters the programs the front end produces
+#define TORA_VERSION "0.25.1"
+
 E4C_DECLARE_EXCEPTION(ParserException);
 E4C_DECLARE_EXCEPTION(InterpretterException);
 
@@ -29,29 +40,36 @@ E4C_DECLARE_EXCEPTION(InterpretterException);
 #define TORA_PARSER_EXCEPTION(line, pos, fmt, ...) tora_parser_exception(line, pos, tora_variadic_string(fmt, ##__VA_ARGS__))
 #define TORA_INTERPRETTER_EXCEPTION(fmt, ...) e4c_throw(&InterpretterException, __FILE__, __LINE__, tora_variadic_string(fmt, ##__VA_ARGS__))
 
-#define TORA_NUM_KEYWORDS 7
-#define TORA_NUM_OPERATORS 15
+// Character classes used by the lexer. Each entry in tora_char_class is a
+// bit mask of the classes that character belongs to
+#define TORA_CHAR_DIGIT       (1 << 0)
+#define TORA_CHAR_OP          (1 << 1)
+#define TORA_CHAR_ID_START    (1 << 2)
+#define TORA_CHAR_ID          (1 << 3)
+#define TORA_CHAR_PUNCTUATION (1 << 4)
+#define TORA_CHAR_WHITESPACE  (1 << 5)
+#define TORA_CHAR_NEWLINE     (1 << 6)
+#define TORA_CHAR_IS(ch, mask) ((tora_char_class[(unsigned char)(ch)] & (mask)) != 0)
+
+// Keywords are found with a perfect hash of their length and first two
+// characters, giving each of them its own slot in tora_keywords
+#define TORA_KEYWORD_TABLE_SIZE 16
+#define TORA_KEYWORD_HASH(str, length) (((length) + (unsigned char)(str)[0] + (unsigned char)(str)[1]) & (TORA_KEYWORD_TABLE_SIZE - 1))
 
 typedef struct {
-    char *op;
-    int level;
-} TORAOperatorPrecendence;
+    const char *text;
+    size_t length;
+    TORATokenKind kind;
+} TORAKeyword;
 
-extern const TORAOperatorPrecendence tora_operator_precedence[];
-extern const char *tora_keywords[];
+extern const TORAKeyword tora_keywords[TORA_KEYWORD_TABLE_SIZE];
+extern const int tora_operator_precedence[TORATokenKindCount];
+extern const char *tora_token_kind_text[TORATokenKindCount];
+extern const unsigned char tora_char_class[256];
 
-extern TORALinkedList *token_queue;
 extern TORALinkedList *environment_queue;
 extern TORALinkedList *interpretter_queue;
 
-extern regex_t digit_regex;
-extern regex_t op_regex;
-extern regex_t id_regex;
-extern regex_t id_start_regex;
-extern regex_t punctuation_regex;
-extern regex_t whitespace_regex;
-extern regex_t not_newline_regex;
-
 bool tora_init();
 void tora_shutdown();
 
@@ -60,15 +78,9 @@ void tora_parser_exception(uint64_t line, uint64_t col, char *msg);
 char *tora_variadic_string(const char *fmt, ...);
 
 // Helpers
-int get_operator_precendence(char *cmp);
-bool is_keyword(char *keyword);
-bool is_digit(char ch, char *value);
-bool is_numeric_value(char ch, char *value);
-bool is_id_start(char ch, char *value);
-bool is_id(char ch, char *value);
-bool is_op_char(char ch, char *value);
-bool is_punctuation(char ch, char *value);
-bool is_whitespace(char ch, char *value);
-bool is_not_newline(char ch, char *value);
+int get_operator_precendence(TORATokenKind kind);
+TORATokenKind keyword_kind(const char *str, size_t length);
+TORATokenKind punctuation_kind(char ch);
+TORATokenKind operator_kind(const char *str, size_t length);
 
 #endif /* tora_h */